@@ -0,0 +1,322 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+// Microbenchmark of the multipart body scanning: the line based state
+// machine previously used by the request parser is compared with the
+// BoundaryScanner implementations supported by the CPU, on a text and
+// on a binary payload fed in chunks as large as the receive buffer.
+
+/* -------------------------------------------------------------------------- */
+
+#include "BoundaryScanner.h"
+#include "StrUtils.h"
+#include "config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+const std::string boundary = "------------------------490a4289f7afa3e5";
+
+/* -------------------------------------------------------------------------- */
+
+//! Line based scanner, as formerly implemented by the request parser
+class LineScanner
+{
+public:
+   LineScanner(const std::string &boundary, size_t capacity) : _boundary(boundary)
+   {
+      _body.reserve(capacity);
+   }
+
+   void feed(const char *data, size_t size)
+   {
+      for (size_t pos = 0; pos < size && !_complete; ++pos)
+      {
+         const char c = data[pos];
+
+         _line += c;
+
+         feedCrLfFsm(c);
+
+         if (!_receivingBody && _crlfSt == CrLfSeq::LF2)
+         {
+            if (_line == "\r\n")
+               _line.clear();
+
+            _receivingBody = _boundaryMarker;
+         }
+
+         if ((_crlfSt == CrLfSeq::LF1 || _crlfSt == CrLfSeq::LF2) && !_line.empty())
+            processLine();
+      }
+   }
+
+   std::string takeBody()
+   {
+      if (_boundaryMarker && _body.size() >= 2)
+         _body.resize(_body.size() - 2);
+
+      return std::move(_body);
+   }
+
+private:
+   enum class CrLfSeq
+   {
+      CR1,
+      LF1,
+      CR2,
+      LF2,
+      IDLE
+   };
+
+   void feedCrLfFsm(char c) noexcept
+   {
+      switch (_crlfSt)
+      {
+      case CrLfSeq::CR1:
+         _crlfSt = (c == '\n') ? CrLfSeq::LF1 : (c == '\r') ? CrLfSeq::CR1 : CrLfSeq::IDLE;
+         break;
+      case CrLfSeq::LF1:
+         _crlfSt = (c == '\r') ? CrLfSeq::CR2 : CrLfSeq::IDLE;
+         break;
+      case CrLfSeq::CR2:
+         _crlfSt = (c == '\n') ? CrLfSeq::LF2 : (c == '\r') ? CrLfSeq::CR1 : CrLfSeq::IDLE;
+         break;
+      case CrLfSeq::IDLE:
+      default:
+         _crlfSt = (c == '\r') ? CrLfSeq::CR1 : CrLfSeq::IDLE;
+         break;
+      }
+   }
+
+   void processLine()
+   {
+      const std::string boundaryBegin = "--" + _boundary;
+      const std::string boundaryEnd = boundaryBegin + "--";
+
+      const std::string trimmedLine = StrUtils::trim(_line);
+
+      if (!_receivingBody && !_boundaryMarker && trimmedLine == boundaryBegin)
+      {
+         _boundaryMarker = true;
+      }
+      else if (_receivingBody && _boundaryMarker && trimmedLine == boundaryEnd)
+      {
+         _receivingBody = false;
+         _complete = true;
+         _line.clear();
+      }
+
+      if (!_line.empty())
+      {
+         if (_receivingBody)
+            _body += _line;
+
+         _line.clear();
+      }
+   }
+
+   std::string _boundary;
+   CrLfSeq _crlfSt = CrLfSeq::IDLE;
+   std::string _line;
+   std::string _body;
+   bool _receivingBody = false;
+   bool _boundaryMarker = false;
+   bool _complete = false;
+};
+
+/* -------------------------------------------------------------------------- */
+
+//! Minimal multipart consumer built on top of BoundaryScanner
+class SpanScanner
+{
+public:
+   SpanScanner(const std::string &boundary, size_t capacity, BoundaryScanner::Isa isa)
+   {
+      _body.reserve(capacity);
+      _scanner.reset(boundary);
+      _scanner.setIsa(isa);
+   }
+
+   void feed(const char *data, size_t size)
+   {
+      size_t pos = 0;
+
+      while (pos < size && _delimiters < 2)
+      {
+         // Part headers: skipped up to the empty line
+         if (_delimiters == 1 && !_inContent)
+         {
+            const std::string_view rest(data + pos, size - pos);
+            const size_t end = rest.find("\r\n\r\n");
+
+            // Headers are never split in this benchmark
+            pos += end + 4;
+            _inContent = true;
+            _scanner.resume();
+            continue;
+         }
+
+         const auto res = _scanner.scan(data + pos, size - pos);
+
+         if (_inContent)
+         {
+            _body.append(res.carry.data(), res.carry.size());
+            _body.append(res.span.data(), res.span.size());
+         }
+
+         pos += res.consumed;
+
+         if (res.found)
+            ++_delimiters;
+      }
+   }
+
+   std::string takeBody()
+   {
+      return std::move(_body);
+   }
+
+private:
+   BoundaryScanner _scanner;
+   std::string _body;
+   int _delimiters = 0;
+   bool _inContent = false;
+};
+
+/* -------------------------------------------------------------------------- */
+
+std::string makeTextPayload(size_t size)
+{
+   std::mt19937 rng(1);
+   std::string payload;
+
+   while (payload.size() < size)
+   {
+      const size_t len = 20 + rng() % 100;
+
+      for (size_t i = 0; i < len; ++i)
+         payload += char('a' + rng() % 26);
+
+      payload += "\r\n";
+   }
+
+   return payload;
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::string makeBinaryPayload(size_t size)
+{
+   std::mt19937 rng(2);
+   std::string payload(size, '\0');
+
+   for (auto &c : payload)
+      c = char(rng());
+
+   return payload;
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::string makeBody(const std::string &payload)
+{
+   return "--" + boundary + "\r\n" +
+          "Content-Disposition: form-data; name=\"file\"; filename=\"f.bin\"\r\n" +
+          "Content-Type: application/octet-stream\r\n\r\n" +
+          payload + "\r\n--" + boundary + "--\r\n";
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <typename Scanner>
+void run(const char *name, const std::string &body,
+         const std::string &payload, int rounds, Scanner make)
+{
+   const auto begin = std::chrono::steady_clock::now();
+   bool ok = true;
+
+   for (int i = 0; i < rounds; ++i)
+   {
+      auto scanner = make();
+
+      for (size_t pos = 0; pos < body.size(); pos += HTTPSRV_RX_BUF_SIZE)
+      {
+         const size_t len = std::min(size_t(HTTPSRV_RX_BUF_SIZE), body.size() - pos);
+         scanner.feed(body.data() + pos, len);
+      }
+
+      ok = ok && scanner.takeBody() == payload;
+   }
+
+   const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - begin;
+
+   const double mbps = double(body.size()) * rounds / elapsed.count() / 1e6;
+
+   std::cout << "  " << std::left << std::setw(8) << name
+             << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+             << mbps << " MB/s" << (ok ? "" : "  (MISMATCH)") << std::endl;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void bench(const char *title, const std::string &payload, int rounds)
+{
+   const std::string body = makeBody(payload);
+
+   std::cout << title << " payload, " << payload.size() << " bytes x "
+             << rounds << std::endl;
+
+   run("lines", body, payload, rounds, [&] { return LineScanner(boundary, body.size()); });
+
+   for (auto isa : {BoundaryScanner::Isa::scalar,
+                    BoundaryScanner::Isa::sse2,
+                    BoundaryScanner::Isa::avx2})
+   {
+      if (!BoundaryScanner::isSupported(isa))
+         continue;
+
+      run(BoundaryScanner::getIsaName(isa), body, payload, rounds,
+          [&] { return SpanScanner(boundary, body.size(), isa); });
+   }
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+   const size_t size = argc > 1 ? size_t(std::atol(argv[1])) : 0x1000000;
+   const int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+
+   if (size == 0 || rounds <= 0)
+   {
+      std::cerr << "Usage: " << argv[0] << " [payload size] [rounds]" << std::endl;
+      return 1;
+   }
+
+   bench("Text", makeTextPayload(size), rounds);
+   bench("Binary", makeBinaryPayload(size), rounds);
+
+   return 0;
+}
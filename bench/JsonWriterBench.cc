@@ -0,0 +1,202 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+// Microbenchmark of the /files listing serialization: the records formerly
+// built by FilenameMap::jsonStat (stringstreams, gmtime and put_time) and
+// concatenated into the listing are compared with the ones written by
+// JsonWriter, on a listing of synthetic file metadata (100k entries by
+// default). The two outputs are checked to be the same byte by byte.
+
+/* -------------------------------------------------------------------------- */
+
+#include "FilenameMap.h"
+#include "JsonWriter.h"
+#include "StrUtils.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+//! Metadata of a file, as returned by stat()
+struct FileInfo
+{
+   std::string id;
+   std::string name;
+   uint64_t size;
+   std::time_t accessTime;
+   unsigned accessTimeUs;
+};
+
+/* -------------------------------------------------------------------------- */
+
+//! Implementation formerly provided by FilenameMap
+namespace Legacy
+{
+
+void jsonStat(
+   const FileInfo &info,
+   std::string &jsonOutput,
+   const std::string &beginl,
+   const std::string &endl)
+{
+   std::tm bt = *gmtime(&info.accessTime);
+
+   std::ostringstream ossTS;
+
+   // YYYY-MM-DDTHH:MM:SS.uuuuuuZ
+   ossTS << std::put_time(&bt, "%Y-%m-%dT%H:%M:%S");
+   ossTS << '.' << std::setfill('0') << std::setw(6) << info.accessTimeUs << "Z";
+
+   std::stringstream oss;
+   oss << beginl << "{" << std::endl;
+   oss << beginl << "  \"id\": \"" << info.id << "\"," << std::endl;
+   oss << beginl << "  \"name\": \"" << StrUtils::escapeJson(info.name) << "\"," << std::endl;
+   oss << beginl << "  \"size\": " << info.size << "," << std::endl;
+   oss << beginl << "  \"timestamp\": \"" << ossTS.str() << "\"" << std::endl;
+   oss << beginl << "}" << endl;
+
+   jsonOutput = oss.str();
+}
+
+void makeListing(const std::vector<FileInfo> &files, std::string &json)
+{
+   json = "[\n";
+
+   for (const auto &info : files)
+   {
+      std::string jsonEntry;
+      jsonStat(info, jsonEntry, "  ", ",\n");
+      json += jsonEntry;
+   }
+
+   // remove last ",\n" sequence
+   if (json.size() > 2)
+      json.resize(json.size() - 2);
+
+   json += "\n]\n";
+}
+
+} // namespace Legacy
+
+/* -------------------------------------------------------------------------- */
+
+void makeListing(const std::vector<FileInfo> &files, std::pmr::string &json)
+{
+   json.clear();
+
+   JsonWriter writer(json);
+   writer.beginArray();
+
+   for (const auto &info : files)
+   {
+      FilenameMap::writeJsonRecord(
+         writer, info.id, info.name, info.size, info.accessTime, info.accessTimeUs);
+   }
+
+   writer.endArray();
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::vector<FileInfo> makeFiles(size_t count)
+{
+   std::mt19937_64 prng(42);
+   std::vector<FileInfo> files(count);
+
+   for (size_t i = 0; i < count; ++i)
+   {
+      FileInfo &info = files[i];
+
+      std::ostringstream id;
+      id << std::hex << std::setfill('0');
+
+      for (int j = 0; j < 4; ++j)
+         id << std::setw(16) << prng();
+
+      info.id = id.str();
+
+      // One name in a hundred needs to be escaped
+      info.name = "report-" + std::to_string(i) +
+         (i % 100 ? "_final.txt" : " \"draft\"\t.txt");
+
+      info.size = prng() % 100000000;
+      info.accessTime = std::time_t(prng() % 2000000000);
+      info.accessTimeUs = unsigned(prng() % 1000000);
+   }
+
+   return files;
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <typename F>
+double run(int rounds, F f)
+{
+   const auto begin = std::chrono::steady_clock::now();
+
+   for (int i = 0; i < rounds; ++i)
+      f();
+
+   const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - begin;
+
+   return elapsed.count() / rounds;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+   const int entries = argc > 1 ? std::atoi(argv[1]) : 100000;
+   const int rounds = argc > 2 ? std::atoi(argv[2]) : 10;
+
+   if (entries <= 0 || rounds <= 0)
+   {
+      std::cerr << "Usage: " << argv[0] << " [entries] [rounds]" << std::endl;
+      return 1;
+   }
+
+   const auto files = makeFiles(size_t(entries));
+
+   std::string expected;
+   std::pmr::string json;
+
+   const double legacyMs = run(rounds, [&] { Legacy::makeListing(files, expected); });
+
+   // The buffer is reused across rounds, as the arena of a connection
+   const double writerMs = run(rounds, [&] { makeListing(files, json); });
+
+   const bool ok = std::string_view(json) == std::string_view(expected);
+
+   std::cout << "Listing of " << entries << " files, " << json.size() << " bytes"
+             << std::endl
+             << std::fixed << std::setprecision(2)
+             << "  " << std::left << std::setw(24) << "stringstream"
+             << std::right << std::setw(10) << legacyMs << " ms" << std::endl
+             << "  " << std::left << std::setw(24) << "JsonWriter"
+             << std::right << std::setw(10) << writerMs << " ms"
+             << (ok ? "" : "  (MISMATCH)") << std::endl;
+
+   return ok ? 0 : 1;
+}
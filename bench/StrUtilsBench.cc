@@ -0,0 +1,254 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+// Microbenchmark of the string utilities on the request hot path: the
+// copying implementations formerly provided by StrUtils are compared with
+// the string_view tokenizer, the view-returning trim and the JSON escape
+// appending to a caller-provided buffer.
+
+/* -------------------------------------------------------------------------- */
+
+#include "StrUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+//! Implementations formerly provided by StrUtils
+namespace Legacy
+{
+
+bool splitLineInTokens(
+   const std::string &line,
+   std::vector<std::string> &tokens, const std::string &sep)
+{
+   if (line.empty() || line.size() < sep.size())
+      return false;
+
+   std::string subline = line;
+
+   while (!subline.empty())
+   {
+      size_t pos = subline.find(sep);
+
+      if (pos == std::string::npos)
+      {
+         tokens.push_back(subline);
+         return true;
+      }
+
+      tokens.push_back(subline.substr(0, pos));
+
+      size_t off = pos + sep.size();
+
+      subline = subline.substr(off, subline.size() - off);
+   }
+
+   return true;
+}
+
+std::string trim(const std::string &str)
+{
+   const auto strBegin = str.find_first_not_of(" \t\r\n");
+   if (strBegin == std::string::npos)
+      return "";
+
+   const auto strEnd = str.find_last_not_of(" \t\r\n");
+
+   return str.substr(strBegin, strEnd - strBegin + 1);
+}
+
+void removeLastCharIf(std::string &s, char c)
+{
+   while (!s.empty() && s.c_str()[s.size() - 1] == c)
+      s = s.substr(0, s.size() - 1);
+}
+
+std::string escapeJson(const std::string &str)
+{
+   std::ostringstream ss;
+
+   for (const auto &ch : str)
+   {
+      switch (ch)
+      {
+      case '\\': ss << "\\\\"; break;
+      case '"': ss << "\\\""; break;
+      case '\t': ss << "\\t"; break;
+      case '\r': ss << "\\r"; break;
+      case '\b': ss << "\\b"; break;
+      case '\n': ss << "\\n"; break;
+      case '\f': ss << "\\f"; break;
+      default:
+         if ('\x00' <= ch && ch <= '\x1f')
+         {
+            ss << "\\u"
+               << std::hex << std::setw(4)
+               << std::setfill('0') << int(ch);
+         }
+         else
+         {
+            ss << ch;
+         }
+      }
+   }
+
+   return ss.str();
+}
+
+} // namespace Legacy
+
+/* -------------------------------------------------------------------------- */
+
+// Keeps the compiler from dropping the work measured
+volatile size_t sink = 0;
+
+template <typename F>
+void run(const char *name, int rounds, bool ok, F f)
+{
+   const auto begin = std::chrono::steady_clock::now();
+
+   for (int i = 0; i < rounds; ++i)
+      sink = sink + f();
+
+   const std::chrono::duration<double, std::nano> elapsed =
+      std::chrono::steady_clock::now() - begin;
+
+   std::cout << "  " << std::left << std::setw(24) << name
+             << std::right << std::setw(10) << std::fixed << std::setprecision(1)
+             << elapsed.count() / rounds << " ns/op"
+             << (ok ? "" : "  (MISMATCH)") << std::endl;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void benchTokenize(const std::string &line, const std::string &sep, int rounds)
+{
+   std::cout << "Tokenize, " << line.size() << " bytes" << std::endl;
+
+   std::vector<std::string> expected;
+   Legacy::splitLineInTokens(line, expected, sep);
+
+   std::vector<std::string_view> views;
+
+   for (const auto token : StrUtils::tokenize(line, sep))
+      views.push_back(token);
+
+   const bool ok = views.size() == expected.size() &&
+      std::equal(views.begin(), views.end(), expected.begin());
+
+   run("splitLineInTokens", rounds, true, [&] {
+      std::vector<std::string> tokens;
+      Legacy::splitLineInTokens(line, tokens, sep);
+      return tokens.size();
+   });
+
+   run("tokenize", rounds, ok, [&] {
+      size_t size = 0;
+
+      for (const auto token : StrUtils::tokenize(line, sep))
+         size += token.size();
+
+      return size;
+   });
+}
+
+/* -------------------------------------------------------------------------- */
+
+void benchTrim(const std::string &str, int rounds)
+{
+   std::cout << "Trim, " << str.size() << " bytes" << std::endl;
+
+   const bool ok = StrUtils::trimView(str) == Legacy::trim(str);
+
+   run("trim", rounds, true, [&] { return Legacy::trim(str).size(); });
+   run("trimView", rounds, ok, [&] { return StrUtils::trimView(str).size(); });
+
+   std::string padded = str + std::string(16, '\n');
+   std::string expected = padded;
+   Legacy::removeLastCharIf(expected, '\n');
+
+   std::string removed = padded;
+   StrUtils::removeLastCharIf(removed, '\n');
+
+   run("removeLastCharIf (old)", rounds, true, [&] {
+      std::string s = padded;
+      Legacy::removeLastCharIf(s, '\n');
+      return s.size();
+   });
+
+   run("removeLastCharIf", rounds, removed == expected, [&] {
+      std::string s = padded;
+      StrUtils::removeLastCharIf(s, '\n');
+      return s.size();
+   });
+}
+
+/* -------------------------------------------------------------------------- */
+
+void benchEscape(const char *title, const std::string &str, int rounds)
+{
+   std::cout << "Escape JSON, " << title << ", " << str.size() << " bytes" << std::endl;
+
+   std::string buffer;
+   StrUtils::escapeJson(str, buffer);
+
+   const bool ok = buffer == Legacy::escapeJson(str);
+
+   run("ostringstream", rounds, true, [&] { return Legacy::escapeJson(str).size(); });
+
+   run("append to buffer", rounds, ok, [&] {
+      buffer.clear();
+      StrUtils::escapeJson(str, buffer);
+      return buffer.size();
+   });
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+   const int rounds = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+   if (rounds <= 0)
+   {
+      std::cerr << "Usage: " << argv[0] << " [rounds]" << std::endl;
+      return 1;
+   }
+
+   benchTokenize("form-data; name=\"file\"; filename=\"File02.txt\"", "; ", rounds);
+
+   std::string longLine;
+
+   for (int i = 0; i < 64; ++i)
+      longLine += "token" + std::to_string(i) + ", ";
+
+   benchTokenize(longLine, ", ", rounds / 10);
+
+   benchTrim("  multipart/form-data; boundary=------490a4289f7afa3e5 \r\n", rounds);
+
+   benchEscape("plain", "report-2020-01-01_final.version.txt", rounds);
+   benchEscape("to escape", "StrangeName \\!@#$%^&*()'\"\\,><~\t.txt", rounds);
+
+   return 0;
+}
@@ -20,6 +20,7 @@
 #include "StrUtils.h"
 #include "TcpSocket.h"
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <iostream>
@@ -82,6 +83,24 @@ private:
 
    int _mrufilesN = MRUFILES_DEF_N;
 
+   HttpServer::IoModel _ioModel = HttpServer::IoModel::threadPerConnection;
+   int _eventLoops = 0;
+   int _workerThreads = HTTPSRV_WORKER_THREADS_DEF;
+   int _workerQueueSize = HTTPSRV_WORKER_QUEUE_DEF;
+   int _acceptors = 1;
+   bool _cpuAffinity = false;
+   int _keepAliveTimeout = HTTPSRV_KEEPALIVE_TIMEOUT_DEF;
+   int _keepAliveMaxRequests = HTTPSRV_KEEPALIVE_REQUESTS_DEF;
+   int _pipelineDepth = HTTPSRV_PIPELINE_DEPTH_DEF;
+   int _maxConnections = HTTPSRV_MAX_CONNECTIONS_DEF;
+   int _maxZipJobs = HTTPSRV_MAX_ZIP_JOBS_DEF;
+   int _maxChunkSize = HTTPSRV_MAX_CHUNK_SIZE_DEF;
+   int _maxTrailerSize = HTTPSRV_MAX_TRAILER_SIZE_DEF;
+   int _maxHeadSize = HTTPSRV_MAX_HEAD_SIZE_DEF;
+   int _maxHeaders = HTTPSRV_MAX_HEADERS_DEF;
+   int64_t _maxBodySize = HTTPSRV_MAX_BODY_SIZE_DEF;
+   int _endpointBudget[LoadShedder::endpointCount] = {};
+
    FileRepository::Handle _FileRepository;
 };
 
@@ -0,0 +1,158 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __BOUNDARY_SCANNER_H__
+#define __BOUNDARY_SCANNER_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Streaming scanner of multipart bodies.
+ * It searches the delimiter "\r\n--<boundary>" of the body parts in the
+ * data received chunk by chunk, including a delimiter split across
+ * chunks, and yields the content preceding it as spans of the chunks
+ * themselves, so the content is never copied or split in lines.
+ * Only the few bytes at the end of a chunk which might start a delimiter
+ * are retained until the next chunk tells whether they do.
+ * The search is vectorized (SSE2 or AVX2, selected at runtime according
+ * to the CPU features) with a scalar fallback.
+ */
+class BoundaryScanner
+{
+public:
+   //! Implementations of the delimiter search
+   enum class Isa
+   {
+      scalar,
+      sse2,
+      avx2
+   };
+
+   //! Outcome of a scan
+   struct Result
+   {
+      //! Content retained from the previous chunk, preceding span
+      std::string_view carry;
+
+      //! Content of the chunk scanned
+      std::string_view span;
+
+      //! Bytes of the chunk consumed, including the delimiter if found
+      size_t consumed = 0;
+
+      //! True if the delimiter has been found
+      bool found = false;
+   };
+
+   BoundaryScanner() = default;
+   BoundaryScanner(const BoundaryScanner &) = delete;
+   BoundaryScanner &operator=(const BoundaryScanner &) = delete;
+
+   /**
+    * Starts scanning a new multipart body.
+    * The body is considered preceded by a line terminator, so that
+    * the delimiter of the first part is recognized even if it begins
+    * the body.
+    *
+    * @param boundary is the boundary parameter of the content type
+    */
+   void reset(std::string_view boundary);
+
+   /**
+    * Scans the next chunk of the body.
+    * Once the delimiter has been found the scan stops, until
+    * resume() is called.
+    *
+    * @param data points the chunk
+    * @param size is the size of the chunk
+    * @return the content preceding the delimiter (or preceding any
+    *         byte retained) and the number of bytes consumed
+    */
+   Result scan(const char *data, size_t size);
+
+   /**
+    * Goes on searching the next delimiter
+    */
+   void resume() noexcept
+   {
+      _found = false;
+   }
+
+   /**
+    * Returns the delimiter searched, including its leading CRLF
+    */
+   const std::string &getDelimiter() const noexcept
+   {
+      return _delimiter;
+   }
+
+   /**
+    * Forces the search implementation (e.g. for benchmarking).
+    * An implementation not supported by the CPU is ignored.
+    */
+   void setIsa(Isa isa) noexcept;
+
+   /**
+    * Returns the search implementation in use
+    */
+   Isa getIsa() const noexcept
+   {
+      return _isa;
+   }
+
+   /**
+    * Returns the best implementation supported by the CPU
+    */
+   static Isa detectIsa() noexcept;
+
+   /**
+    * Returns true if the CPU supports a given implementation
+    */
+   static bool isSupported(Isa isa) noexcept;
+
+   /**
+    * Returns the name of an implementation
+    */
+   static const char *getIsaName(Isa isa) noexcept;
+
+   /**
+    * Searches a string within a buffer
+    *
+    * @param isa is the implementation to use, supported by the CPU
+    * @param data points the buffer
+    * @param size is the size of the buffer
+    * @param needle is the string to search, made of two bytes at least
+    * @return the position of the first occurrence or size if not found
+    */
+   static size_t find(
+      Isa isa,
+      const char *data,
+      size_t size,
+      std::string_view needle) noexcept;
+
+private:
+   size_t findPartial(const char *data, size_t size) const noexcept;
+
+   std::string _delimiter;
+   std::string _pending;
+   std::string _window;
+   Isa _isa = detectIsa();
+   bool _found = false;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // __BOUNDARY_SCANNER_H__
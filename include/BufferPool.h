@@ -0,0 +1,131 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __BUFFER_POOL_H__
+#define __BUFFER_POOL_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Thread-safe pool of fixed-size I/O buffers.
+ * Buffers are allocated on demand and given back to the pool when
+ * released, so they can be reused instead of being allocated for each
+ * I/O operation. At most a given number of free buffers is retained.
+ */
+class BufferPool
+{
+public:
+   /**
+    * Buffer borrowed from a pool, given back on destruction
+    */
+   class Buffer
+   {
+   public:
+      Buffer() = default;
+      Buffer(const Buffer &) = delete;
+      Buffer &operator=(const Buffer &) = delete;
+
+      Buffer(Buffer &&other) noexcept
+          : _pool(other._pool), _data(std::move(other._data))
+      {
+         other._pool = nullptr;
+      }
+
+      ~Buffer()
+      {
+         if (_pool && _data)
+            _pool->release(std::move(_data));
+      }
+
+      /**
+       * Returns the buffer address, or nullptr if no memory was available
+       */
+      char *data() const noexcept
+      {
+         return _data.get();
+      }
+
+      /**
+       * Returns the buffer size in bytes
+       */
+      size_t size() const noexcept
+      {
+         return _pool && _data ? _pool->getBufferSize() : 0;
+      }
+
+      explicit operator bool() const noexcept
+      {
+         return _data != nullptr;
+      }
+
+   private:
+      friend class BufferPool;
+
+      BufferPool *_pool = nullptr;
+      std::unique_ptr<char[]> _data;
+
+      Buffer(BufferPool *pool, std::unique_ptr<char[]> data) noexcept
+          : _pool(pool), _data(std::move(data))
+      {
+      }
+   };
+
+   /**
+    * Constructs a pool
+    *
+    * @param bufferSize is the size of each buffer
+    * @param maxFreeBuffers is the max number of free buffers retained
+    */
+   BufferPool(size_t bufferSize, size_t maxFreeBuffers) noexcept
+       : _bufferSize(bufferSize), _maxFreeBuffers(maxFreeBuffers)
+   {
+   }
+
+   BufferPool(const BufferPool &) = delete;
+   BufferPool &operator=(const BufferPool &) = delete;
+
+   /**
+    * Returns the pool of buffers used for file transmissions
+    */
+   static BufferPool &getFileChunkPool();
+
+   /**
+    * Returns the size of each buffer
+    */
+   size_t getBufferSize() const noexcept
+   {
+      return _bufferSize;
+   }
+
+   /**
+    * Borrows a buffer from the pool, allocating it if no free buffer
+    * is available
+    */
+   Buffer acquire();
+
+private:
+   std::mutex _mtx;
+   std::vector<std::unique_ptr<char[]>> _freeBuffers;
+   size_t _bufferSize = 0;
+   size_t _maxFreeBuffers = 0;
+
+   void release(std::unique_ptr<char[]> data);
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__BUFFER_POOL_H__
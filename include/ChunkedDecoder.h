@@ -0,0 +1,114 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __CHUNKED_DECODER_H__
+#define __CHUNKED_DECODER_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "config.h"
+
+#include <cstddef>
+#include <string_view>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Streaming decoder of a body sent with the chunked transfer coding
+ * (RFC 7230, section 4.1).
+ * Data can be fed in chunks of any size: the chunk data are yielded as
+ * spans of the data fed, never copied, while chunk sizes, extensions
+ * and trailer fields are consumed.
+ * Chunk extensions and trailer fields are ignored, but their size is
+ * bounded.
+ */
+class ChunkedDecoder
+{
+public:
+   //! Limits enforced while decoding, zero meaning unlimited
+   struct Limits
+   {
+      //! Max size of a single chunk
+      size_t maxChunkSize = HTTPSRV_MAX_CHUNK_SIZE_DEF;
+
+      //! Max size of the trailer section, zero meaning that no
+      //! trailer field is accepted
+      size_t maxTrailerSize = HTTPSRV_MAX_TRAILER_SIZE_DEF;
+   };
+
+   ChunkedDecoder() = default;
+   ChunkedDecoder(const ChunkedDecoder &) = delete;
+   ChunkedDecoder &operator=(const ChunkedDecoder &) = delete;
+
+   /**
+    * Starts decoding a new body
+    *
+    * @param limits are the limits to enforce
+    */
+   void reset(const Limits &limits) noexcept;
+
+   /**
+    * Decodes the next data received.
+    * It stops at the end of any chunk data, so it has to be called
+    * again until all the data has been consumed.
+    *
+    * @param data points the data received
+    * @param size is the number of bytes received
+    * @param content is set to the chunk data decoded, if any
+    * @return the number of bytes consumed
+    */
+   size_t decode(const char *data, size_t size, std::string_view &content) noexcept;
+
+   /**
+    * Returns true once the last chunk and the trailer section have
+    * been decoded
+    */
+   bool isDone() const noexcept
+   {
+      return _state == State::done;
+   }
+
+   /**
+    * Returns true if the body is malformed or exceeds the limits
+    */
+   bool isError() const noexcept
+   {
+      return _state == State::error;
+   }
+
+private:
+   enum class State
+   {
+      size,
+      extension,
+      sizeLf,
+      data,
+      dataCr,
+      dataLf,
+      trailer,
+      trailerLine,
+      trailerLf,
+      done,
+      error
+   };
+
+   void feed(char c) noexcept;
+
+   Limits _limits;
+   State _state = State::size;
+   size_t _chunkSize = 0;
+   size_t _digits = 0;
+   size_t _extensionSize = 0;
+   size_t _trailerSize = 0;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__CHUNKED_DECODER_H__
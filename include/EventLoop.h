@@ -0,0 +1,134 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __EVENT_LOOP_H__
+#define __EVENT_LOOP_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "TcpListener.h"
+#include "HttpSession.h"
+#include "IoChannel.h"
+#include "FileRepository.h"
+#include "ResumeQueue.h"
+#include "TimerWheel.h"
+
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Edge-triggered epoll reactor.
+ * An event loop multiplexes on a single thread the listening socket and
+ * all the connections it has accepted, driving each HTTP session as a
+ * state machine (@see HttpSession::onIoEvent()).
+ * Several event loops can share the same listener: each of them accepts
+ * and owns its own connections.
+ * A connection showing no activity for longer than the idle timeout of
+ * its session is closed: the timers are kept in a hashed timer wheel, so
+ * an idle connection costs no thread and just a few bytes.
+ * The blocking business logic of the sessions is run by the worker pool
+ * of the session configuration, if any: a session is resumed by its
+ * loop once its job is done, and meanwhile it is not closed as idle.
+ */
+class EventLoop
+{
+public:
+   using Handle = std::unique_ptr<EventLoop>;
+
+   EventLoop(const EventLoop &) = delete;
+   EventLoop &operator=(const EventLoop &) = delete;
+   ~EventLoop();
+
+   /**
+    * Returns true if event loops are supported on this platform
+    */
+   static bool isSupported() noexcept;
+
+   /**
+    * Creates a new event loop serving connections accepted
+    * by a given (non-blocking) listener.
+    *
+    * @param listener is the listening socket
+    * @param verboseModeOn enables logging
+    * @param loggerOStream is the output stream used for logging
+    * @param fileRepository is the repository handle
+    * @param sessionConfig is the configuration of the sessions
+    * @return the event loop handle or nullptr in case of failure
+    */
+   static Handle create(
+       TcpListener &listener,
+       bool verboseModeOn,
+       std::ostream &loggerOStream,
+       FileRepository::Handle fileRepository,
+       const HttpSession::Config &sessionConfig);
+
+   /**
+    * Runs the event loop. This function is blocking for the caller.
+    *
+    * @return false if operation failed, otherwise the function
+    * doesn't return ever
+    */
+   bool run();
+
+private:
+   TcpListener &_listener;
+   bool _verboseModeOn = false;
+   std::ostream &_logger;
+   FileRepository::Handle _fileRepository;
+   HttpSession::Config _sessionConfig;
+   int _epollFd = -1;
+
+   struct Connection
+   {
+      HttpSession::Handle session;
+      std::unique_ptr<SocketIoChannel> channel;
+      TimerWheel::Timer idleTimer;
+   };
+
+   TimerWheel _timerWheel;
+   std::unordered_map<int, Connection> _connections;
+
+   // Sessions whose job has been run by the worker pool
+   ResumeQueue _resumeQueue;
+   std::vector<HttpSession::Handle> _resumed;
+
+   EventLoop(
+       TcpListener &listener,
+       bool verboseModeOn,
+       std::ostream &loggerOStream,
+       FileRepository::Handle fileRepository,
+       const HttpSession::Config &sessionConfig)
+       :
+       _listener(listener),
+       _verboseModeOn(verboseModeOn),
+       _logger(loggerOStream),
+       _fileRepository(fileRepository),
+       _sessionConfig(sessionConfig),
+       _timerWheel(
+          HTTPSRV_TIMER_WHEEL_SLOTS, 
+          std::chrono::milliseconds(HTTPSRV_TIMER_WHEEL_TICK_MS))
+   {
+   }
+
+   bool init();
+   void acceptConnections();
+   void closeSession(int sd);
+   void restartIdleTimer(int sd, Connection &connection);
+   void drive(int sd, Connection &connection);
+   void resumeSessions();
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__EVENT_LOOP_H__
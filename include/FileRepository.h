@@ -12,6 +12,7 @@
 #define __FILE_REPOSITORY_H__
 
 #include "FileUtils.h"
+#include "FileUpload.h"
 #include "FilenameMap.h"
 
 #include <map>
@@ -52,7 +53,7 @@ public:
     * @param json containing the mru files list
     * @return true if operation succeded, false otherwise
     */
-   bool createJsonMruFilesList(std::string& json);
+   bool createJsonMruFilesList(std::pmr::string& json);
 
    /**
     * Creates a list of mru filenames
@@ -97,7 +98,25 @@ public:
    bool store(
       const std::string& fileName,
       const std::string& fileContent,
-      std::string& json);
+      std::pmr::string& json);
+
+   /**
+    * Starts the upload of a file, whose content is written to a
+    * temporary file of the repository as it is received
+    *
+    * @param fileName is name of file to be stored
+    * @return the upload handle or nullptr in case of failure
+    */
+   FileUpload::Handle createUpload(const std::string& fileName);
+
+   /**
+    * Stores a file whose upload is complete.
+    *
+    * @param upload is the upload completed
+    * @param json is JSON formatted returned status
+    * @return true if operation succeded, false otherwise
+    */
+   bool store(FileUpload& upload, std::pmr::string& json);
 
    /**
     * Create a zip archive containing MRU files of repository
@@ -108,7 +127,7 @@ public:
     * @return true if operation succeded, false otherwise
     */
    bool createMruFilesZip(
-      std::string& zipFileName,
+      std::pmr::string& zipFileName,
       FileUtils::DirectoryRipper::Handle& zipCleaner);
 
    enum class createFileZipRes {
@@ -128,8 +147,8 @@ public:
     * @return one of possible error code defined in createFileZipRes
     */
    createFileZipRes createFileZip(
-      const std::string id, 
-      std::string& zipFileName, 
+      std::string_view id, 
+      std::pmr::string& zipFileName, 
       FileUtils::DirectoryRipper::Handle& zipCleaner);
 
 private:
@@ -147,9 +166,11 @@ private:
 
    bool init();
    bool createTimeOrderedFilesList(TimeOrderedFileList& list);
+   bool storeJsonStat(const fs::path& filePath, const std::string& fileName, std::pmr::string& json);
 
 private:
    std::string _path;
+   std::string _uploadPath;
    int _mrufilesN;
    FilenameMap _filenameMap;
 };
@@ -0,0 +1,105 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __FILE_UPLOAD_H__
+#define __FILE_UPLOAD_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * File being uploaded.
+ * The content is written, as it is received, to a temporary file which
+ * is renamed to its final name once the upload is complete, so that a
+ * partial upload is never visible; an upload abandoned (e.g. because
+ * the connection dropped) is removed along with its temporary file.
+ */
+class FileUpload
+{
+public:
+   using Handle = std::unique_ptr<FileUpload>;
+
+   FileUpload(const FileUpload &) = delete;
+   FileUpload &operator=(const FileUpload &) = delete;
+
+   /**
+    * Creates a new upload, creating its temporary file
+    *
+    * @param fileName is the name of the file uploaded
+    * @param tmpPath is the path of the temporary file, not existing yet
+    * @return the handle or nullptr in case of failure
+    */
+   static Handle create(const std::string &fileName, const std::string &tmpPath);
+
+   /**
+    * Removes the temporary file, if the upload has not been committed
+    */
+   ~FileUpload();
+
+   /**
+    * Appends data to the temporary file.
+    * After a failure any further data is discarded.
+    *
+    * @return false if the data could not be written
+    */
+   bool write(const char *data, size_t size) noexcept;
+
+   /**
+    * Completes the upload, renaming the temporary file
+    *
+    * @param path is the final path of the file
+    * @return false if any data could not be written or
+    *         the file could not be renamed
+    */
+   bool commit(const std::string &path);
+
+   /**
+    * Returns the name of the file uploaded
+    */
+   const std::string &getFileName() const noexcept
+   {
+      return _fileName;
+   }
+
+   /**
+    * Returns the number of bytes written so far
+    */
+   uint64_t getSize() const noexcept
+   {
+      return _size;
+   }
+
+private:
+   FileUpload(const std::string &fileName, const std::string &tmpPath, int fd) :
+      _fileName(fileName),
+      _tmpPath(tmpPath),
+      _fd(fd)
+   {
+   }
+
+   void close() noexcept;
+
+   std::string _fileName;
+   std::string _tmpPath;
+   int _fd = -1;
+   uint64_t _size = 0;
+   bool _failed = false;
+   bool _committed = false;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__FILE_UPLOAD_H__
@@ -38,13 +38,14 @@ bool createTemporaryDir(fs::path &path);
  *
  * @param fileName String containing the path of existing file
  * @param dateTime is updated with the file timestamp
- * @param ext is updated with File extension or "." if there is no any
+ * @param ext is updated with File extension or "." if there is no any,
+ *        referring to fileName
  * @return true if operation successfully completed, false otherwise
  */
 bool fileStat(
-    const std::string &fileName,
+    const char *fileName,
     std::string &dateTime,
-    std::string &ext,
+    std::string_view &ext,
     size_t &fsize);
 
 /**
@@ -55,7 +56,7 @@ bool fileStat(
    *      to create a new file if not already existant
  * @return true if operation successfully completed, false otherwise
  */
-bool touch(const std::string &fileName, bool createNewIfNotExists = false);
+bool touch(const char *fileName, bool createNewIfNotExists = false);
 
 /**
  * Gets full path of existing file or directory
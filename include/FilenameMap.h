@@ -13,7 +13,12 @@
 
 /* -------------------------------------------------------------------------- */
 
-#include <unordered_map>
+#include "JsonWriter.h"
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory_resource>
 #include <mutex> // For std::unique_lock
 #include <shared_mutex>
 #include <string>
@@ -27,6 +32,8 @@
 class FilenameMap
 {
 public:
+   class Listing;
+
    FilenameMap() = default;
 
    FilenameMap(const FilenameMap &) = delete;
@@ -80,16 +87,18 @@ public:
     *
     * @param id searched id
     * @param fileName is assigned with corrispondent filename if found
+    *        (e.g. a std::string or a std::pmr::string)
     * @return true if id is found, false otherwise
     */
-   bool locked_search(const std::string &id, std::string &fileName) const
+   template <typename String>
+   bool locked_search(std::string_view id, String &fileName) const
    {
       std::shared_lock lock(_mtx);
 
       auto it = _data.find(id);
       if (it != _data.end())
       {
-         fileName = it->second;
+         fileName.assign(it->second);
          return true;
       }
       return false;
@@ -110,7 +119,7 @@ public:
     * @param json is the JSON formatted text matching the cache content
     * @return true if operation successfully completed, false otherwise
     */
-   bool locked_updateMakeJson(const std::string &path, std::string &json);
+   bool locked_updateMakeJson(const std::string &path, std::pmr::string &json);
 
    /**
      * Returns file attributes of fileName formatted using a JSON record of
@@ -120,16 +129,32 @@ public:
      *
      * @param filePath String containing complete file path and name
      * @param fileName String containing the name to generate JSON output
-     * @param jsonOutput output JSON string
+     * @param json is the writer the record is written to
      * @return true if operation successfully completed, false otherwise
      */
    static bool jsonStat(
-       const std::string &filePath,
-       const std::string &fileName,
-       const std::string &id,
-       std::string &jsonOutput,
-       const std::string &beginl = "",
-       const std::string &endl = "\n");
+       const char *filePath,
+       std::string_view fileName,
+       std::string_view id,
+       JsonWriter &json);
+
+   /**
+     * Writes the JSON record of a file (@see jsonStat())
+     *
+     * @param json is the writer the record is written to
+     * @param id is the file id
+     * @param fileName is the file name
+     * @param size is the size in bytes of file
+     * @param accessTime is the access time of file (since the epoch)
+     * @param accessTimeUs is the fraction of second of accessTime
+     */
+   static void writeJsonRecord(
+       JsonWriter &json,
+       std::string_view id,
+       std::string_view fileName,
+       uint64_t size,
+       std::time_t accessTime,
+       unsigned accessTimeUs);
 
    /**
     * Touches an existing file and returns a related stat in JSON format
@@ -140,15 +165,89 @@ public:
     */
    bool jsonStatFileUpdateTS(
        const std::string &path,
-       const std::string &id,
-       std::string &json,
+       std::string_view id,
+       std::pmr::string &json,
        bool updateTimeStamp);
 private:
-   using data_t = std::unordered_map<std::string, std::string>;
+   // Ordered by a transparent comparator, so that an id can be looked
+   // up as a view (e.g. of a request URI) without copying it
+   using data_t = std::map<std::string, std::string, std::less<>>;
    mutable std::shared_mutex _mtx;
    data_t _data;
 };
 
 /* -------------------------------------------------------------------------- */
 
+/**
+ * JSON listing of the repository, the same produced by
+ * FilenameMap::locked_updateMakeJson(), written a few records at a time
+ * while the directory is scanned: its text can be sent and discarded
+ * before the rest is written.
+ * The map is updated with the files listed once the listing is over.
+ */
+class FilenameMap::Listing
+{
+public:
+   /**
+    * Starts listing the repository
+    *
+    * @param map is the map updated by the listing
+    * @param path of repository
+    * @param memory is the memory resource of the text
+    */
+   Listing(
+      FilenameMap &map,
+      const std::string &path,
+      std::pmr::memory_resource *memory = std::pmr::get_default_resource());
+
+   Listing(const Listing &) = delete;
+   Listing &operator=(const Listing &) = delete;
+
+   /**
+    * Returns false if the repository cannot be scanned
+    */
+   bool isValid() const noexcept
+   {
+      return _valid;
+   }
+
+   /**
+    * Returns true once the whole listing has been written
+    */
+   bool isOver() const noexcept
+   {
+      return _over;
+   }
+
+   /**
+    * Appends the records of further files to the text, until it holds
+    * at least a given number of bytes or the listing is over
+    *
+    * @param size is the number of bytes
+    */
+   void write(size_t size);
+
+   /**
+    * Returns the text written so far, which the caller can discard
+    * (e.g. once it has been sent)
+    */
+   std::pmr::string &getText() noexcept
+   {
+      return _text;
+   }
+
+private:
+   FilenameMap &_map;
+   std::filesystem::path _dirPath;
+   std::filesystem::directory_iterator _it;
+   data_t _listed;
+   std::pmr::string _text;
+   JsonWriter _writer;
+   bool _valid = false;
+   bool _started = false;
+   bool _over = false;
+};
+
+/* -------------------------------------------------------------------------- */
+
 #endif // !__ID_FILENAME_MAP_H__
\ No newline at end of file
@@ -0,0 +1,56 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __HEAP_STATS_H__
+#define __HEAP_STATS_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include <cstdint>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Counters of the calls to the global allocator made by the whole
+ * process: the global operator new and delete (in all their forms) are
+ * replaced by versions counting each call before forwarding it to
+ * malloc() and free().
+ * They let verify that serving requests in steady state takes no memory
+ * from the global allocator (@see RequestArena).
+ */
+namespace HeapStats
+{
+
+/* -------------------------------------------------------------------------- */
+
+//! Allocation counters
+struct Stats
+{
+   //! Calls to the global operator new (any form)
+   uint64_t allocations = 0;
+
+   //! Calls to the global operator delete (any form) releasing memory
+   uint64_t deallocations = 0;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Returns the counters of the calls made so far
+ */
+Stats getStats() noexcept;
+
+/* -------------------------------------------------------------------------- */
+
+} // namespace HeapStats
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__HEAP_STATS_H__
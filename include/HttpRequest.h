@@ -13,12 +13,16 @@
 
 /* -------------------------------------------------------------------------- */
 
+#include "FileUpload.h"
+#include "HttpRouter.h"
 #include "StrUtils.h"
 
+#include <array>
+#include <cstdint>
 #include <iostream>
-#include <list>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "config.h"
@@ -27,7 +31,10 @@
 
 /**
  * Encapsulates HTTP request, consisting of a request line,
- * some headers, and a content body
+ * some headers, and a content body.
+ * The request line and the headers are not copied: the request refers
+ * to them where they have been received (@see parseHead()), unless it
+ * is asked to keep its own copy (@see persist()).
  */
 class HttpRequest
 {
@@ -50,18 +57,69 @@ public:
    };
 
    HttpRequest() = default;
-   HttpRequest(const HttpRequest &) = default;
+   HttpRequest(const HttpRequest &) = delete;
+   HttpRequest &operator=(const HttpRequest &) = delete;
 
-   using HeaderList = std::list<std::string>;
+   //! Request header, referring to the request head content
+   struct Header
+   {
+      std::string_view name;
+      std::string_view value;
+   };
+
+   using HeaderList = std::vector<Header>;
+
+   //! Header fields known, whose values are indexed while parsing
+   enum class Field
+   {
+      acceptEncoding,
+      connection,
+      contentDisposition,
+      contentLength,
+      contentType,
+      expect,
+      host,
+      ifModifiedSince,
+      ifNoneMatch,
+      keepAlive,
+      range,
+      transferEncoding,
+      count
+   };
+
+   static constexpr size_t fieldCount = size_t(Field::count);
+
+   /**
+    * Returns the field of a header name (not case sensitive), or
+    * Field::count if not known
+    */
+   static Field findField(std::string_view name) noexcept;
 
    /**
     * Returns the request headers
     */
-   const HeaderList &getHeaderList() const
+   const HeaderList &getHeaderList() const noexcept
    {
       return _headerList;
    }
 
+   /**
+    * Returns the value of a given header (the name is not case
+    * sensitive), or an empty view if not present
+    */
+   std::string_view getHeader(std::string_view name) const noexcept;
+
+   /**
+    * Returns the value of a known field, or an empty view if not
+    * present. If the field is given more than once, the values of
+    * a list (e.g. Transfer-Encoding) are joined by commas, otherwise
+    * the first one is returned
+    */
+   std::string_view getHeader(Field field) const noexcept
+   {
+      return field < Field::count ? _fields[size_t(field)] : std::string_view();
+   }
+
    /**
     * Returns the method of the command line (GET, HEAD, ...)
     */
@@ -81,65 +139,85 @@ public:
    /**
     * Returns the command line URI
     */
-   const std::string &getUri() const noexcept
+   std::string_view getUri() const noexcept
    {
       return _uri;
    }
 
    /**
-    * Returns the command line URI args (arg1/arg2/.../argN)
+    * Returns the endpoint resolved for the method and the URI
     */
-   const std::vector<std::string> &getUriArgs() const noexcept
+   const HttpRouter::Route &getRoute() const noexcept
    {
-      return _uriArgs;
+      return _route;
    }
 
    /**
-    * Parses the HTTP method.
-    * @param method is HTTP method string
+    * Parses the request head: the request line followed by the header
+    * lines, each one terminated by CRLF. The content is not copied, so
+    * it must be kept unchanged while the request is in use, or until
+    * persist() is called.
+    *
+    * @param head is the request head, up to the CRLF of the last header
+    * @return false if the request line is malformed, true otherwise
     */
-   void parseMethod(const std::string &method);
+   bool parseHead(std::string_view head);
 
    /**
-    * Parses the URI field.
-    * @param uri is HTTP URI to parse
+    * Returns true if the request head has been parsed
     */
-   void parseUri(const std::string &uri)
+   bool hasHead() const noexcept
    {
-      StrUtils::splitLineInTokens(StrUtils::trim(uri), _uriArgs, "/");
-      _uri = uri;
+      return !_head.empty();
    }
 
    /**
-    * Parses the HTTP version.
-    * @param ver The input string to parse
+    * Copies the request head into the request, so that it no longer
+    * refers to the buffer the request has been parsed from (e.g. when
+    * such buffer is going to be reused while the request is pending)
     */
-   void parseVersion(const std::string &ver);
+   void persist();
 
    /**
-    * Parses a request header
-    * @param header The header content to be parsed
+    * Parses a header line following the request head (such as the
+    * headers of a multipart body part), which is copied as needed
+    *
+    * @param line is the header line
     */
-   void parseHeader(const std::string &header);
+   void parseHeaderLine(std::string_view line);
 
    /**
-    * Adds a new line to request data
-    * @param line to add
+    * Clears the request, so that it can be reused to parse a new one.
+    * Any memory held is retained to be reused too.
     */
-   void addLine(const std::string &line)
-   {
-      _headerList.push_back(line);
-   }
+   void clear();
 
    /**
     * Gets the content length field value
     * @return content length in bytes
     */
-   int getContentLength() const noexcept
+   uint64_t getContentLength() const noexcept
    {
       return _contentLength;
    }
 
+   /**
+    * Returns true if the body is sent with the chunked transfer coding
+    */
+   bool isChunked() const noexcept
+   {
+      return _chunked;
+   }
+
+   /**
+    * Returns true if the body is sent with a transfer coding
+    * not supported, so its length cannot be determined
+    */
+   bool hasUnsupportedTransferCoding() const noexcept
+   {
+      return _unsupportedTransferCoding;
+   }
+
    /**
     * Returns true if the request contains "Expect: 100-continue"
     * @return true if continue request sent by client, false otherwise
@@ -157,6 +235,29 @@ public:
       _expected_100_continue = false;
    }
 
+   /**
+    * Returns true if the client asks for a persistent connection: this is
+    * the default for HTTP/1.1 unless "Connection: close" is given, while
+    * an HTTP/1.0 client has to send "Connection: keep-alive"
+    */
+   bool isKeepAliveRequested() const noexcept
+   {
+      if (_connectionClose)
+         return false;
+
+      return getVersion() == Version::HTTP_1_1 ||
+             (getVersion() == Version::HTTP_1_0 && _connectionKeepAlive);
+   }
+
+   /**
+    * Returns the idle timeout in seconds proposed by the client by
+    * the Keep-Alive header, or -1 if not given
+    */
+   int getKeepAliveTimeout() const noexcept
+   {
+      return _keepAliveTimeout;
+   }
+
    /**
     * Gets the content-disposition 'filename' attribute content
     * @return string containing any file name posted
@@ -193,6 +294,59 @@ public:
       return _body;
    }
 
+   /**
+    * Sets the upload the body content has been written to, in place
+    * of being received in memory
+    * @param upload is the upload handle
+    */
+   void setUpload(FileUpload::Handle &&upload)
+   {
+      _upload = std::move(upload);
+   }
+
+   /**
+    * Returns the upload the body content has been written to, if any
+    */
+   FileUpload *getUpload() const noexcept
+   {
+      return _upload.get();
+   }
+
+   /**
+    * Marks the body as malformed (e.g. a multipart body whose
+    * Content-Length ends before its close delimiter)
+    */
+   void setMalformedBody() noexcept
+   {
+      _malformedBody = true;
+   }
+
+   /**
+    * Returns true if the body is malformed
+    */
+   bool isMalformedBody() const noexcept
+   {
+      return _malformedBody;
+   }
+
+   /**
+    * Sets the error status the request has to be answered with,
+    * because it exceeds a limit (e.g. 413 for a body too large)
+    */
+   void setErrorStatus(int status) noexcept
+   {
+      _errorStatus = status;
+   }
+
+   /**
+    * Returns the error status the request has to be answered with,
+    * or zero if it has not been rejected
+    */
+   int getErrorStatus() const noexcept
+   {
+      return _errorStatus;
+   }
+
    /**
     * Prints the request.
     *
@@ -200,23 +354,18 @@ public:
     * @param id request identifier
     * @return output stream reference
     */
-   std::ostream &dump(std::ostream &os, const std::string &id = "");
+   std::ostream &dump(std::ostream &os, const std::string &id = "") const;
 
    /**
     * Returns true if the GET request is valid, false otherwise
     */
    bool isValidGetRequest() const noexcept
    {
+      // Routes are resolved along with their method
       return 
-         (getMethod() == HttpRequest::Method::GET &&
-            (getUri() == HTTPSRV_GET_MRUFILES ||
-            getUri() == HTTPSRV_GET_MRUFILES_ZIP ||
-            getUri() == HTTPSRV_GET_FILES ||
-            (getUriArgs().size() == 3 &&
-               getUriArgs()[1] == HTTP_URIPFX_FILES) ||
-            (getUriArgs().size() == 4 &&
-               getUriArgs()[1] == HTTP_URIPFX_FILES &&
-               getUriArgs()[3] == HTTP_URISFX_ZIP)));
+         getMethod() == HttpRequest::Method::GET &&
+            getRoute() &&
+            !isMalformedBody();
    }
 
    /**
@@ -225,24 +374,53 @@ public:
    bool isValidPostRequest() const noexcept
    {
       return 
-         getMethod() == HttpRequest::Method::POST && 
-             getUri() == HTTPSRV_POST_STORE && 
+         getRoute().endpoint == HttpRouter::Endpoint::store && 
              !isExpected_100_Continue_Response() && 
+             !isMalformedBody() &&
              !getFileName().empty();
    }
 
 private:
+   // Request head, either in the receive buffer or in _headStorage
+   std::string_view _head;
+   std::string _headStorage;
+
+   // Values of the list fields given more than once, joined
+   std::string _joinedFields;
+
+   // Header lines found in the body (e.g. multipart headers)
+   std::string _bodyHeaderLines;
+
    HeaderList _headerList;
+   std::array<std::string_view, fieldCount> _fields;
    Method _method = Method::UNKNOWN;
    Version _version = Version::UNKNOWN;
-   std::string _uri;
+   std::string_view _uri;
+   HttpRouter::Route _route;
    std::string _body;
-   int _contentLength = 0;
-   std::string _contentType;
+   FileUpload::Handle _upload;
+   bool _malformedBody = false;
+   int _errorStatus = 0;
+   bool _chunked = false;
+   bool _unsupportedTransferCoding = false;
+   uint64_t _contentLength = 0;
    std::string _filename;
    std::string _boundary;
    bool _expected_100_continue = false;
-   std::vector<std::string> _uriArgs;
+   bool _connectionClose = false;
+   bool _connectionKeepAlive = false;
+   int _keepAliveTimeout = -1;
+
+   bool parseRequestLine(std::string_view line);
+   void parseMethod(std::string_view method);
+   void parseVersion(std::string_view ver);
+   void parseHeader(Field field, std::string_view value);
+   void mergeRepeatedField(Field field);
+   void parseConnectionHeader(std::string_view value);
+   void parseKeepAliveHeader(std::string_view value);
+   void parseContentTypeHeader(std::string_view value);
+   void parseContentDispositionHeader(std::string_view value);
+   void parseTransferEncodingHeader(std::string_view value);
 };
 
 /* -------------------------------------------------------------------------- */
@@ -0,0 +1,226 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __HTTP_REQUEST_PARSER_H__
+#define __HTTP_REQUEST_PARSER_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "BoundaryScanner.h"
+#include "ChunkedDecoder.h"
+#include "FileRepository.h"
+#include "HttpRequest.h"
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Incremental HTTP request parser.
+ * Data can be fed in chunks of any size (as they come from the transport
+ * layer); the parser consumes them until a complete request has been
+ * recognized, leaving any further byte to the caller.
+ * A request is framed by its header section and by the Content-Length
+ * header (or by the chunked transfer coding of its body), so it is
+ * complete as soon as its last byte has been fed, without waiting for
+ * the peer to stop sending.
+ * The request head is not copied when the whole request is received in
+ * a single chunk: the request refers to it where it lies in the receive
+ * buffer, which must be kept unchanged while the request is processed.
+ * A head split across chunks, or followed by a body still to be received,
+ * is copied into the request.
+ * Multipart bodies are searched for the part delimiters (BoundaryScanner)
+ * and the content of the first part is collected span by span, rather
+ * than line by line; any other part is ignored.
+ * The content of a file uploaded can be streamed to the repository as
+ * it is received (@see setUploadRepository()), so the memory used does
+ * not depend on the file size.
+ * The size of the header section, the number of header fields and the
+ * size of the body are checked as the data arrives: a request exceeding
+ * them is completed at once, before its excess is buffered, and flagged
+ * with the error status it has to be answered with (413 or 431).
+ */
+class HttpRequestParser
+{
+public:
+   //! Limits enforced while parsing, zero meaning unlimited
+   struct Limits
+   {
+      //! Max size of the request head (request line and header
+      //! fields, including the empty line ending them), which also
+      //! bounds each header line of a multipart body part
+      size_t maxHeadSize = HTTPSRV_MAX_HEAD_SIZE_DEF;
+
+      //! Max number of header fields
+      size_t maxHeaders = HTTPSRV_MAX_HEADERS_DEF;
+
+      //! Max size of the body (its content, if chunked)
+      size_t maxBodySize = HTTPSRV_MAX_BODY_SIZE_DEF;
+
+      //! Limits of a body sent with the chunked transfer coding
+      ChunkedDecoder::Limits chunked;
+   };
+
+   HttpRequestParser() = default;
+   HttpRequestParser(const HttpRequestParser &) = delete;
+   HttpRequestParser &operator=(const HttpRequestParser &) = delete;
+
+   /**
+    * Constructs a parser filling a given request object
+    * @param handle is the request to be filled in
+    */
+   HttpRequestParser(HttpRequest::Handle handle)
+   {
+      reset(handle);
+   }
+
+   /**
+    * Resets the parser state and starts parsing a new request.
+    * The handle can refer to a request already partially received
+    * (e.g. a request expecting a 100-Continue response): in such case
+    * the parsing goes on with the request body.
+    *
+    * @param handle is the request to be filled in
+    */
+   void reset(HttpRequest::Handle handle);
+
+   /**
+    * Sets the repository the files uploaded (POST /store) are written
+    * to while they are received: once complete, the request refers to
+    * the upload (@see HttpRequest::getUpload()) rather than to a body.
+    * Without a repository the body is received in memory.
+    *
+    * @param repository is the repository handle
+    */
+   void setUploadRepository(FileRepository::Handle repository)
+   {
+      _repository = repository;
+   }
+
+   /**
+    * Sets the limits enforced: a request exceeding them is
+    * considered malformed (@see HttpRequest::getErrorStatus())
+    *
+    * @param limits are the limits to enforce
+    */
+   void setLimits(const Limits &limits) noexcept
+   {
+      _limits = limits;
+   }
+
+   /**
+    * Feeds the parser with new data.
+    *
+    * @param data points the buffer containing the data, which is
+    *        referred by the request once complete
+    * @param size is the number of bytes in the buffer
+    * @return the number of bytes consumed, which can be less than size
+    *         if a request has been completed
+    */
+   size_t feed(const char *data, size_t size);
+
+   /**
+    * Returns true if a complete request has been parsed
+    */
+   bool isComplete() const noexcept
+   {
+      return _complete;
+   }
+
+   /**
+    * Returns true if no data has been fed since last reset
+    */
+   bool isIdle() const noexcept
+   {
+      return _idle;
+   }
+
+   /**
+    * Returns the request handle being parsed
+    */
+   const HttpRequest::Handle &getRequest() const noexcept
+   {
+      return _request;
+   }
+
+private:
+   enum class Stage
+   {
+      head,
+      multipartBody,
+      body
+   };
+
+   //! Multipart body status
+   enum class PartSt
+   {
+      preamble,
+      delimiter,
+      headers,
+      content,
+      epilogue
+   };
+
+   size_t feedHead(const char *data, size_t size);
+   void processHead(std::string_view head, bool copied);
+   size_t feedMultipartBody(const char *data, size_t size);
+   void processPartLine();
+
+   bool isCloseDelimiter() const noexcept
+   {
+      return _partSt == PartSt::delimiter && _line.compare(0, 2, "--") == 0;
+   }
+   size_t feedChunked(const char *data, size_t size);
+   void startBody();
+   void startUpload();
+   void completeBody();
+   void finalize();
+   void appendBody(const char *data, size_t size);
+
+   //! Completes the request as rejected with a given error status
+   void reject(int status);
+
+   //! Accounts further body bytes, rejecting the request if they
+   //! exceed the body limit
+   bool admitBody(size_t size);
+
+   HttpRequest::Handle _request;
+   Limits _limits;
+   Stage _stage = Stage::head;
+
+   // Beginning of a request head split across chunks
+   std::string _head;
+
+   // Multipart body status
+   BoundaryScanner _scanner;
+   PartSt _partSt = PartSt::preamble;
+   int _parts = 0;
+   std::string _line;
+
+   FileRepository::Handle _repository;
+   FileUpload::Handle _upload;
+
+   // Body framing
+   ChunkedDecoder _decoder;
+   bool _chunked = false;
+   bool _delimited = false;
+
+   std::string _body;
+   size_t _bodyToReceive = 0;
+   size_t _bodyReceived = 0;
+   bool _complete = false;
+   bool _idle = true;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // __HTTP_REQUEST_PARSER_H__
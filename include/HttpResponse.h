@@ -15,16 +15,24 @@
 
 #include "HttpRequest.h"
 
+#include <array>
 #include <unordered_map>
 #include <string>
+#include <string_view>
 #include <cassert>
 #include <memory>
+#include <memory_resource>
 
 /* -------------------------------------------------------------------------- */
 
 /**
  * Encapsulates HTTP response, consisting of a status line,
  * some headers, and a content body.
+ * Header and body are allocated from a given memory resource (e.g. the
+ * arena of the connection the response is sent on).
+ * Error responses are serialized once, when the program starts: such a
+ * response only holds the date it is sent with and refers to the shared
+ * (immutable) status line, headers and body.
  */
 class HttpResponse
 {
@@ -32,38 +40,81 @@ public:
    HttpResponse() = delete;
    HttpResponse(const HttpResponse &) = default;
    HttpResponse &operator=(const HttpResponse &) = default;
+   HttpResponse(HttpResponse &&) = default;
+   HttpResponse &operator=(HttpResponse &&) = default;
 
    using Handle = std::unique_ptr<HttpResponse>;
 
+   //! Memory slices a response is made of, in sending order. Some of
+   //! them can be empty.
+   using Slices = std::array<std::string_view, 3>;
+
    /**
     * Constructs a response to a given request.
     * @param request is the request
-    * @param body is optional body content
+    * @param body is optional body content, moved into the response,
+    *        whose memory resource is used for the header too
     * @param bodyFormat is optional body format
     * @param nameOfFileToSend is optional file name to send
     */
    HttpResponse(
        const HttpRequest &request,
-       const std::string &body,
+       std::pmr::string body,
        const std::string &bodyFormat,
-       const std::string &nameOfFileToSend);
+       const char *nameOfFileToSend);
 
    /**
     * Constructs an error response depending on given errorCode.
+    * Codes missing from the error table are answered as 500.
     */
-   HttpResponse(int errorCode)
+   HttpResponse(
+      int errorCode,
+      std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+      : _header(memory), _body(memory), _date(memory)
    {
       formatError(errorCode);
    }
 
    /**
-    * Returns the content of response status line and response headers.
+    * Constructs a positive response whose content, of a given format,
+    * is sent in chunks following the header (Transfer-Encoding: chunked)
     */
-   operator const std::string& () const
+   HttpResponse(std::string_view bodyFormat, std::pmr::memory_resource *memory)
+      : _header(memory), _body(memory), _date(memory)
    {
-      return _response;
+      formatChunkedResponse(bodyFormat);
    }
 
+   /**
+    * Returns the slices holding status line, headers and body, if any.
+    * The content of a file to be sent is not part of them.
+    * They remain valid as long as the response is neither changed nor
+    * moved: a short content is held within the response object itself.
+    */
+   Slices getSlices() const noexcept;
+
+   /**
+    * Returns the slices of the pre-serialized response to a given error
+    * code, sent with a given date.
+    *
+    * @param code is the error code (500 if not in the error table)
+    * @param date is the date, in the HTTP date format
+    */
+   static Slices getErrorSlices(int code, std::string_view date) noexcept;
+
+   /**
+    * Adds the headers telling the client whether the connection is
+    * kept open after this response. It does not apply to an interim
+    * (100 Continue) response, nor to an error response, which always
+    * closes the connection.
+    *
+    * @param keepAlive is true if the connection is persistent
+    * @param timeout is the idle timeout of the connection in seconds
+    * @param maxRequests is the number of further requests the
+    *        client can send on the connection
+    */
+   void setConnectionHeaders(bool keepAlive, int timeout, int maxRequests);
+
    /**
     * Writes response into output stream.
     *
@@ -71,7 +122,7 @@ public:
     * @param id a string used to identify the response
     * @return the os output stream
     */
-   std::ostream &dump(std::ostream &os, const std::string &id = "");
+   std::ostream &dump(std::ostream &os, const std::string &id = "") const;
 
    /**
     * Returns ture if HTTP error code is 4xx/5xx,
@@ -82,21 +133,42 @@ public:
       return _errorResponse;
    }
 
+   /**
+    * Returns true if this is an interim 100 Continue response
+    */
+   bool isContinueResponse() const noexcept
+   {
+      return _continueResponse;
+   }
+
 private:
-   static std::unordered_map<std::string, std::string> _mimeTbl;
+   struct PreparedError;
+
    static std::unordered_map<int, std::string> _errTbl;
+   static const std::unordered_map<int, PreparedError> _preparedErrTbl;
+
+   std::pmr::string _header;
+   std::pmr::string _body;
+
+   // Pre-serialized response sent in place of header and body, if any,
+   // and its date
+   const PreparedError *_preparedError = nullptr;
+   std::pmr::string _date;
 
-   std::string _response;
    bool _errorResponse = false;
+   bool _continueResponse = false;
 
    // Format an error response
    void formatError(int code);
 
    // Format an positive response
    void formatPositiveResponse(
-       const std::string &fileTime,
-       const std::string &fileExt,
-       const size_t &contentLen);
+       std::string_view fileTime,
+       std::string_view fileExt,
+       size_t contentLen);
+
+   // Format the header of a positive response sent in chunks
+   void formatChunkedResponse(std::string_view fileExt);
 
    // Format an positive response
    void formatContinueResponse();
@@ -0,0 +1,78 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __HTTP_ROUTER_H__
+#define __HTTP_ROUTER_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include <cstddef>
+#include <string_view>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Resolves the method and the URI of a request to the endpoint serving
+ * it.
+ * Endpoints are declared in a route table such as "/files/{id}/zip",
+ * where "{id}" captures a path segment. The table is compiled into a
+ * trie over the path segments, whose literal segments are found by a
+ * perfect hash: a URI is resolved by a single pass over its segments,
+ * at a cost which does not depend on the number of endpoints.
+ */
+class HttpRouter
+{
+public:
+   //! Endpoints served
+   enum class Endpoint
+   {
+      files,       //!< GET /files
+      file,        //!< GET /files/<id>
+      fileZip,     //!< GET /files/<id>/zip
+      mruFiles,    //!< GET /mrufiles
+      mruFilesZip, //!< GET /mrufiles/zip
+      store,       //!< POST /store
+      stats,       //!< GET /stats
+      count
+   };
+
+   static constexpr size_t endpointCount = size_t(Endpoint::count);
+
+   //! Result of the resolution of a request
+   struct Route
+   {
+      //! Endpoint matched, Endpoint::count if none
+      Endpoint endpoint = Endpoint::count;
+
+      //! Path segment captured by "{id}", if any
+      std::string_view id;
+
+      /**
+       * Returns true if an endpoint has been matched
+       */
+      explicit operator bool() const noexcept
+      {
+         return endpoint != Endpoint::count;
+      }
+   };
+
+   /**
+    * Resolves a request
+    *
+    * @param method is the method token of the request line
+    * @param uri is the URI of the request line
+    * @return the route matched; the id captured is a view of the uri
+    */
+   static Route resolve(std::string_view method, std::string_view uri) noexcept;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__HTTP_ROUTER_H__
@@ -16,9 +16,13 @@
 #include "HttpSocket.h"
 #include "TcpListener.h"
 #include "FileRepository.h"
+#include "WorkerPool.h"
+#include "HttpSession.h"
+#include "LoadShedder.h"
 #include "config.h"
 
 #include <string>
+#include <vector>
 
 /* -------------------------------------------------------------------------- */
 
@@ -30,6 +34,20 @@ class HttpServer
 public:
    using TranspPort = TcpListener::TranspPort;
 
+   //! Defines how the connections are served
+   enum class IoModel
+   {
+      //! each connection is handled by a dedicated thread
+      threadPerConnection,
+      //! connections are multiplexed by a fixed number of event loops
+      eventLoop,
+      //! connections are handled by a fixed number of worker threads
+      threadPool,
+      //! like eventLoop, but I/O operations are performed via io_uring
+      //! (falls back to eventLoop if the kernel lacks support)
+      ioUring
+   };
+
 public:
    HttpServer(const HttpServer &) = delete;
    HttpServer &operator=(const HttpServer &) = delete;
@@ -90,6 +108,148 @@ public:
       return _serverPort;
    }
 
+   /**
+    * Sets the I/O model used to serve the connections
+    *
+    * @param model is the I/O model
+    * @param eventLoops is the number of event loop threads (applies to
+    *        the IoModel::eventLoop and IoModel::ioUring only); if zero it
+    *        matches the number of CPU cores
+    */
+   void setIoModel(IoModel model, int eventLoops = 0) noexcept
+   {
+      _ioModel = model;
+      _eventLoops = eventLoops;
+   }
+
+   /**
+    * Configures the worker pool, serving the sessions with the
+    * IoModel::threadPool or running the blocking jobs of the sessions
+    * driven by event loops
+    *
+    * @param threads is the number of worker threads
+    * @param queueSize is the max number of connections waiting for
+    *        a worker, beyond which new connections are rejected
+    */
+   void setWorkerPool(int threads, int queueSize) noexcept
+   {
+      _workerThreads = threads;
+      _workerQueueSize = queueSize;
+   }
+
+   /**
+    * Configures the persistent connections
+    *
+    * @param timeout is the max time (in seconds) an idle connection
+    *        is kept open; if zero the connection is closed after
+    *        each response
+    * @param maxRequests is the max number of requests served
+    *        on a connection
+    */
+   void setKeepAlive(int timeout, int maxRequests) noexcept
+   {
+      _sessionConfig.keepAliveTimeout = timeout;
+      _sessionConfig.keepAliveMaxRequests = maxRequests;
+   }
+
+   /**
+    * Configures the request pipelining
+    *
+    * @param depth is the max number of requests, already received
+    *        on a connection, processed before sending their responses
+    *        in a single write; if 1 each response is sent on its own
+    */
+   void setPipelineDepth(int depth) noexcept
+   {
+      _sessionConfig.pipelineDepth = depth;
+   }
+
+   /**
+    * Configures the limits of the request bodies sent with the chunked
+    * transfer coding: a body exceeding them is answered by a 400 (Bad
+    * Request) response
+    *
+    * @param maxChunkSize is the max size of a chunk, zero meaning
+    *        unlimited
+    * @param maxTrailerSize is the max size of the trailer fields,
+    *        zero meaning that no trailer field is accepted
+    */
+   void setChunkLimits(size_t maxChunkSize, size_t maxTrailerSize) noexcept
+   {
+      _sessionConfig.requestLimits.chunked.maxChunkSize = maxChunkSize;
+      _sessionConfig.requestLimits.chunked.maxTrailerSize = maxTrailerSize;
+   }
+
+   /**
+    * Configures the limits of the requests, checked while they are
+    * received: a request exceeding them is answered by a 431 (Request
+    * Header Fields Too Large) or 413 (Payload Too Large) response
+    *
+    * @param maxHeadSize is the max size of the request line and
+    *        header fields, zero meaning unlimited
+    * @param maxHeaders is the max number of header fields, zero
+    *        meaning unlimited
+    * @param maxBodySize is the max size of the body, zero meaning
+    *        unlimited
+    */
+   void setRequestLimits(size_t maxHeadSize, size_t maxHeaders, size_t maxBodySize) noexcept
+   {
+      _sessionConfig.requestLimits.maxHeadSize = maxHeadSize;
+      _sessionConfig.requestLimits.maxHeaders = maxHeaders;
+      _sessionConfig.requestLimits.maxBodySize = maxBodySize;
+   }
+
+   /**
+    * Configures the overload protection. Any connection or request
+    * exceeding a limit is answered by a 503 (Service Unavailable)
+    * response. It must be called before run().
+    *
+    * @param maxConnections is the max number of open connections
+    * @param maxZipJobs is the max number of zip archives being
+    *        created or sent at the same time
+    */
+   void setLimits(int maxConnections, int maxZipJobs) noexcept
+   {
+      _limits.maxConnections = maxConnections;
+      _limits.maxZipJobs = maxZipJobs;
+   }
+
+   /**
+    * Configures the max number of requests concurrently served
+    * by a given endpoint (zero means unlimited).
+    * It must be called before run().
+    */
+   void setEndpointBudget(LoadShedder::Endpoint endpoint, int budget) noexcept
+   {
+      _limits.endpointBudget[size_t(endpoint)] = budget;
+   }
+
+   /**
+    * Returns the counters of the traffic shed so far
+    */
+   LoadShedder::Stats getShedStats() const noexcept
+   {
+      return _sessionConfig.loadShedder ? 
+         _sessionConfig.loadShedder->getStats() : LoadShedder::Stats();
+   }
+
+   /**
+    * Configures the acceptors. When more than one acceptor is required,
+    * each of them owns a listener bound with SO_REUSEPORT to the same port,
+    * so the kernel spreads the incoming connections among them.
+    * Each acceptor runs in a dedicated thread (or event loop, for the
+    * IoModel::eventLoop) and dispatches its own sessions.
+    * It must be called before bind().
+    *
+    * @param acceptors is the number of acceptors
+    * @param cpuAffinity if true each acceptor thread is pinned to a CPU
+    */
+   void setAcceptors(int acceptors, bool cpuAffinity) noexcept
+   {
+      _acceptors = acceptors;
+      _cpuAffinity = cpuAffinity;
+   }
+
    /**
     * Binds the HTTP server to a local TCP port
     *
@@ -114,29 +274,33 @@ public:
     */
    bool run();
 
-protected:
-   /**
-    * Accepts a new connection from a remote client.
-    * This function blocks until connection is established or
-    * an error occurs.
-    * 
-    * @return a handle to tcp socket
-    */
-   TcpSocket::Handle accept()
-   {
-      return _tcpServer ? _tcpServer->accept() : nullptr;
-   }
-
 private:
    static HttpServer* _instance;
 
+   IoModel _ioModel = IoModel::threadPerConnection;
+   int _eventLoops = 0;
+   int _workerThreads = HTTPSRV_WORKER_THREADS_DEF;
+   int _workerQueueSize = HTTPSRV_WORKER_QUEUE_DEF;
+   WorkerPool::Handle _workerPool;
+   LoadShedder::Limits _limits;
+   int _acceptors = 1;
+   bool _cpuAffinity = false;
+   HttpSession::Config _sessionConfig;
+
    std::ostream *_loggerOStreamPtr = &std::clog;
    TranspPort _serverPort = HTTPSRV_PORT;
-   TcpListener::Handle _tcpServer;
+   std::vector<TcpListener::Handle> _listeners;
    bool _verboseModeOn = true;
    FileRepository::Handle _FileRepository;
 
    HttpServer() = default;
+
+   bool runAcceptors();
+   bool runAcceptLoop(TcpListener &listener);
+   template <typename Loop>
+   bool runEventLoops();
+   void pinThreadToCpu(size_t index);
+   void rejectConnection(const TcpSocket::Handle &handle);
 };
 
 /* -------------------------------------------------------------------------- */
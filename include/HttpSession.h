@@ -15,52 +15,207 @@
 #include "TcpSocket.h"
 #include "HttpRequest.h"
 #include "HttpResponse.h"
+#include "HttpRequestParser.h"
+#include "HttpSocket.h"
+#include "IoChannel.h"
+#include "LoadShedder.h"
+#include "RequestArena.h"
+#include "TxQueue.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
+#include <memory_resource>
+#include <optional>
 #include <ostream>
+#include <string>
+
+/* -------------------------------------------------------------------------- */
+
+class WorkerPool;
 
 /* -------------------------------------------------------------------------- */
 // HttpSession
 /* -------------------------------------------------------------------------- */
 
-class HttpSession
+class HttpSession : public std::enable_shared_from_this<HttpSession>
 {
 public:
    using Handle = std::shared_ptr<HttpSession>;
 
+   //! Asks the event loop driving a session to resume it, once the
+   //! blocking job it was waiting for is done (@see runJob())
+   using Resumer = std::function<void(const Handle &)>;
+
+   /**
+    * Settings applying to all the sessions of a server
+    */
+   struct Config
+   {
+      //! Max time (in seconds) an idle persistent connection is kept open
+      int keepAliveTimeout = HTTPSRV_KEEPALIVE_TIMEOUT_DEF;
+
+      //! Max number of requests served on a persistent connection
+      int keepAliveMaxRequests = HTTPSRV_KEEPALIVE_REQUESTS_DEF;
+
+      //! Max number of pipelined requests processed before their
+      //! responses are sent
+      int pipelineDepth = HTTPSRV_PIPELINE_DEPTH_DEF;
+
+      //! Limits enforced while parsing the requests
+      HttpRequestParser::Limits requestLimits;
+
+      //! Overload protection, if any
+      LoadShedder::Handle loadShedder;
+
+      //! Pool running the blocking jobs of the sessions driven by an
+      //! event loop (e.g. the creation of a zip archive), if any: it
+      //! outlives the sessions
+      WorkerPool *workerPool = nullptr;
+   };
+
+   /**
+    * Creates a new session
+    *
+    * @param connectionTicket is the admission granted to the connection,
+    *        held until the session is destroyed
+    */
    inline static Handle create(
        bool verboseModeOn,
        std::ostream &loggerOStream,
        TcpSocket::Handle socketHandle,
-       FileRepository::Handle FileRepository)
+       FileRepository::Handle FileRepository,
+       const Config &config,
+       LoadShedder::Ticket connectionTicket)
    {
       return Handle(new (std::nothrow) HttpSession(
           verboseModeOn,
           loggerOStream,
           socketHandle,
-          FileRepository));
+          FileRepository,
+          config,
+          std::move(connectionTicket)));
    }
 
    HttpSession() = delete;
+   HttpSession(const HttpSession &) = delete;
+   HttpSession &operator=(const HttpSession &) = delete;
+
+   /**
+    * Serves the requests received on the connection in the calling
+    * thread context, until the session is over
+    */
    void operator()(Handle taskHandle);
 
+   /**
+    * Serves the requests received on the connection in the calling
+    * thread context, until the session is over or, if returnWhenIdle is
+    * true, until the connection is idle (kept open, with no data received
+    * and not processed yet). An idle session is resumed by calling this
+    * function again, once the connection is readable.
+    *
+    * @return true if the connection is idle, false if the session is over
+    */
+   bool serve(bool returnWhenIdle);
+
+   /**
+    * Prepares the session to be driven by an event loop via onIoEvent()
+    *
+    * @param channel is the channel used to perform the I/O operations,
+    *        which must outlive the session activity
+    * @param resumer is called by a thread of the worker pool once a
+    *        job of the session is done (@see Config::workerPool)
+    */
+   void start(IoChannel &channel, Resumer resumer = Resumer());
+
+   /**
+    * Drives the session state machine (receiving a request, processing it
+    * and sending the response) through its I/O channel, until an I/O
+    * operation would block the caller.
+    * Pipelined requests already received are processed in a row and
+    * their responses are sent together.
+    * It is meant to be called by an event loop each time a pending
+    * operation of the channel can make progress.
+    * The business logic accessing the repository (which can block the
+    * caller) is handed over to the worker pool, if any: the session
+    * ignores any event until the job is done and the resumer has been
+    * called.
+    *
+    * @return false if the session is over and the connection has to be
+    *         closed, true otherwise
+    */
+   bool onIoEvent();
+
+   /**
+    * Returns true while the session waits for a job run by the worker
+    * pool, and its connection is not to be closed as idle
+    */
+   bool isRunningJob() const noexcept
+   {
+      return _state == State::runningJob;
+   }
+
+   /**
+    * Returns true if the session has been submitted to the worker pool
+    * to run a job
+    */
+   bool hasJob() const noexcept
+   {
+      return _job != Job::none;
+   }
+
+   /**
+    * Runs the job the session is waiting for in the calling thread
+    * context, then asks the event loop to resume the session
+    */
+   void runJob();
+
+   /**
+    * Shuts down the connection and terminates the session
+    */
+   void terminate();
+
+   /**
+    * Returns the max time the connection can stay idle (i.e. the
+    * peer neither sending nor receiving any data)
+    */
+   std::chrono::seconds getIdleTimeout() const noexcept
+   {
+      return std::chrono::seconds(_idleTimeout);
+   }
+
+   /**
+    * Returns the TCP socket handle of this session
+    */
+   const TcpSocket::Handle &getTcpSocketHandle() const noexcept
+   {
+      return _tcpSocketHandle;
+   }
+
 private:
    bool _verboseModeOn = true;
    std::ostream &_logger;
    TcpSocket::Handle _tcpSocketHandle;
    FileRepository::Handle _FileRepository;
+   Config _config;
+   LoadShedder::Ticket _connectionTicket;
    std::string _sessionId;
 
+   // Persistent connection status
+   int _idleTimeout = HTTPSRV_KEEPALIVE_TIMEOUT_DEF;
+   int _requestsServed = 0;
+
+   // Memory of the replies, reclaimed once their responses are sent
+   RequestArena _arena;
+
    std::ostream &log()
    {
       return _logger;
    }
 
-   TcpSocket::Handle &getTcpSocketHandle()
-   {
-      return _tcpSocketHandle;
-   }
-
    const std::string &getLocalStorePath() const
    {
       return _FileRepository->getPath();
@@ -70,12 +225,19 @@ private:
        bool verboseModeOn,
        std::ostream &loggerOStream,
        TcpSocket::Handle socketHandle,
-       FileRepository::Handle FileRepository)
+       FileRepository::Handle FileRepository,
+       const Config &config,
+       LoadShedder::Ticket connectionTicket)
        : 
        _verboseModeOn(verboseModeOn), 
        _logger(loggerOStream), 
        _tcpSocketHandle(socketHandle), 
-       _FileRepository(FileRepository)
+       _FileRepository(FileRepository),
+       _config(config),
+       _connectionTicket(std::move(connectionTicket)),
+       _idleTimeout(config.keepAliveTimeout),
+       _httpSocket(socketHandle, &_arena),
+       _txQueue(&_arena)
    {
    }
 
@@ -87,24 +249,172 @@ private:
       sendJsonFileList,
       sendMruFiles,
       sendNotFound,
+      sendStats,
       sendZipFile
    };
 
+   enum class State
+   {
+      receivingRequest,
+      processingRequest,
+      runningJob,
+      requestProcessed,
+      sendingResponse,
+      closing
+   };
+
+   //! Business logic run by the worker pool
+   enum class Job
+   {
+      none,
+      processRequest,
+      writeListingChunk
+   };
+
+   enum class IoResult
+   {
+      done,
+      wouldBlock,
+      failed
+   };
+
+   //! Outcome of the business logic for a given request
+   struct Reply
+   {
+      explicit Reply(std::pmr::memory_resource *memory)
+         : nameOfFileToSend(memory)
+      {
+      }
+
+      // Allocated from the session arena
+      std::optional<HttpResponse> response;
+      processAction action = processAction::none;
+      std::pmr::string nameOfFileToSend;
+
+      // true if the connection is kept open after the response
+      bool keepAlive = false;
+
+      // Listing of the repository sent in chunks following the
+      // response header, if any
+      std::optional<FilenameMap::Listing> listing;
+
+      // if assigned with non-null DirectoryRipper Handle (a shared pointer)
+      // on reply destruction the DirectoryRipper will eventually clean up the
+      // temporary directory and its content created for the zip archive
+      // required by GET files/<id>/zip or GET mrufiles/zip operations
+      FileUtils::DirectoryRipper::Handle zipCleaner;
+
+      // Admissions granted by the load shedder, released once the
+      // reply is over
+      LoadShedder::Ticket requestTicket;
+      LoadShedder::Ticket zipJobTicket;
+   };
+
+   // true once the session has begun serving requests
+   bool _started = false;
+
+   // Blocking session context, lasting across the calls to serve()
+   // so that the request and the receive buffer are reused
+   HttpRequest::Handle _incomingRequest;
+   HttpSocket _httpSocket;
+
+   // Event-driven session context
+   IoChannel *_ioChannel = nullptr;
+   State _state = State::receivingRequest;
+   HttpRequestParser _parser;
+   std::string _rxPending;
+   size_t _rxPendingBegin = 0;
+   TxQueue _txQueue;
+
+   // Replies whose responses are queued and not sent yet. The queue
+   // refers to their responses, so they are built in place and never
+   // moved (a deque does not relocate its elements when growing).
+   // The deque is allocated from the arena: it is rebuilt once the
+   // arena has been reset (@see releaseReplies())
+   std::optional<std::pmr::deque<Reply>> _pipeline;
+
+   // Job handed over to the worker pool, and the state following it
+   Job _job = Job::none;
+   State _stateAfterJob = State::closing;
+   std::atomic<bool> _jobDone{false};
+   Resumer _resumer;
+
    void logSessionBegin();
    void logEnd();
 
+   //! Executes the business logic for a given request
+   void processRequest(HttpRequest &incomingRequest, Reply &reply);
+
+   //! Checks the budget of the endpoint addressed by a given request
+   //! (and the zip jobs limit), returning false if it has to be shed
+   bool admitRequest(const HttpRequest &request, Reply &reply);
+
+   //! Decides whether the connection has to be kept open after
+   //! the response, adding the related headers to the response
+   bool applyKeepAlivePolicy(const HttpRequest &request, HttpResponse &response);
+
+   //! Reads from the I/O channel until a request is complete
+   IoResult receiveRequest();
+
+   //! Parses the data already received, without reading from the
+   //! I/O channel; returns true if a request is complete
+   bool parseBufferedRequest();
+
+   //! Queues the response of a given reply, last one of the pipeline;
+   //! returns true if the connection is kept open
+   bool queueReply(Reply &reply);
+
+   //! Writes to the I/O channel the responses queued
+   IoResult sendReplies();
+
+   //! Returns true if the business logic serving a given request can
+   //! block the caller (i.e. it accesses the repository)
+   static bool isBlocking(const HttpRequest &request) noexcept;
+
+   //! Hands over a job to the worker pool, moving to a given state once
+   //! it is done; returns false if the job cannot be queued
+   bool startJob(Job job, State stateAfterJob);
+
+   //! Answers a request with 503 (Service Unavailable) as the worker
+   //! pool is overloaded
+   void shedRequest(HttpRequest &request, Reply &reply);
+
+   //! Queues the next chunk of the listing sent by the last reply
+   void queueListingChunk();
+
+   //! Appends a new reply to the pipeline
+   Reply &newReply();
+
+   //! Discards the replies whose responses have been sent, and gives
+   //! the memory they used (along with the queues) back to the arena
+   void releaseReplies();
+
+   //! Formats the shed and the memory allocation counters
+   void jsonStats(std::pmr::string &json) const;
+
+   //! Prepares the parser to receive a new request
+   void prepareNextRequest();
+
+   //! Gets a given request ready to be filled by next request
+   //! received, or by the rest of a request expecting a 100-Continue
+   static void renewRequest(HttpRequest &request);
+
+   //! Writes the next chunk of a listing, framed as in the chunked
+   //! transfer coding (the last one followed by the end of content),
+   //! returning the data to send
+   static std::string_view nextListingChunk(FilenameMap::Listing &listing);
+
    //! Process HTTP GET Method
    processAction processGetRequest(
        HttpRequest &incomingRequest,
-       std::string &json,
-       std::string &nameOfFileToSend,
-       FileUtils::DirectoryRipper::Handle& zipCleaner);
+       std::pmr::string &json,
+       Reply &reply);
 
 
    //! Process HTTP POST method
    void processPostRequest(
       HttpRequest& incomingRequest, 
-      std::string& jsonResponse);
+      std::pmr::string& jsonResponse);
 };
 
 /* -------------------------------------------------------------------------- */
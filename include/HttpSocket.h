@@ -16,11 +16,15 @@
 #include "TcpSocket.h"
 
 #include "HttpRequest.h"
+#include "HttpRequestParser.h"
 #include "HttpResponse.h"
+#include "TxQueue.h"
 
 #include "config.h"
 
+#include <memory_resource>
 #include <string>
+#include <vector>
 
 /* -------------------------------------------------------------------------- */
 // HttpResponse
@@ -35,26 +39,64 @@ private:
     TcpSocket::Handle _socketHandle;
     bool _connUp = true;
 
+    // Data is received in chunks: any byte not consumed by current
+    // request (e.g. belonging to a pipelined one) is kept here
+    std::vector<char> _rxBuffer;
+    size_t _rxBegin = 0;
+    size_t _rxEnd = 0;
+
+    // The parser lasts across the receive operations, so that a request
+    // partially parsed by parseBuffered() is completed by next recv()
+    HttpRequestParser _parser;
+    bool _parsing = false;
+
+    // Responses queued and not sent yet
+    TxQueue _txQueue;
+
     bool recv(HttpRequest::Handle &handle);
     int _connectionTimeOut = HTTP_CONNECTION_TIMEOUT_MS;
+    bool _timedOut = false;
 
 public:
     HttpSocket() = default;
-    HttpSocket(const HttpSocket &) = default;
+    HttpSocket(const HttpSocket &) = delete;
+    HttpSocket &operator=(const HttpSocket &) = delete;
 
     /**
      * Construct the HTTP connection starting from TCP connected-socket handle.
+     * @param memory is the memory resource of the queue of responses
      */
-    HttpSocket(TcpSocket::Handle handle)
-        : _socketHandle(handle)
+    HttpSocket(
+        TcpSocket::Handle handle,
+        std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+        : _socketHandle(handle), _txQueue(memory)
     {
     }
 
     /**
-     * Assigns a new TCP connected socket handle to this HTTP socket.
+     * Assigns a new TCP connected socket handle to this HTTP socket,
+     * discarding any data received from (or queued for) previous one.
      */
     HttpSocket &operator=(TcpSocket::Handle handle);
 
+    /**
+     * Sets the repository the files uploaded are written to while
+     * they are received (@see HttpRequestParser::setUploadRepository())
+     */
+    void setUploadRepository(FileRepository::Handle repository)
+    {
+        _parser.setUploadRepository(repository);
+    }
+
+    /**
+     * Sets the limits enforced while parsing the requests
+     * (@see HttpRequestParser::setLimits())
+     */
+    void setParserLimits(const HttpRequestParser::Limits &limits)
+    {
+        _parser.setLimits(limits);
+    }
+
     /**
      * Returns TCP socket handle
      */
@@ -65,6 +107,8 @@ public:
 
     /**
      * Receives an HTTP request from remote peer.
+     * Any data received beyond the end of the request is retained
+     * for next request.
      * @param the handle of http request object
      */
     HttpSocket &operator>>(HttpRequest::Handle &handle)
@@ -73,6 +117,25 @@ public:
         return *this;
     }
 
+    /**
+     * Parses any data already received into a given request, without
+     * waiting for more data (e.g. to detect pipelined requests).
+     * If the request is complete, next receive operation returns it
+     * at once; otherwise next receive operation goes on parsing it.
+     * @param handle the handle of http request object
+     * @return true if the request is complete, false otherwise
+     */
+    bool parseBuffered(HttpRequest::Handle &handle);
+
+    /**
+     * Returns true if any data has been received and not yet returned
+     * as part of a request (e.g. the beginning of a pipelined one)
+     */
+    bool hasPendingData() const noexcept
+    {
+        return _rxBegin < _rxEnd || !_parser.isIdle();
+    }
+
     /**
      * Returns false if last recv/send operation detected
      * that connection was down; true otherwise.
@@ -82,19 +145,75 @@ public:
         return _connUp;
     }
 
+    /**
+     * Returns true if last receive operation expired while a request
+     * was partially received: such request is not returned.
+     */
+    bool hasTimedOut() const noexcept
+    {
+        return _timedOut;
+    }
+
     /**
      * Send a response to remote peer.
      * @param response The HTTP response
      */
-    HttpSocket &operator<<(const HttpResponse &response);
+    HttpSocket &operator<<(const HttpResponse &response)
+    {
+        send(response, std::string());
+        return *this;
+    }
 
     /**
-     * Send a response to remote peer.
+     * Send a response to remote peer, followed by the content of a file.
+     * Header, body and file content are sent by gather operations, so
+     * that they can share the same TCP segments.
+     * @param response The HTTP response
+     * @param fileName The name of the file to send, if not empty
+     * @return false if the file could not be opened or sent,
+     *         true otherwise
+     */
+    bool send(const HttpResponse &response, const std::string &fileName)
+    {
+        const bool fileOpened = queue(response, fileName.c_str());
+        return flush() && fileOpened;
+    }
+
+    /**
+     * Queues a response, followed by the content of a file, to be sent
+     * by next flush(). The response is not copied, so it must be kept
+     * unchanged until then.
      * @param response The HTTP response
+     * @param fileName The name of the file to send, if not null or empty
+     * @return false if the file could not be opened, true otherwise
+     */
+    bool queue(const HttpResponse &response, const char *fileName);
+
+    /**
+     * Queues data (e.g. a chunk of a response content) to be sent by
+     * next flush(). The data are not copied, so they must be kept
+     * unchanged until then.
+     * @param data The data to send
+     */
+    void queue(std::string_view data)
+    {
+        _txQueue.append(data.data(), data.size());
+    }
+
+    /**
+     * Sends all the queued responses to remote peer, coalescing them
+     * by gather operations.
+     * @return false if the connection is down, true otherwise
+     */
+    bool flush();
+
+    /**
+     * Gives the memory of the queue back to its resource, once all
+     * the responses have been sent (@see TxQueue::release())
      */
-    int sendFile(const std::string &fileName)
+    void release()
     {
-        return _socketHandle->sendFile(fileName);
+        _txQueue.release();
     }
 
     /*
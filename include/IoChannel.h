@@ -0,0 +1,113 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __IO_CHANNEL_H__
+#define __IO_CHANNEL_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "TransportSocket.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Non-blocking I/O operations on a connection, as seen by an event-driven
+ * HTTP session (@see HttpSession::onIoEvent()).
+ * Each operation either makes some progress or reports it would block:
+ * in the latter case the owner of the channel resumes the session as soon
+ * as the operation can go on, and the session retries the same operation.
+ * This lets the same session state machine run on top of readiness-based
+ * (epoll) and completion-based (io_uring) event loops.
+ */
+class IoChannel
+{
+public:
+   enum class Status
+   {
+      done,
+      wouldBlock,
+      closed,
+      failed
+   };
+
+   IoChannel() = default;
+   IoChannel(const IoChannel &) = delete;
+   IoChannel &operator=(const IoChannel &) = delete;
+   virtual ~IoChannel() = default;
+
+   /**
+    * Receives data from the connection
+    *
+    * @param data is set to the received data, which is valid until
+    *        next operation on this channel
+    * @param size is set to the number of bytes received
+    * @return Status::done if some data has been received,
+    *         Status::closed if the connection has been closed by peer
+    */
+   virtual Status recv(const char *&data, size_t &size) = 0;
+
+   /**
+    * Sends a sequence of memory regions on the connection by a single
+    * gather operation
+    *
+    * @param slices points the regions to send, which must be kept
+    *        unchanged until the operation is done
+    * @param count is the number of regions, up to HTTPSRV_IOV_MAX
+    * @param more is true if more data follows (@see TransportSocket::sendv())
+    * @param sent is set to the number of bytes sent, which can be less
+    *        than the overall size of the regions
+    */
+   virtual Status sendv(
+       const IoSlice *slices, size_t count, bool more, size_t &sent) = 0;
+
+   /**
+    * Sends a region of an open file on the connection
+    *
+    * @param fd is the file descriptor
+    * @param offset is the file offset of the region
+    * @param size is the region size in bytes
+    * @param sent is set to the number of bytes sent, which can be less
+    *        than size
+    */
+   virtual Status sendFile(int fd, uint64_t offset, size_t size, size_t &sent) = 0;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Channel performing system calls on a socket. On a non-blocking socket
+ * it is meant to be driven by readiness notifications (@see EventLoop),
+ * on a blocking one its operations just return once done.
+ */
+class SocketIoChannel : public IoChannel
+{
+public:
+   /**
+    * Constructs a channel on a given socket
+    */
+   explicit SocketIoChannel(TransportSocket &socket) noexcept
+       : _socket(socket)
+   {
+   }
+
+   Status recv(const char *&data, size_t &size) override;
+   Status sendv(const IoSlice *slices, size_t count, bool more, size_t &sent) override;
+   Status sendFile(int fd, uint64_t offset, size_t size, size_t &sent) override;
+
+private:
+   TransportSocket &_socket;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__IO_CHANNEL_H__
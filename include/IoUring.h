@@ -0,0 +1,174 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __IO_URING_H__
+#define __IO_URING_H__
+
+/* -------------------------------------------------------------------------- */
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HTTPSRV_IO_URING 1
+#endif
+#endif
+
+#ifdef HTTPSRV_IO_URING
+
+/* -------------------------------------------------------------------------- */
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Minimal io_uring instance, set up by means of the raw system calls.
+ * It maps the submission and completion rings shared with the kernel,
+ * hands out submission queue entries and lets the caller consume the
+ * completion queue entries.
+ * An instance is not thread-safe: it is meant to be owned by a single
+ * event loop thread.
+ */
+class IoUring
+{
+public:
+   using Handle = std::unique_ptr<IoUring>;
+
+   IoUring(const IoUring &) = delete;
+   IoUring &operator=(const IoUring &) = delete;
+   ~IoUring();
+
+   /**
+    * Creates a new io_uring instance
+    *
+    * @param entries is the submission queue size
+    * @return the instance handle or nullptr if io_uring is not
+    *         supported or cannot be set up
+    */
+   static Handle create(unsigned entries);
+
+   /**
+    * Returns true if the kernel supports all the given operations
+    * (IORING_OP_* codes)
+    */
+   bool isSupported(std::initializer_list<int> opcodes) const noexcept;
+
+   /**
+    * Registers a set of buffers with the kernel, which can then be
+    * referred by index in READ_FIXED / WRITE_FIXED operations
+    *
+    * @return true if operation successfully completed, false otherwise
+    */
+   bool registerBuffers(const iovec *iovecs, unsigned count) noexcept;
+
+   /**
+    * Returns the number of free submission queue entries
+    */
+   unsigned getSqSpaceLeft() const noexcept;
+
+   /**
+    * Returns a zeroed submission queue entry, or nullptr
+    * if the submission queue is full
+    */
+   io_uring_sqe *getSqe() noexcept;
+
+   /**
+    * Submits all the entries queued so far and waits for
+    * a minimum number of completions
+    *
+    * @param waitCount is the number of completions to wait for
+    * @return the number of submitted entries or a negated errno value
+    */
+   int submit(unsigned waitCount = 0) noexcept;
+
+   /**
+    * Consumes all the available completion queue entries, calling
+    * a given function for each of them
+    *
+    * @return the number of entries consumed
+    */
+   template <typename F>
+   unsigned forEachCqe(F &&func)
+   {
+      unsigned head = *_cqHead;
+      unsigned count = 0;
+
+      // The kernel publishes the entries before updating the tail
+      const unsigned tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+
+      while (head != tail)
+      {
+         // Copy the entry so the slot can be given back before
+         // the function possibly queues more work
+         const io_uring_cqe cqe = _cqes[head & _cqMask];
+         ++head;
+         ++count;
+
+         __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+
+         func(cqe);
+      }
+
+      return count;
+   }
+
+private:
+   int _ringFd = -1;
+   unsigned _features = 0;
+
+   void *_sqRing = nullptr;
+   size_t _sqRingSize = 0;
+   void *_cqRing = nullptr;
+   size_t _cqRingSize = 0;
+   io_uring_sqe *_sqes = nullptr;
+   size_t _sqesSize = 0;
+
+   unsigned *_sqHead = nullptr;
+   unsigned *_sqTail = nullptr;
+   unsigned _sqMask = 0;
+   unsigned _sqEntries = 0;
+   unsigned _sqeTail = 0;
+
+   unsigned *_cqHead = nullptr;
+   unsigned *_cqTail = nullptr;
+   unsigned _cqMask = 0;
+   io_uring_cqe *_cqes = nullptr;
+
+   std::unique_ptr<uint8_t[]> _supportedOps;
+   unsigned _supportedOpsCount = 0;
+
+   IoUring() = default;
+   bool init(unsigned entries);
+   void probe();
+};
+
+/* -------------------------------------------------------------------------- */
+
+#else
+
+/* -------------------------------------------------------------------------- */
+
+// io_uring is not available on this platform
+class IoUring
+{
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // HTTPSRV_IO_URING
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__IO_URING_H__
@@ -0,0 +1,124 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __JSON_WRITER_H__
+#define __JSON_WRITER_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include <cassert>
+#include <cstdint>
+#include <ctime>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Writes JSON text, indented by two spaces per level, appending it to
+ * a given buffer: the text is produced without temporary strings.
+ * Members and elements are written one per line, as in
+ *
+ * [
+ *   {
+ *     "name": "a.txt",
+ *     "size": 123
+ *   }
+ * ]
+ *
+ * and a new line follows the outermost value.
+ * The writer does not own the buffer, which can be drained (e.g. sent)
+ * between two values.
+ */
+class JsonWriter
+{
+public:
+   /**
+    * Constructs a writer appending to a given buffer
+    */
+   explicit JsonWriter(std::pmr::string &out) noexcept : _out(out)
+   {
+   }
+
+   JsonWriter(const JsonWriter &) = delete;
+   JsonWriter &operator=(const JsonWriter &) = delete;
+
+   //! Begins an array, member of an object if name is not empty
+   void beginArray(std::string_view name = std::string_view())
+   {
+      beginValue(name);
+      _out.append("[\n", 2);
+      push();
+   }
+
+   //! Ends the current array
+   void endArray()
+   {
+      endValue(']');
+   }
+
+   //! Begins an object, member of an object if name is not empty
+   void beginObject(std::string_view name = std::string_view())
+   {
+      beginValue(name);
+      _out.append("{\n", 2);
+      push();
+   }
+
+   //! Ends the current object
+   void endObject()
+   {
+      endValue('}');
+   }
+
+   //! Writes a string, which is escaped as needed
+   void value(std::string_view name, std::string_view str);
+
+   //! Writes an unsigned number
+   void value(std::string_view name, uint64_t number);
+
+   /**
+    * Writes a time as an ISO 8601 UTC timestamp string
+    * (e.g. "2020-01-01T17:40:46.560645Z")
+    *
+    * @param name is the member name
+    * @param t is the time since the epoch
+    * @param microseconds is the fraction of second
+    */
+   void timestamp(std::string_view name, std::time_t t, unsigned microseconds);
+
+private:
+   //! Max nesting level
+   static constexpr unsigned maxDepth = 32;
+
+   std::pmr::string &_out;
+   unsigned _depth = 0;
+
+   //! A bit for each nesting level, set once it holds a value
+   uint32_t _notEmpty = 0;
+
+   //! Writes the separator, the indentation and the name of a value
+   void beginValue(std::string_view name);
+
+   //! Closes an array or an object
+   void endValue(char bracket);
+
+   void push() noexcept
+   {
+      assert(_depth < maxDepth - 1);
+      ++_depth;
+      _notEmpty &= ~(uint32_t(1) << _depth);
+   }
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__JSON_WRITER_H__
@@ -0,0 +1,248 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __LOAD_SHEDDER_H__
+#define __LOAD_SHEDDER_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "HttpRouter.h"
+#include "TcpSocket.h"
+#include "config.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+/* -------------------------------------------------------------------------- */
+
+class JsonWriter;
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Overload protection shared by all the acceptors, event loops and
+ * sessions of a server.
+ * It bounds the number of open connections, of zip jobs in progress and
+ * of requests concurrently served by each endpoint. Any work exceeding
+ * a limit is shed at once with a 503 (Service Unavailable) response
+ * carrying a Retry-After header, and counted.
+ * Admissions are granted as tickets: the resource is released when
+ * the ticket is destroyed (e.g. along with the session or the reply
+ * holding it).
+ */
+class LoadShedder
+{
+public:
+   using Handle = std::shared_ptr<LoadShedder>;
+
+   //! Endpoints with their own concurrency budget
+   using Endpoint = HttpRouter::Endpoint;
+
+   static constexpr size_t endpointCount = HttpRouter::endpointCount;
+
+   //! Limits enforced, zero meaning unlimited
+   struct Limits
+   {
+      int maxConnections = HTTPSRV_MAX_CONNECTIONS_DEF;
+      int maxZipJobs = HTTPSRV_MAX_ZIP_JOBS_DEF;
+      int endpointBudget[endpointCount] = {};
+   };
+
+   //! Counters of the traffic shed so far
+   struct Stats
+   {
+      uint64_t connections = 0;
+      uint64_t zipJobs = 0;
+      uint64_t requests[endpointCount] = {};
+   };
+
+   /**
+    * Admission to a limited resource, released on destruction
+    */
+   class Ticket
+   {
+   public:
+      Ticket() = default;
+      Ticket(const Ticket &) = delete;
+      Ticket &operator=(const Ticket &) = delete;
+
+      Ticket(Ticket &&other) noexcept : _inUse(other._inUse)
+      {
+         other._inUse = nullptr;
+      }
+
+      Ticket &operator=(Ticket &&other) noexcept
+      {
+         if (this != &other)
+         {
+            release();
+            _inUse = other._inUse;
+            other._inUse = nullptr;
+         }
+
+         return *this;
+      }
+
+      ~Ticket()
+      {
+         release();
+      }
+
+      /**
+       * Returns true if the admission has been granted
+       */
+      explicit operator bool() const noexcept
+      {
+         return _inUse != nullptr;
+      }
+
+      /**
+       * Releases the resource, if any
+       */
+      void release() noexcept
+      {
+         if (_inUse)
+         {
+            _inUse->fetch_sub(1, std::memory_order_relaxed);
+            _inUse = nullptr;
+         }
+      }
+
+   private:
+      friend class LoadShedder;
+
+      explicit Ticket(std::atomic<int> *inUse) noexcept : _inUse(inUse)
+      {
+      }
+
+      std::atomic<int> *_inUse = nullptr;
+   };
+
+   LoadShedder(const LoadShedder &) = delete;
+   LoadShedder &operator=(const LoadShedder &) = delete;
+
+   /**
+    * Creates a new load shedder
+    *
+    * @param limits are the limits to enforce
+    * @return the handle or nullptr in case of failure
+    */
+   static Handle create(const Limits &limits)
+   {
+      return Handle(new (std::nothrow) LoadShedder(limits));
+   }
+
+   /**
+    * Admits a new connection, if the max number of open
+    * connections has not been reached
+    */
+   Ticket admitConnection() noexcept
+   {
+      return admit(_connections, _limits.maxConnections, _shedConnections);
+   }
+
+   /**
+    * Admits a new zip job (creation and transmission of an archive),
+    * if the max number of jobs in progress has not been reached
+    */
+   Ticket admitZipJob() noexcept
+   {
+      return admit(_zipJobs, _limits.maxZipJobs, _shedZipJobs);
+   }
+
+   /**
+    * Admits a request to a given endpoint, if its budget has
+    * not been exhausted
+    */
+   Ticket admitRequest(Endpoint endpoint) noexcept
+   {
+      const size_t i = size_t(endpoint);
+      return admit(_requests[i], _limits.endpointBudget[i], _shedRequests[i]);
+   }
+
+   /**
+    * Sheds a connection just accepted: the pre-serialized 503 response
+    * is written without reading any request and the connection is
+    * shut down.
+    *
+    * @param handle is the connected socket
+    */
+   void rejectConnection(const TcpSocket::Handle &handle) noexcept;
+
+   /**
+    * Counts a connection shed for a reason other than the connection
+    * limit (e.g. a full admission queue)
+    */
+   void countShedConnection() noexcept
+   {
+      _shedConnections.fetch_add(1, std::memory_order_relaxed);
+   }
+
+   /**
+    * Counts a request to a given endpoint shed for a reason other than
+    * its budget (e.g. a full worker pool)
+    */
+   void countShedRequest(Endpoint endpoint) noexcept
+   {
+      _shedRequests[size_t(endpoint)].fetch_add(1, std::memory_order_relaxed);
+   }
+
+   /**
+    * Returns the counters of the traffic shed so far
+    */
+   Stats getStats() const noexcept;
+
+   /**
+    * Writes the counters of the traffic shed so far as the member "shed"
+    * of the JSON object being written, holding a member for each
+    * connection, zip job and endpoint counter
+    *
+    * @param writer is the writer of the object
+    */
+   void jsonStats(JsonWriter &writer) const;
+
+   /**
+    * Returns the endpoint name used by the command line options
+    */
+   static const char *getEndpointName(Endpoint endpoint) noexcept;
+
+   /**
+    * Looks up an endpoint by name
+    *
+    * @param name is the endpoint name (e.g. "store")
+    * @param endpoint is set to the endpoint found
+    * @return false if there is no endpoint with such name
+    */
+   static bool findEndpoint(const std::string &name, Endpoint &endpoint) noexcept;
+
+private:
+   LoadShedder(const Limits &limits);
+
+   static Ticket admit(
+      std::atomic<int> &inUse,
+      int limit,
+      std::atomic<uint64_t> &shed) noexcept;
+
+   Limits _limits;
+
+   std::atomic<int> _connections{0};
+   std::atomic<int> _zipJobs{0};
+   std::atomic<int> _requests[endpointCount] = {};
+
+   std::atomic<uint64_t> _shedConnections{0};
+   std::atomic<uint64_t> _shedZipJobs{0};
+   std::atomic<uint64_t> _shedRequests[endpointCount] = {};
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__LOAD_SHEDDER_H__
@@ -0,0 +1,162 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __MPMC_QUEUE_H__
+#define __MPMC_QUEUE_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Bounded lock-free multi-producer/multi-consumer queue.
+ * It is based on an array of cells, each one tagged with a sequence number
+ * which tells producers and consumers whether the cell can be written or
+ * read in the current round (D. Vyukov's algorithm).
+ * The capacity is rounded up to a power of two.
+ */
+template <typename T>
+class MpmcQueue
+{
+public:
+   /**
+    * Constructs an empty queue
+    * @param capacity is the minimum number of items the queue can hold
+    */
+   explicit MpmcQueue(size_t capacity)
+   {
+      size_t size = 2;
+
+      while (size < capacity)
+         size <<= 1;
+
+      _buffer.reset(new Cell[size]);
+      _mask = size - 1;
+
+      for (size_t i = 0; i < size; ++i)
+         _buffer[i].sequence.store(i, std::memory_order_relaxed);
+   }
+
+   MpmcQueue(const MpmcQueue &) = delete;
+   MpmcQueue &operator=(const MpmcQueue &) = delete;
+
+   /**
+    * Returns the actual queue capacity
+    */
+   size_t capacity() const noexcept
+   {
+      return _mask + 1;
+   }
+
+   /**
+    * Appends an item to the queue
+    * @param item is the item to move into the queue
+    * @return false if the queue is full, true otherwise
+    */
+   bool push(T &&item)
+   {
+      Cell *cell = nullptr;
+      size_t pos = _enqueuePos.load(std::memory_order_relaxed);
+
+      while (true)
+      {
+         cell = &_buffer[pos & _mask];
+         const size_t seq = cell->sequence.load(std::memory_order_acquire);
+         const auto diff = intptr_t(seq) - intptr_t(pos);
+
+         if (diff == 0)
+         {
+            if (_enqueuePos.compare_exchange_weak(
+                   pos, pos + 1, std::memory_order_relaxed))
+            {
+               break;
+            }
+         }
+         else if (diff < 0)
+         {
+            return false; // full
+         }
+         else
+         {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+         }
+      }
+
+      cell->data = std::move(item);
+      cell->sequence.store(pos + 1, std::memory_order_release);
+
+      return true;
+   }
+
+   /**
+    * Extracts the oldest item from the queue
+    * @param item receives the extracted item
+    * @return false if the queue is empty, true otherwise
+    */
+   bool pop(T &item)
+   {
+      Cell *cell = nullptr;
+      size_t pos = _dequeuePos.load(std::memory_order_relaxed);
+
+      while (true)
+      {
+         cell = &_buffer[pos & _mask];
+         const size_t seq = cell->sequence.load(std::memory_order_acquire);
+         const auto diff = intptr_t(seq) - intptr_t(pos + 1);
+
+         if (diff == 0)
+         {
+            if (_dequeuePos.compare_exchange_weak(
+                   pos, pos + 1, std::memory_order_relaxed))
+            {
+               break;
+            }
+         }
+         else if (diff < 0)
+         {
+            return false; // empty
+         }
+         else
+         {
+            pos = _dequeuePos.load(std::memory_order_relaxed);
+         }
+      }
+
+      item = std::move(cell->data);
+      cell->sequence.store(pos + _mask + 1, std::memory_order_release);
+
+      return true;
+   }
+
+private:
+   struct Cell
+   {
+      std::atomic<size_t> sequence;
+      T data;
+   };
+
+   // Keep producers and consumers indexes on separate cache lines
+   enum { CACHE_LINE_SIZE = 64 };
+
+   std::unique_ptr<Cell[]> _buffer;
+   size_t _mask = 0;
+   alignas(CACHE_LINE_SIZE) std::atomic<size_t> _enqueuePos{0};
+   alignas(CACHE_LINE_SIZE) std::atomic<size_t> _dequeuePos{0};
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__MPMC_QUEUE_H__
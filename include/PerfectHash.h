@@ -0,0 +1,271 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __PERFECT_HASH_H__
+#define __PERFECT_HASH_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "StrUtils.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Perfect hash of a fixed set of keys, built at compile time.
+ * Keys are spread over buckets by a first hash, then the seed of a second
+ * hash is searched for each bucket, so that every key is given its own
+ * slot (the largest buckets are placed first, while most slots are
+ * free). A key is then found by hashing it once, mixing the hash twice
+ * and a single comparison, without allocating memory.
+ *
+ * @tparam N is the max number of keys
+ * @tparam IgnoreCase selects a case-insensitive (ASCII) lookup
+ */
+template <size_t N, bool IgnoreCase = false>
+class PerfectHash
+{
+public:
+   //! Number of slots, a power of two at least twice the number of keys
+   static constexpr size_t slots = [] {
+      size_t n = 2;
+
+      while (n < 2 * N)
+         n <<= 1;
+
+      return n;
+   }();
+
+   //! Number of buckets, a power of two holding four keys on average
+   static constexpr size_t buckets = slots / 8 ? slots / 8 : 1;
+
+   /**
+    * Builds the hash of a set of keys
+    *
+    * @param keys are the keys, distinct (regardless of case if IgnoreCase),
+    *        which hasDistinctKeys() tells
+    * @param count is the number of keys, the first count of keys
+    */
+   constexpr PerfectHash(const std::array<std::string_view, N> &keys, size_t count = N)
+   {
+      Buckets grouped;
+      size_t maxBucketSize = 0;
+
+      for (size_t i = 0; i < count; ++i)
+      {
+         grouped.hashes[i] = hash(keys[i]);
+         ++grouped.begin[bucketOf(grouped.hashes[i]) + 1];
+      }
+
+      // Keys are sorted by bucket
+      for (size_t bucket = 0; bucket < buckets; ++bucket)
+      {
+         const size_t size = grouped.begin[bucket + 1];
+         maxBucketSize = size > maxBucketSize ? size : maxBucketSize;
+         grouped.begin[bucket + 1] += grouped.begin[bucket];
+      }
+
+      std::array<size_t, buckets> next{};
+
+      for (size_t i = 0; i < count; ++i)
+      {
+         const size_t bucket = bucketOf(grouped.hashes[i]);
+         grouped.keys[grouped.begin[bucket] + next[bucket]++] = i;
+      }
+
+      for (auto &index : _index)
+         index = -1;
+
+      // Equal keys have the same hash, hence they share a bucket
+      for (size_t bucket = 0; bucket < buckets && _distinct; ++bucket)
+      {
+         for (size_t a = grouped.begin[bucket]; a < grouped.begin[bucket + 1]; ++a)
+         {
+            for (size_t b = a + 1; b < grouped.begin[bucket + 1] && _distinct; ++b)
+               _distinct = !equals(keys[grouped.keys[a]], keys[grouped.keys[b]]);
+         }
+      }
+
+      // No seed could ever separate equal keys
+      _perfect = _distinct;
+
+      for (size_t size = maxBucketSize; size > 0 && _perfect; --size)
+      {
+         for (size_t bucket = 0; bucket < buckets && _perfect; ++bucket)
+         {
+            if (grouped.begin[bucket + 1] - grouped.begin[bucket] == size)
+               _perfect = place(bucket, keys, grouped);
+         }
+      }
+   }
+
+   /**
+    * Returns true if a perfect hash has been found
+    */
+   constexpr bool isPerfect() const noexcept
+   {
+      return _perfect;
+   }
+
+   /**
+    * Returns true if no key has been given twice
+    */
+   constexpr bool hasDistinctKeys() const noexcept
+   {
+      return _distinct;
+   }
+
+   /**
+    * Searches a key
+    *
+    * @return the index of the key or -1 if not found
+    */
+   int find(std::string_view key) const noexcept
+   {
+      const uint32_t h = hash(key);
+      const size_t slot = slotOf(h, _seeds[bucketOf(h)]);
+      const int index = _index[slot];
+
+      if (index < 0)
+         return -1;
+
+      const bool found = IgnoreCase ?
+         StrUtils::iequals(_keys[slot], key) :
+         _keys[slot] == key;
+
+      return found ? index : -1;
+   }
+
+private:
+   //! FNV-1a hash, which folds ASCII letters to lowercase if IgnoreCase
+   static constexpr uint32_t hash(std::string_view key) noexcept
+   {
+      uint32_t h = 2166136261u;
+
+      for (char c : key)
+      {
+         h ^= uint8_t(IgnoreCase ? c | 0x20 : c);
+         h *= 16777619u;
+      }
+
+      return h;
+   }
+
+   //! Compares two keys, ignoring the case of ASCII letters if IgnoreCase
+   static constexpr bool equals(std::string_view a, std::string_view b) noexcept
+   {
+      if (a.size() != b.size())
+         return false;
+
+      for (size_t i = 0; i < a.size(); ++i)
+      {
+         const char ca = IgnoreCase && a[i] >= 'A' && a[i] <= 'Z' ? a[i] + 32 : a[i];
+         const char cb = IgnoreCase && b[i] >= 'A' && b[i] <= 'Z' ? b[i] + 32 : b[i];
+
+         if (ca != cb)
+            return false;
+      }
+
+      return true;
+   }
+
+   //! Mixes a hash with a seed, so that all the bits of the result
+   //! depend on all the bits of both (MurmurHash3 finalizer)
+   static constexpr uint32_t mix(uint32_t h, uint32_t seed) noexcept
+   {
+      h ^= seed * 0x9e3779b9u;
+      h ^= h >> 16;
+      h *= 0x85ebca6bu;
+      h ^= h >> 13;
+      h *= 0xc2b2ae35u;
+      h ^= h >> 16;
+
+      return h;
+   }
+
+   static constexpr size_t bucketOf(uint32_t h) noexcept
+   {
+      return mix(h, 0) & (buckets - 1);
+   }
+
+   static constexpr size_t slotOf(uint32_t h, uint32_t seed) noexcept
+   {
+      return mix(h, seed) & (slots - 1);
+   }
+
+   //! Keys grouped by bucket, used while building the hash
+   struct Buckets
+   {
+      //! Hash of each key
+      std::array<uint32_t, N> hashes{};
+
+      //! Indexes of the keys, sorted by bucket
+      std::array<size_t, N> keys{};
+
+      //! Position in keys of the first key of each bucket
+      std::array<size_t, buckets + 1> begin{};
+   };
+
+   //! Searches a seed placing the keys of a bucket into free slots
+   constexpr bool place(
+      size_t bucket,
+      const std::array<std::string_view, N> &keys,
+      const Buckets &grouped) noexcept
+   {
+      const size_t begin = grouped.begin[bucket];
+      const size_t end = grouped.begin[bucket + 1];
+
+      for (uint32_t seed = 1; seed < 0x10000; ++seed)
+      {
+         size_t placed = begin;
+
+         for (; placed < end; ++placed)
+         {
+            const size_t i = grouped.keys[placed];
+            const size_t slot = slotOf(grouped.hashes[i], seed);
+
+            if (_index[slot] >= 0)
+               break;
+
+            _index[slot] = int(i);
+            _keys[slot] = keys[i];
+         }
+
+         if (placed == end)
+         {
+            _seeds[bucket] = seed;
+            return true;
+         }
+
+         // Free the slots taken by this attempt
+         while (placed-- > begin)
+         {
+            const size_t i = grouped.keys[placed];
+            _index[slotOf(grouped.hashes[i], seed)] = -1;
+         }
+      }
+
+      return false;
+   }
+
+   bool _distinct = true;
+   bool _perfect = false;
+   std::array<uint32_t, buckets> _seeds{};
+   std::array<std::string_view, slots> _keys{};
+   std::array<int, slots> _index{};
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__PERFECT_HASH_H__
@@ -0,0 +1,131 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __REQUEST_ARENA_H__
+#define __REQUEST_ARENA_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Monotonic memory resource backing the objects which live as long as
+ * the requests of a connection (responses, JSON content, ...).
+ * Memory is carved out of blocks by bumping a pointer and is never given
+ * back one allocation at a time: it is all reclaimed by reset(), once
+ * the replies using it are over.
+ * Blocks are retained across resets. If a batch of requests needed more
+ * than one block, they are coalesced into one block large enough for the
+ * whole batch (up to a given limit), so that in steady state no memory
+ * is requested from the global allocator.
+ * An arena is not thread-safe: it is used by one session at a time.
+ */
+class RequestArena : public std::pmr::memory_resource
+{
+public:
+   //! Allocation counters
+   struct Stats
+   {
+      //! Allocations served by arenas
+      uint64_t allocations = 0;
+
+      //! Blocks requested from the global allocator
+      uint64_t heapAllocations = 0;
+
+      //! Resets, each one closing a batch of requests
+      uint64_t resets = 0;
+   };
+
+   /**
+    * Constructs an arena, which allocates no memory until it is used
+    *
+    * @param blockSize is the size of the first block
+    * @param maxRetainedSize is the max size retained across resets
+    */
+   explicit RequestArena(
+      size_t blockSize = HTTPSRV_REQUEST_ARENA_SIZE,
+      size_t maxRetainedSize = HTTPSRV_REQUEST_ARENA_RETAINED_MAX) noexcept
+      : _blockSize(blockSize), _maxRetainedSize(maxRetainedSize)
+   {
+   }
+
+   RequestArena(const RequestArena &) = delete;
+   RequestArena &operator=(const RequestArena &) = delete;
+
+   ~RequestArena();
+
+   /**
+    * Reclaims all the memory allocated so far, which must no longer
+    * be in use
+    */
+   void reset() noexcept;
+
+   /**
+    * Returns the counters of this arena
+    */
+   const Stats &getStats() const noexcept
+   {
+      return _stats;
+   }
+
+   /**
+    * Returns the counters of all the arenas, updated on each reset
+    */
+   static Stats getTotalStats() noexcept;
+
+private:
+   struct Block
+   {
+      Block *next;
+      size_t size;
+   };
+
+   size_t _blockSize = 0;
+   size_t _maxRetainedSize = 0;
+
+   // Blocks in use, the current one first
+   Block *_blocks = nullptr;
+   char *_cursor = nullptr;
+   char *_end = nullptr;
+
+   Stats _stats;
+   Stats _published;
+
+   void *do_allocate(size_t bytes, size_t alignment) override;
+
+   // Memory is reclaimed by reset()
+   void do_deallocate(void *, size_t, size_t) override
+   {
+   }
+
+   bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+   {
+      return this == &other;
+   }
+
+   //! Makes a new block of at least a given size the current one
+   void addBlock(size_t size);
+
+   //! Gives all the blocks back to the global allocator
+   void releaseBlocks() noexcept;
+
+   //! Adds the counters not yet published to the total ones
+   void publishStats() noexcept;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__REQUEST_ARENA_H__
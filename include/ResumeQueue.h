@@ -0,0 +1,82 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __RESUME_QUEUE_H__
+#define __RESUME_QUEUE_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "HttpSession.h"
+
+#include <mutex>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Sessions whose job has been run by the worker pool, waiting for their
+ * event loop to resume them.
+ * Any thread can queue a session, while the event loop is notified via
+ * an eventfd it watches along with the connections: the descriptor is
+ * written only when the queue was empty, so a burst of jobs completing
+ * costs a single wake-up.
+ */
+class ResumeQueue
+{
+public:
+   ResumeQueue() = default;
+   ResumeQueue(const ResumeQueue &) = delete;
+   ResumeQueue &operator=(const ResumeQueue &) = delete;
+   ~ResumeQueue();
+
+   /**
+    * Creates the notification descriptor
+    *
+    * @return false in case of failure
+    */
+   bool init() noexcept;
+
+   /**
+    * Returns the descriptor the event loop is notified through
+    */
+   int getFd() const noexcept
+   {
+      return _fd;
+   }
+
+   /**
+    * Queues a session to be resumed (thread-safe)
+    */
+   void push(const HttpSession::Handle &session);
+
+   /**
+    * Takes all the sessions queued so far. The notification must have
+    * been consumed before calling it, so that no session queued later
+    * is left behind.
+    *
+    * @param sessions is filled with the sessions to resume
+    */
+   void take(std::vector<HttpSession::Handle> &sessions);
+
+   /**
+    * Consumes the pending notification, waiting for it if the
+    * descriptor is not readable
+    */
+   void clearNotification() noexcept;
+
+private:
+   int _fd = -1;
+   std::mutex _mtx;
+   std::vector<HttpSession::Handle> _sessions;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__RESUME_QUEUE_H__
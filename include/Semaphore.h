@@ -0,0 +1,62 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __SEMAPHORE_H__
+#define __SEMAPHORE_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include <cstddef>
+#include <cstdint>
+
+#ifdef __linux__
+#include <atomic>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Counting semaphore (C++17 lacks std::counting_semaphore).
+ * On Linux the count is a futex word, so acquiring an available unit
+ * takes no system call and no lock; elsewhere it is guarded by a mutex.
+ */
+class Semaphore
+{
+public:
+   Semaphore() = default;
+   Semaphore(const Semaphore &) = delete;
+   Semaphore &operator=(const Semaphore &) = delete;
+
+   /**
+    * Releases a unit, waking up a thread waiting for it if any
+    */
+   void post() noexcept;
+
+   /**
+    * Acquires a unit, waiting for it to be released if none is available
+    */
+   void wait() noexcept;
+
+private:
+#ifdef __linux__
+   std::atomic<uint32_t> _count{0};
+#else
+   std::mutex _mtx;
+   std::condition_variable _cv;
+   size_t _count = 0;
+#endif
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__SEMAPHORE_H__
@@ -14,8 +14,11 @@
 /* -------------------------------------------------------------------------- */
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
+#include <cstddef>
+#include <iterator>
 
 /* -------------------------------------------------------------------------- */
 
@@ -31,6 +34,124 @@ namespace StrUtils
  */
 void removeLastCharIf(std::string &s, char c);
 
+/**
+ * Lazy range over the tokens of a string separated by a given separator.
+ * Tokens are views of the string characters, so nothing is copied, and
+ * each token is searched only when the iteration reaches it.
+ * A separator following the last token does not delimit a further
+ * (empty) token.
+ */
+class Tokenizer
+{
+public:
+   class Iterator
+   {
+   public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = std::string_view;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const std::string_view *;
+      using reference = const std::string_view &;
+
+      Iterator() = default;
+
+      Iterator(std::string_view str, std::string_view sep) noexcept
+         : _rest(str), _sep(sep), _done(false)
+      {
+         next();
+      }
+
+      reference operator*() const noexcept
+      {
+         return _token;
+      }
+
+      pointer operator->() const noexcept
+      {
+         return &_token;
+      }
+
+      Iterator &operator++() noexcept
+      {
+         next();
+         return *this;
+      }
+
+      Iterator operator++(int) noexcept
+      {
+         Iterator it = *this;
+         next();
+         return it;
+      }
+
+      bool operator==(const Iterator &other) const noexcept
+      {
+         return _done == other._done &&
+            (_done || (_token.data() == other._token.data() &&
+                       _token.size() == other._token.size()));
+      }
+
+      bool operator!=(const Iterator &other) const noexcept
+      {
+         return !(*this == other);
+      }
+
+   private:
+      std::string_view _token;
+      std::string_view _rest;
+      std::string_view _sep;
+      bool _done = true;
+
+      void next() noexcept
+      {
+         if (_rest.empty())
+         {
+            _done = true;
+            return;
+         }
+
+         const size_t pos = _sep.empty() ? std::string_view::npos : _rest.find(_sep);
+
+         _token = _rest.substr(0, pos);
+
+         if (pos == std::string_view::npos)
+            _rest = std::string_view();
+         else
+            _rest.remove_prefix(pos + _sep.size());
+      }
+   };
+
+   Tokenizer(std::string_view str, std::string_view sep) noexcept
+      : _str(str), _sep(sep)
+   {
+   }
+
+   Iterator begin() const noexcept
+   {
+      return Iterator(_str, _sep);
+   }
+
+   Iterator end() const noexcept
+   {
+      return Iterator();
+   }
+
+private:
+   std::string_view _str;
+   std::string_view _sep;
+};
+
+/**
+ * Returns the range of the tokens of a string
+ *
+ * @param str The string to split, which must outlive the range
+ * @param sep The separator used to recognize the tokens
+ */
+inline Tokenizer tokenize(std::string_view str, std::string_view sep) noexcept
+{
+   return Tokenizer(str, sep);
+}
+
 /**
  * Splits a text line into a vector of tokens.
  *
@@ -51,6 +172,30 @@ bool splitLineInTokens(const std::string &line,
  */
 std::string trim(const std::string &str);
 
+/**
+ * Eliminates leading and trailing spaces a give string view
+ *
+ * @param str string to trim
+ * @return the trimmed view, referring to the same characters
+ */
+std::string_view trimView(std::string_view str) noexcept;
+
+/**
+ * Compares two strings ignoring the case of ASCII letters
+ *
+ * @return true if the strings are equal, false otherwise
+ */
+bool iequals(std::string_view a, std::string_view b) noexcept;
+
+/**
+ * Returns true if a string begins with a given prefix, ignoring
+ * the case of ASCII letters
+ */
+inline bool istartsWith(std::string_view str, std::string_view prefix) noexcept
+{
+   return str.size() >= prefix.size() && iequals(str.substr(0, prefix.size()), prefix);
+}
+
 /**
  * Convert a given string to uppercase
  *
@@ -64,6 +209,51 @@ inline static std::string uppercase(const std::string &str)
    return ret;
 }
 
+/**
+ * Returns true if a character has to be escaped in a JSON string
+ */
+inline bool needsJsonEscape(char ch) noexcept
+{
+   return static_cast<unsigned char>(ch) < 0x20 || ch == '"' || ch == '\\';
+}
+
+/**
+ * Writes the JSON escape sequence of a character
+ *
+ * @param ch is a character for which needsJsonEscape() is true
+ * @param seq receives the sequence, at most 6 characters
+ * @return the length of the sequence
+ */
+size_t makeJsonEscape(char ch, char *seq) noexcept;
+
+/**
+ * Escapes a string to make it valid for JSON format requirements,
+ * appending it to a given buffer. A string with no character to
+ * escape is appended by a single copy.
+ *
+ * @param str is the string to escape
+ * @param out is the buffer (a string of any allocator)
+ */
+template <typename String>
+void escapeJson(std::string_view str, String &out)
+{
+   size_t begin = 0;
+
+   for (size_t i = 0; i < str.size(); ++i)
+   {
+      if (!needsJsonEscape(str[i]))
+         continue;
+
+      char seq[6];
+
+      out.append(str.data() + begin, i - begin);
+      out.append(seq, makeJsonEscape(str[i], seq));
+      begin = i + 1;
+   }
+
+   out.append(str.data() + begin, str.size() - begin);
+}
+
 /**
  * Escapes a string to make it valid for JSON format requirements
  * @param str is the string to escape
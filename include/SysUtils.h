@@ -51,10 +51,12 @@ typedef int errno_t;
 
 /* -------------------------------------------------------------------------- */
 
+#include <cstdint>
 #include <string>
 #include <regex>
 #include <chrono>
 #include <ctime>
+#include <string_view>
 
 /* -------------------------------------------------------------------------- */
 
@@ -87,6 +89,51 @@ bool initCommunicationLib();
  */
 int closeSocketFd(int sd);
 
+/**
+ * Enables or disables the non-blocking mode of a socket descriptor.
+ *
+ * @param sd socket descriptor
+ * @param on true to enable the non-blocking mode, false to disable it
+ * @return true if operation is sucessfully completed, false otherwise
+ */
+bool setNonBlockingSocketFd(int sd, bool on);
+
+/**
+ * Returns true if last socket operation failed because it would
+ * block the caller (applies to non-blocking sockets)
+ */
+bool isWouldBlockSocketError();
+
+/**
+ * Pins the calling thread to a given CPU
+ *
+ * @param cpu is the CPU index
+ * @return true if operation is sucessfully completed, false otherwise
+ */
+bool setThreadCpuAffinity(int cpu);
+
+/**
+ * Opens a file in read-only binary mode
+ *
+ * @param path is the file path
+ * @param size is set to the file size in bytes
+ * @return the file descriptor, or -1 on error
+ */
+int openFileForReading(const char *path, uint64_t &size);
+
+/**
+ * Reads from a file descriptor starting from a given offset,
+ * leaving the file position unchanged where the platform allows it
+ *
+ * @return the number of bytes read, or -1 on error
+ */
+int readFileAt(int fd, char *buf, size_t len, uint64_t offset);
+
+/**
+ * Closes a file descriptor opened by openFileForReading()
+ */
+void closeFile(int fd);
+
 /**
  * Gets the system UTC time
  * Time format is "DoW Mon dd hh:mm:ss yyyy"
@@ -110,6 +157,40 @@ inline std::string getUtcTime()
    return lt;
 }
 
+//! Length of an HTTP date, e.g. "Sun, 06 Nov 1994 08:49:37 GMT"
+constexpr size_t httpDateLength = 29;
+
+/**
+ * Formats a time in the HTTP date format (RFC 7231 IMF-fixdate).
+ * It is thread-safe and does not depend on the locale.
+ *
+ * @param t is the time since the epoch
+ * @param buf receives httpDateLength characters (not null-terminated)
+ */
+void formatHttpDate(std::time_t t, char *buf) noexcept;
+
+//! Length of an ISO 8601 timestamp, e.g. "2020-01-01T17:40:46.560645Z"
+constexpr size_t isoTimestampLength = 27;
+
+/**
+ * Formats a time as an ISO 8601 UTC timestamp with microseconds
+ * (YYYY-MM-DDTHH:MM:SS.uuuuuuZ).
+ * It is thread-safe and does not depend on the locale.
+ *
+ * @param t is the time since the epoch
+ * @param microseconds is the fraction of second, less than 1000000
+ * @param buf receives isoTimestampLength characters (not null-terminated)
+ */
+void formatIsoTimestamp(std::time_t t, unsigned microseconds, char *buf) noexcept;
+
+/**
+ * Returns the current time in the HTTP date format.
+ * Each thread formats the date at most once per second and keeps it
+ * in a buffer of its own: the view returned is valid until the calling
+ * thread calls this function again.
+ */
+std::string_view getHttpDate() noexcept;
+
 } // namespace SysUtils
 
 /* -------------------------------------------------------------------------- */
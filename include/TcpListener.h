@@ -82,6 +82,16 @@ public:
       return ::listen(getSocketFd(), backlog) == 0;
    }
 
+   /**
+    * Allows multiple listeners to bind to the same port, letting the
+    * kernel distribute the incoming connections among them.
+    * It must be called before bind().
+    *
+    * @param on true to enable the port reusing, false otherwise
+    * @return true if operation successfully completed, false otherwise
+    */
+   bool setReusePort(bool on = true);
+
    /**
     * Extracts the first connection on the queue of pending connections,
     * and creates a new tcp connection handle
@@ -90,6 +100,17 @@ public:
     */
    TcpSocket::Handle accept();
 
+   /**
+    * Creates a tcp connection handle for a connection accepted on this
+    * listener by other means (e.g. by an asynchronous accept operation).
+    * The handle takes ownership of the socket descriptor, which is
+    * closed if the operation fails.
+    *
+    * @param sd is the descriptor of the accepted connection
+    * @return an handle to a new tcp connection or nullptr on error
+    */
+   TcpSocket::Handle attach(SocketFd sd);
+
 private:
    std::atomic<Status> _status;
    TcpListener();
@@ -0,0 +1,173 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __TIMER_WHEEL_H__
+#define __TIMER_WHEEL_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Hashed timer wheel.
+ * Time is split in ticks of fixed length and each timer is linked into the
+ * slot of the tick it expires at (modulo the number of slots), so starting,
+ * restarting and cancelling a timer take constant time, whatever the number
+ * of timers. Timers are embedded in the objects they refer to (e.g. the
+ * connections of an event loop), so the wheel does not allocate any memory
+ * for them.
+ * The wheel is not thread-safe: it is meant to be owned by an event loop.
+ */
+class TimerWheel
+{
+public:
+   using Clock = std::chrono::steady_clock;
+
+   /**
+    * Timer linked into a wheel while pending
+    */
+   class Timer
+   {
+   public:
+      Timer() = default;
+      Timer(const Timer &) = delete;
+      Timer &operator=(const Timer &) = delete;
+
+      ~Timer()
+      {
+         cancel();
+      }
+
+      /**
+       * Returns true if the timer is running
+       */
+      bool isPending() const noexcept
+      {
+         return _pprev != nullptr;
+      }
+
+      /**
+       * Stops the timer, if running
+       */
+      void cancel() noexcept;
+
+   private:
+      friend class TimerWheel;
+
+      TimerWheel *_wheel = nullptr;
+      Timer **_pprev = nullptr;
+      Timer *_next = nullptr;
+      uint64_t _expiryTick = 0;
+      int _id = 0;
+   };
+
+   /**
+    * Constructs a wheel
+    *
+    * @param slots is the number of slots
+    * @param tick is the timer resolution
+    */
+   TimerWheel(size_t slots, std::chrono::milliseconds tick);
+
+   TimerWheel(const TimerWheel &) = delete;
+   TimerWheel &operator=(const TimerWheel &) = delete;
+
+   /**
+    * Starts (or restarts) a timer
+    *
+    * @param timer is the timer
+    * @param id identifies the timer when it expires
+    * @param timeout is the interval after which the timer expires
+    */
+   void start(Timer &timer, int id, std::chrono::milliseconds timeout) noexcept;
+
+   /**
+    * Returns the number of running timers
+    */
+   size_t getPendingCount() const noexcept
+   {
+      return _pendingCount;
+   }
+
+   /**
+    * Returns the time to wait (in milliseconds) until next tick,
+    * or -1 if no timer is running
+    */
+   int getWaitTimeout() const noexcept;
+
+   /**
+    * Advances the wheel up to now, calling a given function
+    * with the id of each expired timer
+    *
+    * @param onExpired is the function to call (e.g. void(int id)),
+    *        which may start or cancel any timer
+    */
+   template <typename F>
+   void expire(F onExpired)
+   {
+      _expiredIds.clear();
+
+      const uint64_t nowTick = getTick(Clock::now());
+
+      // After a long wait each slot is visited once at most
+      const uint64_t steps = std::min(
+          nowTick - _currentTick, uint64_t(_slots.size()));
+
+      _currentTick = nowTick;
+
+      for (uint64_t tick = nowTick - steps + 1; tick <= nowTick; ++tick)
+      {
+         Timer **pprev = &_slots[tick % _slots.size()];
+
+         while (*pprev)
+         {
+            Timer *timer = *pprev;
+
+            // Timers of later rounds are left in place
+            if (timer->_expiryTick > nowTick)
+            {
+               pprev = &timer->_next;
+               continue;
+            }
+
+            timer->cancel();
+            _expiredIds.push_back(timer->_id);
+         }
+      }
+
+      // Callbacks are invoked once the wheel has been updated
+      for (const int id : _expiredIds)
+         onExpired(id);
+   }
+
+private:
+   std::vector<Timer *> _slots;
+   std::chrono::milliseconds _tick;
+   Clock::time_point _origin;
+   uint64_t _currentTick = 0;
+   size_t _pendingCount = 0;
+   std::vector<int> _expiredIds;
+
+   uint64_t getTick(Clock::time_point t) const noexcept
+   {
+      return uint64_t(std::chrono::duration_cast<std::chrono::milliseconds>(
+         t - _origin).count() / _tick.count());
+   }
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__TIMER_WHEEL_H__
@@ -18,10 +18,22 @@
 
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 
 /* -------------------------------------------------------------------------- */
 
+/**
+ * Memory region to be sent by a gather operation (@see TransportSocket::sendv())
+ */
+struct IoSlice
+{
+   const char *data = nullptr;
+   size_t size = 0;
+};
+
+/* -------------------------------------------------------------------------- */
+
 /**
  * Provides socket functionality
  */
@@ -85,6 +97,17 @@ public:
     */
    RecvEvent waitForRecvEvent(const TimeoutInterval &timeout);
 
+   /**
+    * Enables or disables the non-blocking mode of this socket
+    *
+    * @param on true to enable the non-blocking mode, false to disable it
+    * @return true if operation successfully completed, false otherwise
+    */
+   bool setNonBlocking(bool on = true) noexcept
+   {
+      return SysUtils::setNonBlockingSocketFd(getSocketFd(), on);
+   }
+
    /**
     * Returns the socket descriptor for this socket
     */
@@ -114,6 +137,24 @@ public:
       return ::send(getSocketFd(), buf, len, flags);
    }
 
+   /**
+    * Sends a sequence of memory regions on a connected socket by a single
+    * gather operation (like writev())
+    *
+    * @param slices A pointer to an array of memory regions
+    * @param count  The number of regions, up to HTTPSRV_IOV_MAX
+    * @param more   If true, more data is about to follow: where the
+    *               platform allows it (MSG_MORE), the data is held back
+    *               in order to be coalesced with the next send operation
+    *               instead of leaving in a partially filled segment
+    * @return      If no error occurs, sendv() returns the total number
+    *              of bytes sent, which can be less than the overall size
+    *              of the regions.
+    *              Otherwise, -1 is returned, and a specific error code
+    *              can be retrieved by calling errno
+    */
+   long sendv(const IoSlice *slices, size_t count, bool more = false) noexcept;
+
    /**
     * Receives data from a connected socket
     *
@@ -154,14 +195,33 @@ public:
     * Sends a file on a connected socket
     *
     * @param filepath String containing the path of existing file
-    * @return      If no error occurs, send() returns the total number
-    *              of bytes sent, which can be less than the number
-    *              requested to be sent in the len parameter.
+    * @return      If no error occurs, sendFile() returns the total number
+    *              of bytes sent, which can be less than the file size
+    *              if the file has been truncated meanwhile.
     *              Otherwise, -1 is returned, and a specific error code
     *              can be retrieved by errno
     */
    int sendFile(const std::string &filepath) noexcept;
 
+   /**
+    * Sends a region of an open file on a connected socket.
+    * Where the platform allows it (sendfile() or splice() on Linux) the
+    * data is moved from the file to the socket by the kernel, without
+    * being copied to user space; otherwise it is read into a pooled
+    * buffer and sent.
+    *
+    * @param fd     The file descriptor
+    * @param offset The file offset the region starts from. It is advanced
+    *               by the number of bytes sent.
+    * @param count  The region size in bytes
+    * @return      If no error occurs, sendFile() returns the number of
+    *              bytes sent, which can be less than count (e.g. for a
+    *              non-blocking socket), or zero at the end of file.
+    *              Otherwise, -1 is returned, and a specific error code
+    *              can be retrieved by errno
+    */
+   long sendFile(int fd, uint64_t &offset, size_t count) noexcept;
+
    /**
    * Associates a local IPv4 address and TCP port with this
    * connection.
@@ -185,7 +245,27 @@ public:
 
 private:
    SocketFd _socket = 0;
-   enum { TX_BUFFER_SIZE = HTTPSRV_TX_BUF_SIZE };
+
+   long sendFileBuffered(int fd, uint64_t &offset, size_t count) noexcept;
+#ifdef __linux__
+   //! Pipe a file is moved through by splice(), kept open along with
+   //! the connection, holding the bytes of a file region not sent yet
+   struct SplicePipe
+   {
+      int readFd = -1;
+      int writeFd = -1;
+
+      //! File region the bytes in the pipe belong to
+      int fd = -1;
+      uint64_t offset = 0;
+      size_t pending = 0;
+   };
+
+   SplicePipe _splicePipe;
+
+   long spliceFile(int fd, uint64_t &offset, size_t count) noexcept;
+   void closeSplicePipe() noexcept;
+#endif
 
 protected:
    sockaddr_in _local_ip_port_sa_in;
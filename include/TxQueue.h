@@ -0,0 +1,129 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __TX_QUEUE_H__
+#define __TX_QUEUE_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "IoChannel.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory_resource>
+#include <optional>
+#include <string>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Queue of data waiting to be sent on a connection.
+ * It holds a sequence of memory slices (e.g. status line, headers, body)
+ * and file regions. Consecutive memory slices are sent by a single gather
+ * operation, flagged as followed by more data when a file region comes
+ * next, so the response header and the file content can share the same
+ * TCP segments. The progress of partial sends is tracked byte by byte.
+ * The segments are allocated from a given memory resource (e.g. the
+ * arena of a connection), which must be reset only once the queue
+ * has been released.
+ */
+class TxQueue
+{
+public:
+   explicit TxQueue(
+      std::pmr::memory_resource *memory = std::pmr::get_default_resource()) noexcept
+      : _memory(memory)
+   {
+   }
+
+   TxQueue(const TxQueue &) = delete;
+   TxQueue &operator=(const TxQueue &) = delete;
+
+   ~TxQueue()
+   {
+      clear();
+   }
+
+   /**
+    * Appends a memory slice which is not owned by the queue: the caller
+    * must keep it valid and unchanged until it has been sent
+    */
+   void append(const char *data, size_t size);
+
+   /**
+    * Appends a memory slice owned by the queue
+    */
+   void append(std::string &&data);
+
+   /**
+    * Appends a region of an open file. The queue takes ownership of the
+    * file descriptor, which is closed once the region has been sent.
+    */
+   void appendFile(int fd, uint64_t offset, uint64_t size);
+
+   /**
+    * Returns true if no data is waiting to be sent
+    */
+   bool isEmpty() const noexcept
+   {
+      return !_segments || _segments->empty();
+   }
+
+   /**
+    * Sends the queued data until the queue is empty, an error occurs
+    * or the channel would block.
+    *
+    * @return IoChannel::Status::done if all the data has been sent
+    */
+   IoChannel::Status flush(IoChannel &channel);
+
+   /**
+    * Discards any queued data
+    */
+   void clear();
+
+   /**
+    * Discards any queued data and gives the memory of the segments back
+    * to the resource, which is asked for it again by next append
+    */
+   void release();
+
+private:
+   struct Segment
+   {
+      // Memory slice, data points into buffer if owned
+      std::string buffer;
+      const char *data = nullptr;
+      size_t size = 0;
+
+      // File region, valid if fd >= 0
+      int fd = -1;
+      uint64_t fileOffset = 0;
+      uint64_t fileSize = 0;
+   };
+
+   std::pmr::memory_resource *_memory = nullptr;
+
+   // Built on the first append following a release
+   std::optional<std::pmr::deque<Segment>> _segments;
+
+   //! Appends a new segment
+   Segment &newSegment();
+
+   //! Drops the first bytes of the leading memory slices
+   void consume(size_t size);
+
+   //! Removes the leading segment, closing its file if any
+   void popFront();
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__TX_QUEUE_H__
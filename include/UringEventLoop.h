@@ -0,0 +1,169 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __URING_EVENT_LOOP_H__
+#define __URING_EVENT_LOOP_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "TcpListener.h"
+#include "HttpSession.h"
+#include "FileRepository.h"
+#include "ResumeQueue.h"
+#include "TimerWheel.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+
+class IoUring;
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * io_uring proactor.
+ * An event loop of this kind drives on a single thread the HTTP sessions
+ * of the connections it accepts, exactly as EventLoop does, but performs
+ * accept, receive, send and file read operations asynchronously through
+ * the submission and completion rings of an io_uring instance, so that a
+ * single system call both submits a batch of operations and collects the
+ * completed ones.
+ *
+ * - Connections are accepted by a multishot accept operation posted on
+ *   the listener (falling back to single-shot accepts on older kernels).
+ * - Receive buffers are provided to the kernel in advance, and picked up
+ *   only when data arrives, so idle connections do not hold any memory.
+ * - File contents are read into buffers registered with the kernel and
+ *   sent from there by a linked write operation.
+ * - Idle connections are closed by the timers of a hashed timer wheel,
+ *   which is advanced by a timeout operation posted on the ring.
+ * - Sessions whose blocking job has been run by the worker pool are
+ *   resumed once a read posted on the eventfd of a resume queue completes.
+ */
+class UringEventLoop
+{
+public:
+   using Handle = std::unique_ptr<UringEventLoop>;
+
+   UringEventLoop(const UringEventLoop &) = delete;
+   UringEventLoop &operator=(const UringEventLoop &) = delete;
+   ~UringEventLoop();
+
+   /**
+    * Returns true if the running kernel supports all the io_uring
+    * features required by this event loop
+    */
+   static bool isSupported() noexcept;
+
+   /**
+    * Creates a new event loop serving connections accepted
+    * by a given listener.
+    *
+    * @param listener is the listening socket
+    * @param verboseModeOn enables logging
+    * @param loggerOStream is the output stream used for logging
+    * @param fileRepository is the repository handle
+    * @param sessionConfig is the configuration of the sessions
+    * @return the event loop handle or nullptr in case of failure
+    */
+   static Handle create(
+       TcpListener &listener,
+       bool verboseModeOn,
+       std::ostream &loggerOStream,
+       FileRepository::Handle fileRepository,
+       const HttpSession::Config &sessionConfig);
+
+   /**
+    * Runs the event loop. This function is blocking for the caller.
+    *
+    * @return false if operation failed, otherwise the function
+    * doesn't return ever
+    */
+   bool run();
+
+private:
+   class Channel;
+
+   struct Connection
+   {
+      HttpSession::Handle session;
+      std::unique_ptr<Channel> channel;
+      TimerWheel::Timer idleTimer;
+      bool closing = false;
+   };
+
+   TcpListener &_listener;
+   bool _verboseModeOn = false;
+   std::ostream &_logger;
+   FileRepository::Handle _fileRepository;
+   HttpSession::Config _sessionConfig;
+
+   std::unique_ptr<IoUring> _ring;
+   bool _multishotAccept = true;
+
+   std::unique_ptr<char[]> _recvBuffers;
+   unsigned _availableRecvBuffers = 0;
+   std::unique_ptr<char[]> _fixedBuffers;
+   std::vector<int> _freeFixedBuffers;
+
+   // Connections waiting for a buffer to be released
+   std::deque<int> _recvBufferWaiters;
+   std::deque<int> _fixedBufferWaiters;
+
+   // Connections to be resumed out of any completion
+   std::vector<int> _readyConnections;
+
+   // Sessions whose job has been run by the worker pool
+   ResumeQueue _resumeQueue;
+   uint64_t _resumeCounter = 0;
+   std::vector<HttpSession::Handle> _resumed;
+
+   TimerWheel _timerWheel;
+   bool _tickArmed = false;
+
+   std::unordered_map<int, Connection> _connections;
+
+   UringEventLoop(
+       TcpListener &listener,
+       bool verboseModeOn,
+       std::ostream &loggerOStream,
+       FileRepository::Handle fileRepository,
+       const HttpSession::Config &sessionConfig);
+
+   bool init();
+
+   void armAccept();
+   void armAcceptRetry();
+   void armTick();
+   void armResume();
+   void onAccept(int res, uint32_t flags);
+   void onCompletion(uint64_t userData, int res, uint32_t flags);
+
+   void resume(int sd);
+   void resumeSessions();
+   void closeConnection(std::unordered_map<int, Connection>::iterator it);
+   void onIdleTimeout(int sd);
+
+   char *getRecvBuffer(unsigned bufferId) const noexcept;
+   void provideRecvBuffers(unsigned firstBufferId, unsigned count);
+   void waitForRecvBuffer(int sd);
+   int acquireFixedBuffer() noexcept;
+   void releaseFixedBuffer(int index);
+   char *getFixedBuffer(int index) const noexcept;
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__URING_EVENT_LOOP_H__
@@ -0,0 +1,152 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#ifndef __WORKER_POOL_H__
+#define __WORKER_POOL_H__
+
+/* -------------------------------------------------------------------------- */
+
+#include "HttpSession.h"
+#include "MpmcQueue.h"
+#include "Semaphore.h"
+#include "TimerWheel.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * Fixed-size pool of worker threads executing HTTP sessions.
+ * Sessions are submitted through a bounded lock-free admission queue,
+ * so the number of sessions concurrently served and the ones waiting
+ * for a worker are both limited. A worker sleeps on a semaphore only
+ * once the queue is empty, and it is posted only while some worker is
+ * asleep, so neither submitting nor taking a session takes a lock.
+ * A worker serves a session as long as it has requests to process: once
+ * its connection is idle (kept alive, with no request pending) the
+ * session is handed over to the idle poller of the pool, a thread
+ * waiting for any of such connections to become readable (epoll), which
+ * submits the session again. Idle connections are closed by the poller
+ * once their timeout expires (timers are kept in a timer wheel), so they
+ * never hold a worker.
+ * The pool also runs the blocking jobs of the sessions driven by event
+ * loops (@see HttpSession::runJob()), which need no idle poller.
+ */
+class WorkerPool
+{
+public:
+   using Handle = std::unique_ptr<WorkerPool>;
+
+   //! Called for a session which cannot be submitted again once its
+   //! connection is readable, since the admission queue is full
+   using RejectHandler = std::function<void(const HttpSession::Handle &)>;
+
+   WorkerPool(const WorkerPool &) = delete;
+   WorkerPool &operator=(const WorkerPool &) = delete;
+
+   /**
+    * Creates a new pool and starts its worker threads
+    *
+    * @param workers is the number of worker threads
+    * @param queueSize is the admission queue capacity
+    * @param onRejected is called for an idle session which cannot be
+    *        resumed (the session is terminated afterwards); if empty,
+    *        no idle poller is started
+    * @return the pool handle or nullptr in case of failure
+    */
+   static Handle create(int workers, int queueSize, RejectHandler onRejected);
+
+   ~WorkerPool();
+
+   /**
+    * Submits a session to be executed by a worker thread.
+    * This function never blocks the caller.
+    *
+    * @param session is the session handle
+    * @return false if the admission queue is full, true otherwise
+    */
+   bool submit(HttpSession::Handle session);
+
+private:
+   WorkerPool(int queueSize, RejectHandler onRejected) :
+      _queue(size_t(queueSize)),
+      _onRejected(std::move(onRejected)),
+      _timerWheel(
+         HTTPSRV_TIMER_WHEEL_SLOTS, 
+         std::chrono::milliseconds(HTTPSRV_TIMER_WHEEL_TICK_MS))
+   {
+   }
+
+   bool start(int workers);
+   void runWorker();
+
+   //! Takes the next session submitted, waiting for it if the
+   //! admission queue is empty
+   HttpSession::Handle take();
+
+   //! Hands over a session whose connection is idle to the idle poller
+   void park(HttpSession::Handle session);
+
+   //! Runs the idle poller
+   void runIdlePoller();
+
+   //! Starts waiting for the sessions handed over by the workers
+   void watchParkedSessions();
+
+   //! Stops waiting for the connection of a session, returning it
+   HttpSession::Handle unwatch(int sd);
+
+   MpmcQueue<HttpSession::Handle> _queue;
+
+   // Wakes up the workers asleep, found the queue empty
+   Semaphore _wakeUp;
+   std::atomic<int> _sleepingWorkers{0};
+
+   RejectHandler _onRejected;
+
+   // Sessions handed over to the idle poller, which is woken up
+   // through an event descriptor
+   std::mutex _parkedMtx;
+   std::vector<HttpSession::Handle> _parked;
+   int _wakeFd = -1;
+
+   // Sessions taken over by the idle poller, swapped with the ones
+   // parked so that both vectors retain their capacity
+   std::vector<HttpSession::Handle> _watched;
+
+   // Idle connections, owned by the idle poller thread
+   struct IdleConnection
+   {
+      HttpSession::Handle session;
+      TimerWheel::Timer idleTimer;
+   };
+
+   using IdleConnections = std::unordered_map<int, IdleConnection>;
+
+   int _epollFd = -1;
+   TimerWheel _timerWheel;
+   IdleConnections _idleConnections;
+
+   // Nodes of the connections no longer idle, reused by the next ones
+   // parked, so that parking a session allocates no memory
+   std::vector<IdleConnections::node_type> _spareConnections;
+
+   //! Adds the idle connection of a given descriptor
+   IdleConnection &addIdleConnection(int sd);
+};
+
+/* -------------------------------------------------------------------------- */
+
+#endif // !__WORKER_POOL_H__
@@ -26,18 +26,65 @@
 #define HTTPSRV_MAJ_V 1
 #define HTTPSRV_MIN_V 0
 #define HTTPSRV_TX_BUF_SIZE 0x100000
+#define HTTPSRV_RX_BUF_SIZE 0x4000
+#define HTTPSRV_FILE_CHUNK_SIZE 0x10000
+#define HTTPSRV_FILE_CHUNK_POOL_SIZE 64
+#define HTTPSRV_LISTING_CHUNK_SIZE 0x4000
+#define HTTPSRV_IOV_MAX 64
+#define HTTPSRV_EPOLL_MAX_EVENTS 256
+#define HTTPSRV_URING_ENTRIES 1024
+#define HTTPSRV_URING_RECV_BUFFERS 256
+#define HTTPSRV_URING_FIXED_BUFFERS 64
+#define HTTPSRV_EVENT_LOOPS_MAX 256
+#define HTTPSRV_ACCEPTORS_MAX 256
+#define HTTPSRV_WORKER_THREADS_DEF 16
+#define HTTPSRV_WORKER_THREADS_MAX 4096
+#define HTTPSRV_WORKER_QUEUE_DEF 1024
+#define HTTPSRV_WORKER_QUEUE_MAX 0x100000
 #define HTTPSRV_BACKLOG SOMAXCONN
-#define HTTP_CONNECTION_TIMEOUT_MS 10
+#define HTTPSRV_KEEPALIVE_TIMEOUT_DEF 5
+#define HTTPSRV_KEEPALIVE_TIMEOUT_MAX 3600
+#define HTTPSRV_KEEPALIVE_REQUESTS_DEF 1000
+#define HTTPSRV_KEEPALIVE_REQUESTS_MAX 0x1000000
+#define HTTPSRV_PIPELINE_DEPTH_DEF 16
+#define HTTPSRV_PIPELINE_DEPTH_MAX 1024
+#define HTTPSRV_MAX_CONNECTIONS_DEF 10000
+#define HTTPSRV_MAX_CONNECTIONS_MAX 0x1000000
+#define HTTPSRV_MAX_ZIP_JOBS_DEF 16
+#define HTTPSRV_MAX_ZIP_JOBS_MAX 0x10000
+#define HTTPSRV_ENDPOINT_BUDGET_MAX 0x1000000
+#define HTTPSRV_RETRY_AFTER_SEC 1
+#define HTTPSRV_MAX_CHUNK_SIZE_DEF 0x1000000
+#define HTTPSRV_MAX_CHUNK_SIZE_MAX 0x7fffffff
+#define HTTPSRV_MAX_TRAILER_SIZE_DEF 0x1000
+#define HTTPSRV_MAX_TRAILER_SIZE_MAX 0x100000
+#define HTTPSRV_CHUNK_EXTENSION_MAX 0x400
+#define HTTPSRV_MAX_HEAD_SIZE_DEF 0x2000
+#define HTTPSRV_MAX_HEAD_SIZE_MAX 0x100000
+#define HTTPSRV_MAX_HEADERS_DEF 100
+#define HTTPSRV_MAX_HEADERS_MAX 0x10000
+#define HTTPSRV_MAX_BODY_SIZE_DEF 0x40000000
+#define HTTPSRV_MAX_BODY_SIZE_MAX 0x7fffffffffffffff
+#define HTTPSRV_REQUEST_ARENA_SIZE 0x4000
+#define HTTPSRV_REQUEST_ARENA_RETAINED_MAX 0x100000
+#define HTTPSRV_TIMER_WHEEL_SLOTS 512
+#define HTTPSRV_TIMER_WHEEL_TICK_MS 100
+#define HTTP_CONNECTION_TIMEOUT_MS (HTTPSRV_KEEPALIVE_TIMEOUT_DEF * 1000)
 #define HTTPSRV_VER "HTTP/1.1"
 
 #define HTTP_URIPFX_FILES "files"
 #define HTTP_URISFX_ZIP "zip"
+#define HTTP_URIARG_ID "{id}"
 #define MRU_FILES_ZIP_NAME "mrufiles.zip"
+#define HTTPSRV_UPLOAD_DIR ".uploads"
 
 #define HTTPSRV_POST_STORE "/store"
 #define HTTPSRV_GET_FILES "/" HTTP_URIPFX_FILES
+#define HTTPSRV_GET_FILE HTTPSRV_GET_FILES "/" HTTP_URIARG_ID
+#define HTTPSRV_GET_FILE_ZIP HTTPSRV_GET_FILE "/" HTTP_URISFX_ZIP
 #define HTTPSRV_GET_MRUFILES "/mrufiles"
 #define HTTPSRV_GET_MRUFILES_ZIP "/mrufiles/" HTTP_URISFX_ZIP
+#define HTTPSRV_GET_STATS "/stats"
 
 #define MRUFILES_DEF_N 3
 #define MRUFILES_MAX_N 1000
@@ -32,6 +32,73 @@ bool Application::showUsage(std::stringstream &os) const
    os << "\t\t-w | --storedir <repository-path>\n";
    os << "\t\t\tSet a repository directory (default is "
       << HTTPSRV_LOCAL_REPOSITORY_PATH << ") \n";
+   os << "\t\t-m | --model <thread|pool|epoll|uring>\n";
+   os << "\t\t\tServe each connection in a dedicated thread, in a pool of\n";
+   os << "\t\t\tworker threads or multiplex connections on epoll or io_uring\n";
+   os << "\t\t\tevent loops (default is thread)\n";
+   os << "\t\t-e | --eventloops <N>\n";
+   os << "\t\t\tNumber of event loop threads (default is number of CPU cores)\n";
+   os << "\t\t-t | --workers <N>\n";
+   os << "\t\t\tNumber of worker threads of the pool, which also runs the\n";
+   os << "\t\t\tblocking requests of the event loops (default is "
+      << HTTPSRV_WORKER_THREADS_DEF << ") \n";
+   os << "\t\t-q | --queue <N>\n";
+   os << "\t\t\tMax connections (or event loop requests) waiting for a worker\n";
+   os << "\t\t\tof the pool, further ones are rejected (default is "
+      << HTTPSRV_WORKER_QUEUE_DEF << ") \n";
+   os << "\t\t-a | --acceptors <N>\n";
+   os << "\t\t\tNumber of acceptors, each one listening on its own socket\n";
+   os << "\t\t\tbound with SO_REUSEPORT to the server port (default is 1)\n";
+   os << "\t\t-k | --keepalive <seconds>\n";
+   os << "\t\t\tMax time an idle connection is kept open, zero closes\n";
+   os << "\t\t\tthe connection after each response (default is "
+      << HTTPSRV_KEEPALIVE_TIMEOUT_DEF << ") \n";
+   os << "\t\t-r | --maxrequests <N>\n";
+   os << "\t\t\tMax requests served on a connection (default is "
+      << HTTPSRV_KEEPALIVE_REQUESTS_DEF << ") \n";
+   os << "\t\t-l | --pipeline <N>\n";
+   os << "\t\t\tMax pipelined requests processed before their responses\n";
+   os << "\t\t\tare sent in a single write (default is "
+      << HTTPSRV_PIPELINE_DEPTH_DEF << ") \n";
+   os << "\t\t-x | --maxconnections <N>\n";
+   os << "\t\t\tMax open connections, further connections are answered\n";
+   os << "\t\t\tby 503 and closed, 0 means unlimited (default is "
+      << HTTPSRV_MAX_CONNECTIONS_DEF << ") \n";
+   os << "\t\t-z | --maxzipjobs <N>\n";
+   os << "\t\t\tMax zip archives created or sent at the same time,\n";
+   os << "\t\t\t0 means unlimited (default is "
+      << HTTPSRV_MAX_ZIP_JOBS_DEF << ") \n";
+   os << "\t\t-b | --budget <endpoint>=<N>\n";
+   os << "\t\t\tMax requests served by an endpoint at the same time,\n";
+   os << "\t\t\t0 means unlimited (default), where endpoint is one of\n";
+   os << "\t\t\t";
+
+   for (size_t i = 0; i < LoadShedder::endpointCount; ++i)
+      os << LoadShedder::getEndpointName(LoadShedder::Endpoint(i)) << " ";
+
+   os << "\n";
+   os << "\t\t-C | --maxchunk <bytes>\n";
+   os << "\t\t\tMax size of a chunk of a request body sent with chunked\n";
+   os << "\t\t\ttransfer coding, 0 means unlimited (default is "
+      << HTTPSRV_MAX_CHUNK_SIZE_DEF << ") \n";
+   os << "\t\t-T | --maxtrailer <bytes>\n";
+   os << "\t\t\tMax size of the trailer fields of a chunked request body,\n";
+   os << "\t\t\t0 means that trailer fields are rejected (default is "
+      << HTTPSRV_MAX_TRAILER_SIZE_DEF << ") \n";
+   os << "\t\t-H | --maxheadsize <bytes>\n";
+   os << "\t\t\tMax size of a request line and header fields, larger\n";
+   os << "\t\t\trequests are answered by 431, 0 means unlimited\n";
+   os << "\t\t\t(default is " << HTTPSRV_MAX_HEAD_SIZE_DEF << ") \n";
+   os << "\t\t-N | --maxheaders <N>\n";
+   os << "\t\t\tMax header fields of a request, further fields are\n";
+   os << "\t\t\tanswered by 431, 0 means unlimited (default is "
+      << HTTPSRV_MAX_HEADERS_DEF << ") \n";
+   os << "\t\t-B | --maxbody <bytes>\n";
+   os << "\t\t\tMax size of a request body, larger bodies are answered\n";
+   os << "\t\t\tby 413, 0 means unlimited (default is "
+      << HTTPSRV_MAX_BODY_SIZE_DEF << ") \n";
+   os << "\t\t-c | --cpuaffinity\n";
+   os << "\t\t\tPin each acceptor (or event loop) thread to a CPU\n";
    os << "\t\t-vv | --verbose\n";
    os << "\t\t\tEnable logging on stderr\n";
    os << "\t\t-v | --version\n";
@@ -64,7 +131,23 @@ Application::Application(
       OPTION,
       PORT,
       WEBROOT,
-      MRUFILES_N
+      MRUFILES_N,
+      IO_MODEL,
+      EVENT_LOOPS,
+      WORKER_THREADS,
+      WORKER_QUEUE,
+      ACCEPTORS,
+      KEEPALIVE_TIMEOUT,
+      KEEPALIVE_REQUESTS,
+      PIPELINE_DEPTH,
+      MAX_CONNECTIONS,
+      MAX_ZIP_JOBS,
+      ENDPOINT_BUDGET,
+      MAX_CHUNK_SIZE,
+      MAX_TRAILER_SIZE,
+      MAX_HEAD_SIZE,
+      MAX_HEADERS,
+      MAX_BODY_SIZE
    }
    state = State::OPTION;
 
@@ -90,6 +173,75 @@ Application::Application(
          {
             state = State::WEBROOT;
          }
+         else if (sarg == "--model" || sarg == "-m")
+         {
+            state = State::IO_MODEL;
+         }
+         else if (sarg == "--eventloops" || sarg == "-e")
+         {
+            state = State::EVENT_LOOPS;
+         }
+         else if (sarg == "--workers" || sarg == "-t")
+         {
+            state = State::WORKER_THREADS;
+         }
+         else if (sarg == "--queue" || sarg == "-q")
+         {
+            state = State::WORKER_QUEUE;
+         }
+         else if (sarg == "--acceptors" || sarg == "-a")
+         {
+            state = State::ACCEPTORS;
+         }
+         else if (sarg == "--keepalive" || sarg == "-k")
+         {
+            state = State::KEEPALIVE_TIMEOUT;
+         }
+         else if (sarg == "--maxrequests" || sarg == "-r")
+         {
+            state = State::KEEPALIVE_REQUESTS;
+         }
+         else if (sarg == "--pipeline" || sarg == "-l")
+         {
+            state = State::PIPELINE_DEPTH;
+         }
+         else if (sarg == "--maxconnections" || sarg == "-x")
+         {
+            state = State::MAX_CONNECTIONS;
+         }
+         else if (sarg == "--maxzipjobs" || sarg == "-z")
+         {
+            state = State::MAX_ZIP_JOBS;
+         }
+         else if (sarg == "--budget" || sarg == "-b")
+         {
+            state = State::ENDPOINT_BUDGET;
+         }
+         else if (sarg == "--maxchunk" || sarg == "-C")
+         {
+            state = State::MAX_CHUNK_SIZE;
+         }
+         else if (sarg == "--maxtrailer" || sarg == "-T")
+         {
+            state = State::MAX_TRAILER_SIZE;
+         }
+         else if (sarg == "--maxheadsize" || sarg == "-H")
+         {
+            state = State::MAX_HEAD_SIZE;
+         }
+         else if (sarg == "--maxheaders" || sarg == "-N")
+         {
+            state = State::MAX_HEADERS;
+         }
+         else if (sarg == "--maxbody" || sarg == "-B")
+         {
+            state = State::MAX_BODY_SIZE;
+         }
+         else if (sarg == "--cpuaffinity" || sarg == "-c")
+         {
+            _cpuAffinity = true;
+            state = State::OPTION;
+         }
          else if (sarg == "--help" || sarg == "-h")
          {
             _showHelp = true;
@@ -150,6 +302,284 @@ Application::Application(
          }
          state = State::OPTION;
          break;
+
+      case State::IO_MODEL:
+         if (sarg == "thread")
+         {
+            _ioModel = HttpServer::IoModel::threadPerConnection;
+         }
+         else if (sarg == "pool")
+         {
+            _ioModel = HttpServer::IoModel::threadPool;
+         }
+         else if (sarg == "epoll")
+         {
+            _ioModel = HttpServer::IoModel::eventLoop;
+         }
+         else if (sarg == "uring")
+         {
+            _ioModel = HttpServer::IoModel::ioUring;
+         }
+         else
+         {
+            _errMessage = "Invalid I/O model '" + sarg 
+                        + "', try with --help or -h";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::EVENT_LOOPS:
+         try
+         {
+            _eventLoops = std::stoi(sarg);
+            if (_eventLoops < 1 || _eventLoops > HTTPSRV_EVENT_LOOPS_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid event loops number";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::WORKER_THREADS:
+         try
+         {
+            _workerThreads = std::stoi(sarg);
+            if (_workerThreads < 1 || _workerThreads > HTTPSRV_WORKER_THREADS_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid worker threads number";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::WORKER_QUEUE:
+         try
+         {
+            _workerQueueSize = std::stoi(sarg);
+            if (_workerQueueSize < 1 || _workerQueueSize > HTTPSRV_WORKER_QUEUE_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid worker queue size";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::ACCEPTORS:
+         try
+         {
+            _acceptors = std::stoi(sarg);
+            if (_acceptors < 1 || _acceptors > HTTPSRV_ACCEPTORS_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid acceptors number";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::KEEPALIVE_TIMEOUT:
+         try
+         {
+            _keepAliveTimeout = std::stoi(sarg);
+            if (_keepAliveTimeout < 0 || _keepAliveTimeout > HTTPSRV_KEEPALIVE_TIMEOUT_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid keep-alive timeout";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::KEEPALIVE_REQUESTS:
+         try
+         {
+            _keepAliveMaxRequests = std::stoi(sarg);
+            if (_keepAliveMaxRequests < 1 || 
+                _keepAliveMaxRequests > HTTPSRV_KEEPALIVE_REQUESTS_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid max requests number";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::PIPELINE_DEPTH:
+         try
+         {
+            _pipelineDepth = std::stoi(sarg);
+            if (_pipelineDepth < 1 || _pipelineDepth > HTTPSRV_PIPELINE_DEPTH_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid pipeline depth";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::MAX_CONNECTIONS:
+         try
+         {
+            _maxConnections = std::stoi(sarg);
+            if (_maxConnections < 0 || _maxConnections > HTTPSRV_MAX_CONNECTIONS_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid max connections number";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::MAX_ZIP_JOBS:
+         try
+         {
+            _maxZipJobs = std::stoi(sarg);
+            if (_maxZipJobs < 0 || _maxZipJobs > HTTPSRV_MAX_ZIP_JOBS_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid max zip jobs number";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::ENDPOINT_BUDGET:
+         try
+         {
+            // Expected format is <endpoint>=<N>
+            const auto pos = sarg.find('=');
+            LoadShedder::Endpoint endpoint;
+
+            if (pos == std::string::npos ||
+                !LoadShedder::findEndpoint(sarg.substr(0, pos), endpoint))
+               throw 0;
+
+            const int budget = std::stoi(sarg.substr(pos + 1));
+            if (budget < 0 || budget > HTTPSRV_ENDPOINT_BUDGET_MAX)
+               throw 0;
+
+            _endpointBudget[size_t(endpoint)] = budget;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid endpoint budget";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::MAX_CHUNK_SIZE:
+         try
+         {
+            _maxChunkSize = std::stoi(sarg);
+            if (_maxChunkSize < 0 || _maxChunkSize > HTTPSRV_MAX_CHUNK_SIZE_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid max chunk size";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::MAX_TRAILER_SIZE:
+         try
+         {
+            _maxTrailerSize = std::stoi(sarg);
+            if (_maxTrailerSize < 0 || _maxTrailerSize > HTTPSRV_MAX_TRAILER_SIZE_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid max trailer size";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::MAX_HEAD_SIZE:
+         try
+         {
+            _maxHeadSize = std::stoi(sarg);
+            if (_maxHeadSize < 0 || _maxHeadSize > HTTPSRV_MAX_HEAD_SIZE_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid max head size";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::MAX_HEADERS:
+         try
+         {
+            _maxHeaders = std::stoi(sarg);
+            if (_maxHeaders < 0 || _maxHeaders > HTTPSRV_MAX_HEADERS_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid max headers number";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
+
+      case State::MAX_BODY_SIZE:
+         try
+         {
+            _maxBodySize = std::stoll(sarg);
+            if (_maxBodySize < 0 || _maxBodySize > HTTPSRV_MAX_BODY_SIZE_MAX)
+               throw 0;
+         }
+         catch (...)
+         {
+            _errMessage = "Invalid max body size";
+            _error = true;
+            return;
+         }
+         state = State::OPTION;
+         break;
       }
    }
 }
@@ -189,6 +619,17 @@ Application::ErrCode Application::run()
    auto &httpSrv = HttpServer::getInstance();
 
    httpSrv.setFileRepository(_FileRepository);
+   httpSrv.setIoModel(_ioModel, _eventLoops);
+   httpSrv.setWorkerPool(_workerThreads, _workerQueueSize);
+   httpSrv.setAcceptors(_acceptors, _cpuAffinity);
+   httpSrv.setKeepAlive(_keepAliveTimeout, _keepAliveMaxRequests);
+   httpSrv.setPipelineDepth(_pipelineDepth);
+   httpSrv.setLimits(_maxConnections, _maxZipJobs);
+   httpSrv.setChunkLimits(size_t(_maxChunkSize), size_t(_maxTrailerSize));
+   httpSrv.setRequestLimits(size_t(_maxHeadSize), size_t(_maxHeaders), size_t(_maxBodySize));
+
+   for (size_t i = 0; i < LoadShedder::endpointCount; ++i)
+      httpSrv.setEndpointBudget(LoadShedder::Endpoint(i), _endpointBudget[i]);
 
    // Bind the server to any-interface:_httpServerPort
    if (!httpSrv.bind(_httpServerPort))
@@ -220,7 +661,12 @@ Application::ErrCode Application::run()
                 << HTTPSRV_NAME << " is listening on TCP port "
                 << _httpServerPort << std::endl
                 << "Working directory is '" << _localRepositoryPath << "'"
-                << std::endl;
+                << std::endl
+                << "I/O model is '"
+                << (_ioModel == HttpServer::IoModel::eventLoop ? "epoll" :
+                    _ioModel == HttpServer::IoModel::ioUring ? "uring" :
+                    _ioModel == HttpServer::IoModel::threadPool ? "pool" : "thread")
+                << "'" << std::endl;
    }
 
    // Finally run the server (blocking the caller)
@@ -0,0 +1,285 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "BoundaryScanner.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HTTPSRV_SIMD_X86
+#include <immintrin.h>
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+//! Checks whether a needle occurs at a candidate position, whose
+//! first and last bytes have been already matched
+inline bool matchesAt(const char *p, std::string_view needle) noexcept
+{
+   return std::memcmp(p + 1, needle.data() + 1, needle.size() - 2) == 0;
+}
+
+size_t findScalar(const char *data, size_t size, std::string_view needle) noexcept
+{
+   const size_t pos = std::string_view(data, size).find(needle);
+   return pos == std::string_view::npos ? size : pos;
+}
+
+#ifdef HTTPSRV_SIMD_X86
+
+// The vectorized searches compare a block of bytes against the first
+// byte of the needle and the block shifted by the needle length minus
+// one against its last byte: only the positions matching both (which
+// are rare, the first byte being CR) are compared in full
+
+__attribute__((target("sse2")))
+size_t findSse2(const char *data, size_t size, std::string_view needle) noexcept
+{
+   const size_t last = needle.size() - 1;
+   const __m128i first = _mm_set1_epi8(needle.front());
+   const __m128i final = _mm_set1_epi8(needle.back());
+
+   size_t i = 0;
+
+   for (; i + last + 16 <= size; i += 16)
+   {
+      const __m128i blockFirst = _mm_loadu_si128((const __m128i *)(data + i));
+      const __m128i blockLast = _mm_loadu_si128((const __m128i *)(data + i + last));
+
+      unsigned mask = unsigned(_mm_movemask_epi8(_mm_and_si128(
+         _mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(final, blockLast))));
+
+      while (mask)
+      {
+         const size_t pos = i + size_t(__builtin_ctz(mask));
+
+         if (matchesAt(data + pos, needle))
+            return pos;
+
+         mask &= mask - 1;
+      }
+   }
+
+   return i + findScalar(data + i, size - i, needle);
+}
+
+__attribute__((target("avx2")))
+size_t findAvx2(const char *data, size_t size, std::string_view needle) noexcept
+{
+   const size_t last = needle.size() - 1;
+   const __m256i first = _mm256_set1_epi8(needle.front());
+   const __m256i final = _mm256_set1_epi8(needle.back());
+
+   size_t i = 0;
+
+   for (; i + last + 32 <= size; i += 32)
+   {
+      const __m256i blockFirst = _mm256_loadu_si256((const __m256i *)(data + i));
+      const __m256i blockLast = _mm256_loadu_si256((const __m256i *)(data + i + last));
+
+      unsigned mask = unsigned(_mm256_movemask_epi8(_mm256_and_si256(
+         _mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(final, blockLast))));
+
+      while (mask)
+      {
+         const size_t pos = i + size_t(__builtin_ctz(mask));
+
+         if (matchesAt(data + pos, needle))
+            return pos;
+
+         mask &= mask - 1;
+      }
+   }
+
+   return i + findSse2(data + i, size - i, needle);
+}
+
+#endif // HTTPSRV_SIMD_X86
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+bool BoundaryScanner::isSupported(Isa isa) noexcept
+{
+   switch (isa)
+   {
+#ifdef HTTPSRV_SIMD_X86
+   case Isa::avx2:
+      return __builtin_cpu_supports("avx2");
+   case Isa::sse2:
+      return __builtin_cpu_supports("sse2");
+#endif
+   case Isa::scalar:
+      return true;
+   default:
+      return false;
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+BoundaryScanner::Isa BoundaryScanner::detectIsa() noexcept
+{
+   static const Isa isa = isSupported(Isa::avx2) ? Isa::avx2 :
+                          isSupported(Isa::sse2) ? Isa::sse2 :
+                                                   Isa::scalar;
+   return isa;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const char *BoundaryScanner::getIsaName(Isa isa) noexcept
+{
+   switch (isa)
+   {
+   case Isa::avx2:
+      return "avx2";
+   case Isa::sse2:
+      return "sse2";
+   case Isa::scalar:
+   default:
+      return "scalar";
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void BoundaryScanner::setIsa(Isa isa) noexcept
+{
+   if (isSupported(isa))
+      _isa = isa;
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t BoundaryScanner::find(
+   Isa isa,
+   const char *data,
+   size_t size,
+   std::string_view needle) noexcept
+{
+   switch (isa)
+   {
+#ifdef HTTPSRV_SIMD_X86
+   case Isa::avx2:
+      return findAvx2(data, size, needle);
+   case Isa::sse2:
+      return findSse2(data, size, needle);
+#endif
+   case Isa::scalar:
+   default:
+      return findScalar(data, size, needle);
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void BoundaryScanner::reset(std::string_view boundary)
+{
+   _delimiter.assign("\r\n--");
+   _delimiter.append(boundary.data(), boundary.size());
+
+   // The CRLF which virtually precedes the body
+   _pending.assign("\r\n");
+   _window.clear();
+   _found = false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t BoundaryScanner::findPartial(const char *data, size_t size) const noexcept
+{
+   // Searches the first of the last bytes which begin a prefix
+   // of the delimiter (too short to be the whole delimiter)
+   const size_t from = size >= _delimiter.size() ? size - _delimiter.size() + 1 : 0;
+
+   for (size_t i = from; i < size; ++i)
+   {
+      if (data[i] == _delimiter.front() &&
+          std::memcmp(data + i, _delimiter.data(), size - i) == 0)
+      {
+         return i;
+      }
+   }
+
+   return size;
+}
+
+/* -------------------------------------------------------------------------- */
+
+BoundaryScanner::Result BoundaryScanner::scan(const char *data, size_t size)
+{
+   Result res;
+
+   if (_found)
+      return res;
+
+   const size_t delimLen = _delimiter.size();
+
+   // The bytes retained from the previous chunk are joined with
+   // the beginning of this chunk to complete the delimiter they
+   // might start
+   if (!_pending.empty())
+   {
+      const size_t retained = _pending.size();
+      const size_t head = std::min(size, delimLen);
+
+      _window.assign(_pending);
+      _window.append(data, head);
+      _pending.clear();
+
+      for (size_t i = 0; i < retained && i + delimLen <= _window.size(); ++i)
+      {
+         if (_window.compare(i, delimLen, _delimiter) == 0)
+         {
+            res.carry = std::string_view(_window.data(), i);
+            res.consumed = i + delimLen - retained;
+            res.found = _found = true;
+            return res;
+         }
+      }
+
+      const size_t partial = findPartial(_window.data(), _window.size());
+
+      // Still undecided: the chunk is shorter than the delimiter
+      if (partial < retained)
+      {
+         res.carry = std::string_view(_window.data(), partial);
+         res.consumed = size;
+         _pending.assign(_window, partial, std::string::npos);
+         return res;
+      }
+
+      res.carry = std::string_view(_window.data(), retained);
+   }
+
+   const size_t pos = find(_isa, data, size, _delimiter);
+
+   if (pos < size)
+   {
+      res.span = std::string_view(data, pos);
+      res.consumed = pos + delimLen;
+      res.found = _found = true;
+      return res;
+   }
+
+   const size_t partial = findPartial(data, size);
+
+   res.span = std::string_view(data, partial);
+   res.consumed = size;
+   _pending.assign(data + partial, size - partial);
+
+   return res;
+}
@@ -0,0 +1,52 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "BufferPool.h"
+#include "config.h"
+
+#include <new>
+
+/* -------------------------------------------------------------------------- */
+
+BufferPool &BufferPool::getFileChunkPool()
+{
+   static BufferPool pool(HTTPSRV_FILE_CHUNK_SIZE, HTTPSRV_FILE_CHUNK_POOL_SIZE);
+   return pool;
+}
+
+/* -------------------------------------------------------------------------- */
+
+BufferPool::Buffer BufferPool::acquire()
+{
+   {
+      std::lock_guard<std::mutex> lock(_mtx);
+
+      if (!_freeBuffers.empty())
+      {
+         std::unique_ptr<char[]> data = std::move(_freeBuffers.back());
+         _freeBuffers.pop_back();
+
+         return Buffer(this, std::move(data));
+      }
+   }
+
+   return Buffer(this, std::unique_ptr<char[]>(new (std::nothrow) char[_bufferSize]));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void BufferPool::release(std::unique_ptr<char[]> data)
+{
+   std::lock_guard<std::mutex> lock(_mtx);
+
+   // Beyond the limit the buffer is just freed
+   if (_freeBuffers.size() < _maxFreeBuffers)
+      _freeBuffers.push_back(std::move(data));
+}
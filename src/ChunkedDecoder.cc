@@ -0,0 +1,188 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "ChunkedDecoder.h"
+
+#include <algorithm>
+#include <limits>
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+//! Returns the value of an hex digit, or -1 if not an hex digit
+int hexValue(char c) noexcept
+{
+   if (c >= '0' && c <= '9')
+      return c - '0';
+
+   if (c >= 'a' && c <= 'f')
+      return c - 'a' + 10;
+
+   if (c >= 'A' && c <= 'F')
+      return c - 'A' + 10;
+
+   return -1;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void ChunkedDecoder::reset(const Limits &limits) noexcept
+{
+   _limits = limits;
+   _state = State::size;
+   _chunkSize = 0;
+   _digits = 0;
+   _extensionSize = 0;
+   _trailerSize = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t ChunkedDecoder::decode(
+   const char *data,
+   size_t size,
+   std::string_view &content) noexcept
+{
+   content = std::string_view();
+
+   size_t pos = 0;
+
+   while (pos < size && _state != State::done && _state != State::error)
+   {
+      // The chunk data are yielded as a whole
+      if (_state == State::data)
+      {
+         const size_t len = std::min(_chunkSize, size - pos);
+
+         content = std::string_view(data + pos, len);
+         _chunkSize -= len;
+
+         if (_chunkSize == 0)
+            _state = State::dataCr;
+
+         return pos + len;
+      }
+
+      feed(data[pos++]);
+   }
+
+   return pos;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ChunkedDecoder::feed(char c) noexcept
+{
+   switch (_state)
+   {
+   // chunk-size [ chunk-ext ] CRLF
+   case State::size:
+   {
+      const int value = hexValue(c);
+
+      if (value >= 0)
+      {
+         if (_chunkSize > (std::numeric_limits<size_t>::max() >> 4))
+         {
+            _state = State::error;
+            break;
+         }
+
+         _chunkSize = (_chunkSize << 4) | size_t(value);
+         ++_digits;
+
+         if (_limits.maxChunkSize > 0 && _chunkSize > _limits.maxChunkSize)
+            _state = State::error;
+      }
+      else if (_digits == 0)
+      {
+         _state = State::error;
+      }
+      else if (c == '\r')
+      {
+         _state = State::sizeLf;
+      }
+      else if (c == ';' || c == ' ' || c == '\t')
+      {
+         _state = State::extension;
+      }
+      else
+      {
+         _state = State::error;
+      }
+      break;
+   }
+
+   case State::extension:
+      if (c == '\r')
+         _state = State::sizeLf;
+      else if (++_extensionSize > HTTPSRV_CHUNK_EXTENSION_MAX)
+         _state = State::error;
+      break;
+
+   case State::sizeLf:
+      if (c != '\n')
+         _state = State::error;
+      else if (_chunkSize == 0) // last-chunk
+         _state = State::trailer;
+      else
+         _state = State::data;
+      break;
+
+   case State::dataCr:
+      _state = c == '\r' ? State::dataLf : State::error;
+      break;
+
+   case State::dataLf:
+      if (c == '\n')
+      {
+         _state = State::size;
+         _digits = 0;
+         _extensionSize = 0;
+      }
+      else
+      {
+         _state = State::error;
+      }
+      break;
+
+   // *( field-line CRLF ) CRLF
+   case State::trailer:
+      if (c == '\r')
+      {
+         _state = State::trailerLf;
+         break;
+      }
+
+      _state = State::trailerLine;
+      [[fallthrough]];
+
+   case State::trailerLine:
+      if (++_trailerSize > _limits.maxTrailerSize)
+         _state = State::error;
+      else if (c == '\n')
+         _state = State::trailer;
+      break;
+
+   case State::trailerLf:
+      _state = c == '\n' ? State::done : State::error;
+      break;
+
+   case State::data:
+   case State::done:
+   case State::error:
+   default:
+      break;
+   }
+}
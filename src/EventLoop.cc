@@ -0,0 +1,325 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "EventLoop.h"
+
+#include <cassert>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <errno.h>
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+EventLoop::Handle EventLoop::create(
+    TcpListener &listener,
+    bool verboseModeOn,
+    std::ostream &loggerOStream,
+    FileRepository::Handle fileRepository,
+    const HttpSession::Config &sessionConfig)
+{
+   Handle handle(new (std::nothrow) EventLoop(
+       listener, verboseModeOn, loggerOStream, fileRepository, sessionConfig));
+
+   assert(handle);
+
+   return handle && handle->init() ? std::move(handle) : nullptr;
+}
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef __linux__
+
+/* -------------------------------------------------------------------------- */
+
+bool EventLoop::isSupported() noexcept
+{
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+EventLoop::~EventLoop()
+{
+   if (_epollFd >= 0)
+      ::close(_epollFd);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool EventLoop::init()
+{
+   _epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+
+   if (_epollFd < 0)
+      return false;
+
+   // The listener is shared among event loops: it is level-triggered so
+   // that no pending connection is left behind, while EPOLLEXCLUSIVE
+   // prevents every loop from being woken up for the same connection
+   epoll_event ev = {};
+   ev.events = EPOLLIN | EPOLLEXCLUSIVE;
+   ev.data.fd = _listener.getSocketFd();
+
+   if (0 != ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, ev.data.fd, &ev))
+      return false;
+
+   if (!_resumeQueue.init())
+      return false;
+
+   ev.events = EPOLLIN;
+   ev.data.fd = _resumeQueue.getFd();
+
+   return 0 == ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, ev.data.fd, &ev);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void EventLoop::acceptConnections()
+{
+   while (true)
+   {
+      const TcpSocket::Handle handle = _listener.accept();
+
+      // No more pending connections
+      if (!handle)
+         break;
+
+      LoadShedder::Ticket ticket;
+
+      if (_sessionConfig.loadShedder)
+      {
+         ticket = _sessionConfig.loadShedder->admitConnection();
+
+         // Too many connections: answer at once and close
+         if (!ticket)
+         {
+            if (_verboseModeOn)
+            {
+               _logger << "EventLoop: server is overloaded, connection rejected ("
+                  << _sessionConfig.loadShedder->getStats().connections
+                  << " so far)" << std::endl;
+            }
+
+            _sessionConfig.loadShedder->rejectConnection(handle);
+            continue;
+         }
+      }
+
+      if (!handle->setNonBlocking())
+         continue;
+
+      HttpSession::Handle sessionHandle = HttpSession::create(
+          _verboseModeOn,
+          _logger,
+          handle,
+          _fileRepository,
+          _sessionConfig,
+          std::move(ticket));
+
+      std::unique_ptr<SocketIoChannel> channel(
+          new (std::nothrow) SocketIoChannel(*handle));
+
+      if (!sessionHandle || !channel)
+         continue;
+
+      const int sd = handle->getSocketFd();
+
+      // Edge-triggered notifications for both directions: the session
+      // state machine decides which one it is waiting for
+      epoll_event ev = {};
+      ev.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+      ev.data.fd = sd;
+
+      if (0 != ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, sd, &ev))
+         continue;
+
+      sessionHandle->start(*channel, [this](const HttpSession::Handle &session) {
+         _resumeQueue.push(session);
+      });
+
+      Connection &connection = _connections[sd];
+      connection.session = sessionHandle;
+      connection.channel = std::move(channel);
+
+      restartIdleTimer(sd, connection);
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void EventLoop::restartIdleTimer(int sd, Connection &connection)
+{
+   _timerWheel.start(connection.idleTimer, sd, connection.session->getIdleTimeout());
+}
+
+/* -------------------------------------------------------------------------- */
+
+void EventLoop::drive(int sd, Connection &connection)
+{
+   // Any error or hang-up condition is detected by the session
+   // itself while trying to read or write the socket
+   if (!connection.session->onIoEvent())
+      closeSession(sd);
+   else if (connection.session->isRunningJob())
+      connection.idleTimer.cancel();
+   else
+      restartIdleTimer(sd, connection);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void EventLoop::resumeSessions()
+{
+   _resumeQueue.clearNotification();
+   _resumeQueue.take(_resumed);
+
+   for (const auto &session : _resumed)
+   {
+      const int sd = session->getTcpSocketHandle()->getSocketFd();
+      auto it = _connections.find(sd);
+
+      if (it != _connections.end() && it->second.session == session)
+         drive(sd, it->second);
+   }
+
+   _resumed.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void EventLoop::closeSession(int sd)
+{
+   auto it = _connections.find(sd);
+
+   if (it == _connections.end())
+      return;
+
+   ::epoll_ctl(_epollFd, EPOLL_CTL_DEL, sd, nullptr);
+
+   it->second.session->terminate();
+
+   // Releasing the session handle closes the socket
+   _connections.erase(it);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool EventLoop::run()
+{
+   epoll_event events[HTTPSRV_EPOLL_MAX_EVENTS];
+
+   while (true)
+   {
+      // Wake up in time to close the expired connections, if any
+      const int nfds = ::epoll_wait(
+         _epollFd, events, HTTPSRV_EPOLL_MAX_EVENTS, _timerWheel.getWaitTimeout());
+
+      if (nfds < 0)
+      {
+         if (errno == EINTR)
+            continue;
+
+         if (_verboseModeOn)
+         {
+            _logger << "EventLoop::run() epoll_wait is failing" << std::endl;
+         }
+
+         return false;
+      }
+
+      for (int i = 0; i < nfds; ++i)
+      {
+         const int sd = events[i].data.fd;
+
+         if (sd == _listener.getSocketFd())
+         {
+            acceptConnections();
+            continue;
+         }
+
+         if (sd == _resumeQueue.getFd())
+         {
+            resumeSessions();
+            continue;
+         }
+
+         auto it = _connections.find(sd);
+
+         if (it != _connections.end())
+            drive(sd, it->second);
+      }
+
+      _timerWheel.expire([this](int sd) {
+         if (_verboseModeOn)
+         {
+            _logger << "EventLoop: connection " << sd << " timed out" << std::endl;
+         }
+
+         closeSession(sd);
+      });
+   }
+
+   // Ok, following instruction won't be ever executed
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+#else
+
+/* -------------------------------------------------------------------------- */
+// Other platforms
+
+/* -------------------------------------------------------------------------- */
+
+bool EventLoop::isSupported() noexcept
+{
+   return false;
+}
+
+EventLoop::~EventLoop()
+{
+}
+
+bool EventLoop::init()
+{
+   return false;
+}
+
+void EventLoop::acceptConnections()
+{
+}
+
+void EventLoop::closeSession(int)
+{
+}
+
+void EventLoop::restartIdleTimer(int, Connection &)
+{
+}
+
+void EventLoop::drive(int, Connection &)
+{
+}
+
+void EventLoop::resumeSessions()
+{
+}
+
+bool EventLoop::run()
+{
+   return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+#endif
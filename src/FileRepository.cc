@@ -15,6 +15,8 @@
 
 #include <fstream>
 #include <chrono>
+#include <random>
+#include <sstream>
 
 
 /* -------------------------------------------------------------------------- */
@@ -54,6 +56,15 @@ bool FileRepository::init()
       return false;
    }
 
+   // Files being uploaded are kept apart until complete, so that they
+   // are not listed; if it fails, uploads are received in memory
+   std::error_code ec;
+   fs::path uploadPath(_path);
+   uploadPath /= HTTPSRV_UPLOAD_DIR;
+
+   if (fs::create_directories(uploadPath, ec) || fs::is_directory(uploadPath, ec))
+      _uploadPath = uploadPath.string();
+
    return true;
 }
 
@@ -113,14 +124,17 @@ bool FileRepository::createMruFilesList(std::list<std::string> &mrufiles)
 
 /* -------------------------------------------------------------------------- */
 
-bool FileRepository::createJsonMruFilesList(std::string &json)
+bool FileRepository::createJsonMruFilesList(std::pmr::string &json)
 {
    TimeOrderedFileList timeOrderedFileList;
 
    if (!createTimeOrderedFilesList(timeOrderedFileList))
       return false;
 
-   json = "[\n";
+   json.clear();
+
+   JsonWriter writer(json);
+   writer.beginArray();
 
    int fileCnt = 0;
 
@@ -129,20 +143,12 @@ bool FileRepository::createJsonMruFilesList(std::string &json)
         ++it,
              ++fileCnt)
    {
-      std::string jsonEntry;
       auto fName = it->second.filename().string();
       auto id = FileUtils::hashCode(fName);
-      if (FilenameMap::jsonStat(it->second.string(), fName, id, jsonEntry, "  ", ",\n"))
-      {
-         json += jsonEntry;
-      }
+      FilenameMap::jsonStat(it->second.string().c_str(), fName, id, writer);
    }
 
-   // remove last ",\n" sequence
-   if (json.size() > 2)
-      json.resize(json.size() - 2);
-
-   json += "\n]\n";
+   writer.endArray();
    return true;
 }
 
@@ -151,7 +157,7 @@ bool FileRepository::createJsonMruFilesList(std::string &json)
 bool FileRepository::store(
    const std::string& fileName,
    const std::string& fileContent,
-   std::string& json)
+   std::pmr::string& json)
 {
    fs::path filePath(_path);
    filePath /= fileName;
@@ -162,18 +168,8 @@ bool FileRepository::store(
 
    if (!os.fail())
    {
-      auto id = FileUtils::hashCode(fileName);
-
       os.close(); // create the file posted by client
-      if (!FilenameMap::jsonStat(filePath.string(), fileName, id, json))
-      {
-         json.clear();
-      }
-      else
-      {
-         getFilenameMap().insert(id, fileName);
-         return true;
-      }
+      return storeJsonStat(filePath, fileName, json);
    }
 
    return false;
@@ -181,8 +177,60 @@ bool FileRepository::store(
 
 /* -------------------------------------------------------------------------- */
 
+FileUpload::Handle FileRepository::createUpload(const std::string& fileName)
+{
+   if (_uploadPath.empty())
+      return nullptr;
+
+   thread_local std::mt19937_64 prng(std::random_device{}());
+
+   std::stringstream ss;
+   ss << std::hex << prng();
+
+   fs::path tmpPath(_uploadPath);
+   tmpPath /= ss.str();
+
+   return FileUpload::create(fileName, tmpPath.string());
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool FileRepository::store(FileUpload& upload, std::pmr::string& json)
+{
+   const auto& fileName = upload.getFileName();
+
+   fs::path filePath(_path);
+   filePath /= fileName;
+
+   return upload.commit(filePath.string()) &&
+      storeJsonStat(filePath, fileName, json);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool FileRepository::storeJsonStat(
+   const fs::path& filePath,
+   const std::string& fileName,
+   std::pmr::string& json)
+{
+   auto id = FileUtils::hashCode(fileName);
+
+   JsonWriter writer(json);
+
+   if (!FilenameMap::jsonStat(filePath.string().c_str(), fileName, id, writer))
+   {
+      json.clear();
+      return false;
+   }
+
+   getFilenameMap().insert(id, fileName);
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
 bool FileRepository::createMruFilesZip(
-   std::string& zipFileName,
+   std::pmr::string& zipFileName,
    FileUtils::DirectoryRipper::Handle& zipCleaner)
 {
    fs::path tempDir;
@@ -211,7 +259,7 @@ bool FileRepository::createMruFilesZip(
    }
 
    zipArchive.close();
-   zipFileName = tempDir.string();
+   zipFileName.assign(tempDir.string());
 
    return true;
 }
@@ -219,8 +267,8 @@ bool FileRepository::createMruFilesZip(
 /* -------------------------------------------------------------------------- */
 
 FileRepository::createFileZipRes FileRepository::createFileZip(
-   const std::string id, 
-   std::string& zipFileName,
+   std::string_view id, 
+   std::pmr::string& zipFileName,
    FileUtils::DirectoryRipper::Handle& zipCleaner)
 {
    std::string fileName;
@@ -239,7 +287,7 @@ FileRepository::createFileZipRes FileRepository::createFileZip(
    src /= fileName;
 
    const auto updated = FileUtils::touch(
-      src.string(), 
+      src.string().c_str(), 
       false /*== do not create if it does not exist*/);
 
    ZipArchive zipArchive(tempDir.string());
@@ -248,7 +296,7 @@ FileRepository::createFileZipRes FileRepository::createFileZip(
 
    zipArchive.close();
 
-   zipFileName = tempDir.string();
+   zipFileName.assign(tempDir.string());
 
    return createFileZipRes::success;
 }
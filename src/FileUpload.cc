@@ -0,0 +1,126 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "FileUpload.h"
+
+#include <cerrno>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+#ifndef O_CLOEXEC
+#define O_CLOEXEC 0
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+FileUpload::Handle FileUpload::create(
+   const std::string &fileName,
+   const std::string &tmpPath)
+{
+   const int fd = ::open(
+      tmpPath.c_str(),
+      O_WRONLY | O_CREAT | O_EXCL | O_BINARY | O_CLOEXEC,
+      0644);
+
+   if (fd < 0)
+      return nullptr;
+
+   Handle handle(new (std::nothrow) FileUpload(fileName, tmpPath, fd));
+
+   if (!handle)
+   {
+      ::close(fd);
+      ::remove(tmpPath.c_str());
+   }
+
+   return handle;
+}
+
+/* -------------------------------------------------------------------------- */
+
+FileUpload::~FileUpload()
+{
+   close();
+
+   if (!_committed)
+      ::remove(_tmpPath.c_str());
+}
+
+/* -------------------------------------------------------------------------- */
+
+void FileUpload::close() noexcept
+{
+   if (_fd >= 0)
+   {
+      if (::close(_fd) < 0)
+         _failed = true;
+
+      _fd = -1;
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool FileUpload::write(const char *data, size_t size) noexcept
+{
+   if (_failed || _fd < 0)
+      return false;
+
+   while (size > 0)
+   {
+      const auto written = ::write(_fd, data, size);
+
+      if (written < 0)
+      {
+         if (errno == EINTR)
+            continue;
+
+         _failed = true;
+         return false;
+      }
+
+      data += written;
+      size -= size_t(written);
+      _size += uint64_t(written);
+   }
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool FileUpload::commit(const std::string &path)
+{
+   close();
+
+   if (_failed || _committed)
+      return false;
+
+#ifdef WIN32
+   // rename() does not replace an existing file on Windows
+   ::remove(path.c_str());
+#endif
+
+   _committed = ::rename(_tmpPath.c_str(), path.c_str()) == 0;
+
+   return _committed;
+}
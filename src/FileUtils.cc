@@ -19,12 +19,14 @@
 
 #ifdef WIN32
 #include <direct.h>
+#include <sys/utime.h>
 #else
 #include <sys/types.h>
 #include <pwd.h>
 #include <uuid/uuid.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <utime.h>
 #endif
 
 /* -------------------------------------------------------------------------- */
@@ -54,23 +56,23 @@ bool FileUtils::createTemporaryDir(fs::path &path)
 /* -------------------------------------------------------------------------- */
 
 bool FileUtils::fileStat(
-    const std::string &fileName,
+    const char *fileName,
     std::string &dateTime,
-    std::string &ext,
+    std::string_view &ext,
     size_t &fsize)
 {
    struct stat rstat = {0};
-   int ret = stat(fileName.c_str(), &rstat);
+   int ret = stat(fileName, &rstat);
 
    if (ret >= 0)
    {
       dateTime = ctime(&rstat.st_atime);
       fsize = rstat.st_size;
 
-      std::string::size_type pos = fileName.rfind('.');
-      ext = pos != std::string::npos
-                ? fileName.substr(pos, fileName.size() - pos)
-                : ".";
+      // The extension refers to the file name, not copied
+      const std::string_view name(fileName);
+      const std::string::size_type pos = name.rfind('.');
+      ext = pos != std::string::npos ? name.substr(pos) : ".";
 
       StrUtils::removeLastCharIf(dateTime, '\n');
 
@@ -91,36 +93,22 @@ std::string FileUtils::hashCode(const std::string &src)
 
 /* -------------------------------------------------------------------------- */
 
-bool FileUtils::touch(const std::string &fileName, bool createNewIfNotExists)
+bool FileUtils::touch(const char *fileName, bool createNewIfNotExists)
 {
-   std::fstream ofs;
-   ofs.open(fileName, std::ofstream::out | std::ofstream::in);
-
-   if (ofs)
-   {
-      ofs.seekg(0, ofs.end);
-      auto length = ofs.tellg();
-      ofs.seekg(0, ofs.beg);
+   // The timestamps of an existing file are set to now, neither
+   // rewriting its content nor allocating the buffers of a stream
+#ifdef WIN32
+   if (::_utime(fileName, nullptr) == 0)
+      return true;
+#else
+   if (::utime(fileName, nullptr) == 0)
+      return true;
+#endif
 
-      if (length > 0)
-      {
-         char c = 0;
-         ofs.read(&c, 1);
-         ofs.seekg(0, ofs.beg);
-         ofs.write(&c, 1);
-      }
-      ofs.close();
+   if (!createNewIfNotExists)
+      return false;
 
-      if (length < 1)
-      {
-         ofs.open(fileName, std::ofstream::out);
-      }
-   }
-   else
-   {
-      if (createNewIfNotExists)
-         ofs.open(fileName, std::ofstream::out);
-   }
+   std::ofstream ofs(fileName);
 
    return !ofs.fail();
 }
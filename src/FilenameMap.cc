@@ -11,8 +11,7 @@
 #include "FilenameMap.h"
 #include "FileUtils.h"
 
-#include <sstream>
-#include <iomanip>
+#include <limits>
 
 #ifndef WIN32
 #include <sys/types.h>
@@ -49,100 +48,146 @@ bool FilenameMap::scan(const std::string &path)
 
 bool FilenameMap::locked_updateMakeJson(
     const std::string &path,
-    std::string &json)
+    std::pmr::string &json)
 {
-   fs::path dirPath(path);
-   fs::directory_iterator endIt;
+   Listing listing(*this, path, json.get_allocator().resource());
 
-   FilenameMap newMap;
+   if (!listing.isValid())
+   {
+      json.clear();
+      return false;
+   }
 
-   json = "[\n";
+   listing.write(std::numeric_limits<size_t>::max());
 
-   if (fs::exists(dirPath) && fs::is_directory(dirPath))
+   json = std::move(listing.getText());
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+FilenameMap::Listing::Listing(
+    FilenameMap &map,
+    const std::string &path,
+    std::pmr::memory_resource *memory)
+    : _map(map), _dirPath(path), _text(memory), _writer(_text)
+{
+   std::error_code ec;
+
+   _valid = fs::is_directory(_dirPath, ec);
+
+   if (_valid)
    {
-      for (fs::directory_iterator it(dirPath); it != endIt; ++it)
+      _it = fs::directory_iterator(_dirPath, ec);
+      _valid = !ec;
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void FilenameMap::Listing::write(size_t size)
+{
+   if (!_valid || _over)
+      return;
+
+   if (!_started)
+   {
+      _writer.beginArray();
+      _started = true;
+   }
+
+   std::error_code ec;
+
+   // A directory which cannot be read any further ends the listing
+   for (; !ec && _it != fs::directory_iterator(); _it.increment(ec))
+   {
+      if (_text.size() >= size)
+         return;
+
+      std::error_code statusEc;
+
+      if (fs::is_regular_file(_it->status(statusEc)))
       {
-         if (fs::is_regular_file(it->status()))
+         auto fName = _it->path().filename().string();
+         auto id = FileUtils::hashCode(fName);
+         if (FilenameMap::jsonStat(_it->path().string().c_str(), fName, id, _writer))
          {
-            std::string jsonEntry;
-            auto fName = it->path().filename().string();
-            auto id = FileUtils::hashCode(fName);
-            if (FilenameMap::jsonStat(
-               it->path().string(), fName, id, jsonEntry, "  ", ",\n"))
-            {
-               newMap.insert(id, fName);
-               json += jsonEntry;
-            }
+            _listed.insert({id, fName});
          }
       }
-      locked_replace(std::move(newMap));
-
-      // remove last ",\n" sequence
-      if (json.size() > 2)
-         json.resize(json.size() - 2);
-
-      json += "\n]\n";
-      return true;
    }
 
-   json.clear();
-   return false;
+   _writer.endArray();
+   _over = true;
+
+   std::unique_lock lock(_map._mtx);
+   _map._data = std::move(_listed);
 }
 
 /* -------------------------------------------------------------------------- */
 
 bool FilenameMap::jsonStatFileUpdateTS(
     const std::string &path,
-    const std::string &id,
-    std::string &json,
+    std::string_view id,
+    std::pmr::string &json,
     bool updateTimeStamp)
 {
-   std::string fName;
+   // Any string lives as long as the output does
+   std::pmr::string fName(json.get_allocator());
 
    if (!locked_search(id, fName))
       return false;
 
-   std::string filePath = path + "/" + fName;
+   std::pmr::string filePath(json.get_allocator());
+   filePath.reserve(path.size() + 1 + fName.size());
+   filePath.append(path).append(1, '/').append(fName);
 
    if (updateTimeStamp)
       FileUtils::touch(
-         filePath, 
+         filePath.c_str(), 
          false /*-> do not create a file if it doesn't exist*/);
 
-   return jsonStat(filePath, fName, id, json);
+   JsonWriter writer(json);
+
+   return jsonStat(filePath.c_str(), fName, id, writer);
 }
 
 /* -------------------------------------------------------------------------- */
 
 bool FilenameMap::jsonStat(
-    const std::string &filePath, // actual file path (including name)
-    const std::string &fileName, // filename field of JSON output
-    const std::string &id,       // id field of JSON output
-    std::string &jsonOutput,
-    const std::string &beginl,
-    const std::string &endl)
+    const char *filePath,       // actual file path (including name)
+    std::string_view fileName,  // filename field of JSON output
+    std::string_view id,        // id field of JSON output
+    JsonWriter &json)
 {
    struct stat rstat = {0};
-   const int ret = stat(filePath.c_str(), &rstat);
+   const int ret = stat(filePath, &rstat);
 
    if (ret < 0)
       return false;
 
-   // convert into UTC timestamp
-   std::tm bt = *gmtime(&(rstat.st_atime));
-
-   std::ostringstream ossTS;
-
 #ifdef __linux__
    // Supported by Linux only
-   size_t microsec = (rstat.st_atim.tv_nsec / 1000) % 1000000;
+   const unsigned microsec = unsigned((rstat.st_atim.tv_nsec / 1000) % 1000000);
 #else
-   size_t microsec = 0;
+   const unsigned microsec = 0;
 #endif
-   // YYYY-MM-DDTHH:MM:SS.uuuuuuZ
-   ossTS << std::put_time(&bt, "%Y-%m-%dT%H:%M:%S");
-   ossTS << '.' << std::setfill('0') << std::setw(6) << microsec << "Z";
 
+   writeJsonRecord(json, id, fileName, rstat.st_size, rstat.st_atime, microsec);
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void FilenameMap::writeJsonRecord(
+    JsonWriter &json,
+    std::string_view id,
+    std::string_view fileName,
+    uint64_t size,
+    std::time_t accessTime,
+    unsigned accessTimeUs)
+{
    /*
    Example of JSON output
 
@@ -154,20 +199,14 @@ bool FilenameMap::jsonStat(
    }
    */
 
-   std::stringstream oss;
-   oss << beginl << "{" << std::endl;
-
-   // we don't need to escape the id as doesn't contain any control/puntuactor chars
-   oss << beginl << "  \"id\": \"" << id << "\"," << std::endl;
+   json.beginObject();
 
-   // while we need to escape the filename otherwhise resulting JSON could be invalid
-   oss << beginl << "  \"name\": \"" << StrUtils::escapeJson(fileName) << "\"," << std::endl;
+   // the filename is escaped, otherwhise resulting JSON could be invalid
+   // (names needing no escape, as the id, are copied at once)
+   json.value("id", id);
+   json.value("name", fileName);
+   json.value("size", size);
+   json.timestamp("timestamp", accessTime, accessTimeUs);
 
-   oss << beginl << "  \"size\": " << rstat.st_size << "," << std::endl;
-   oss << beginl << "  \"timestamp\": \"" << ossTS.str() << "\"" << std::endl;
-
-   oss << beginl << "}" << endl;
-   jsonOutput = oss.str();
-
-   return true;
+   json.endObject();
 }
@@ -0,0 +1,218 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "HeapStats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifdef WIN32
+#include <malloc.h>
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+// Each counter has its own cache line, not to be contended
+// along with the other one by the threads allocating memory
+alignas(64) std::atomic<uint64_t> allocations{0};
+alignas(64) std::atomic<uint64_t> deallocations{0};
+
+void *allocate(std::size_t size) noexcept
+{
+   allocations.fetch_add(1, std::memory_order_relaxed);
+
+   return std::malloc(size ? size : 1);
+}
+
+void *allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+{
+   allocations.fetch_add(1, std::memory_order_relaxed);
+
+   // The size of an aligned allocation must be a multiple of the alignment
+   const std::size_t align = std::size_t(alignment);
+   size = (std::max<std::size_t>(size, 1) + align - 1) & ~(align - 1);
+
+#ifdef WIN32
+   return _aligned_malloc(size, align);
+#else
+   return std::aligned_alloc(align, size);
+#endif
+}
+
+void deallocate(void *ptr) noexcept
+{
+   if (!ptr)
+      return;
+
+   deallocations.fetch_add(1, std::memory_order_relaxed);
+
+   std::free(ptr);
+}
+
+void deallocateAligned(void *ptr) noexcept
+{
+   if (!ptr)
+      return;
+
+   deallocations.fetch_add(1, std::memory_order_relaxed);
+
+#ifdef WIN32
+   _aligned_free(ptr);
+#else
+   std::free(ptr);
+#endif
+}
+
+//! Calls the new handler until the allocation succeeds, as required
+//! to the throwing forms of operator new
+template <typename Allocate>
+void *allocateOrThrow(Allocate allocate)
+{
+   while (true)
+   {
+      if (void *ptr = allocate())
+         return ptr;
+
+      std::new_handler handler = std::get_new_handler();
+
+      if (!handler)
+         throw std::bad_alloc();
+
+      handler();
+   }
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+HeapStats::Stats HeapStats::getStats() noexcept
+{
+   Stats stats;
+
+   stats.allocations = allocations.load(std::memory_order_relaxed);
+   stats.deallocations = deallocations.load(std::memory_order_relaxed);
+
+   return stats;
+}
+
+/* -------------------------------------------------------------------------- */
+// Replaceable global allocation functions
+
+/* -------------------------------------------------------------------------- */
+
+void *operator new(std::size_t size)
+{
+   return allocateOrThrow([size] { return allocate(size); });
+}
+
+void *operator new[](std::size_t size)
+{
+   return allocateOrThrow([size] { return allocate(size); });
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+   return allocate(size);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+   return allocate(size);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+   return allocateOrThrow([=] { return allocateAligned(size, alignment); });
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+   return allocateOrThrow([=] { return allocateAligned(size, alignment); });
+}
+
+void *operator new(
+   std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+   return allocateAligned(size, alignment);
+}
+
+void *operator new[](
+   std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+   return allocateAligned(size, alignment);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void operator delete(void *ptr) noexcept
+{
+   deallocate(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+   deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+   deallocate(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+   deallocate(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+   deallocate(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept
+{
+   deallocate(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+   deallocateAligned(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept
+{
+   deallocateAligned(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept
+{
+   deallocateAligned(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept
+{
+   deallocateAligned(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+   deallocateAligned(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t, const std::nothrow_t &) noexcept
+{
+   deallocateAligned(ptr);
+}
@@ -9,10 +9,220 @@
 /* -------------------------------------------------------------------------- */
 
 #include "HttpRequest.h"
+#include "PerfectHash.h"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+// Names of the known header fields, in the order of HttpRequest::Field
+constexpr std::array<std::string_view, HttpRequest::fieldCount> fieldNames = {
+   "Accept-Encoding",
+   "Connection",
+   "Content-Disposition",
+   "Content-Length",
+   "Content-Type",
+   "Expect",
+   "Host",
+   "If-Modified-Since",
+   "If-None-Match",
+   "Keep-Alive",
+   "Range",
+   "Transfer-Encoding",
+};
+
+constexpr PerfectHash<HttpRequest::fieldCount, true> fieldHash(fieldNames);
+
+static_assert(fieldHash.hasDistinctKeys(), "Duplicate name in the header field table");
+static_assert(fieldHash.isPerfect(), "No perfect hash found for the header fields");
+
+/* -------------------------------------------------------------------------- */
+
+//! Parses a non negative decimal number, returning -1 if not valid
+int parseNumber(std::string_view text) noexcept
+{
+   int value = 0;
+   const auto res = std::from_chars(text.data(), text.data() + text.size(), value);
+
+   return res.ec == std::errc() && value >= 0 ? value : -1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+//! Parses a body length, returning false if it is not a decimal number
+//! or it does not fit 64 bits
+bool parseLength(std::string_view text, uint64_t &length) noexcept
+{
+   const char *end = text.data() + text.size();
+   const auto res = std::from_chars(text.data(), end, length);
+
+   return res.ec == std::errc() && res.ptr == end;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpRequest::parseHead(std::string_view head)
+{
+   _head = head;
+   _headerList.clear();
+   _joinedFields.clear();
+   _fields.fill(std::string_view());
+
+   // Fields given more than once
+   std::array<bool, fieldCount> repeated{};
+
+   const size_t eol = head.find("\r\n");
+   const auto requestLine = head.substr(0, eol);
+
+   size_t pos = eol == std::string_view::npos ? head.size() : eol + 2;
+
+   while (pos < head.size())
+   {
+      const size_t end = std::min(head.find("\r\n", pos), head.size());
+      const auto line = head.substr(pos, end - pos);
+
+      const size_t colon = line.find(':');
+
+      if (colon != std::string_view::npos)
+      {
+         const auto name = line.substr(0, colon);
+         const auto value = StrUtils::trimView(line.substr(colon + 1));
+         const Field field = findField(name);
+
+         _headerList.push_back({name, value});
+
+         if (field != Field::count)
+         {
+            auto &fieldValue = _fields[size_t(field)];
+
+            if (fieldValue.empty())
+               fieldValue = value;
+            else if (!value.empty())
+               repeated[size_t(field)] = true;
+         }
+      }
+
+      pos = end + 2;
+   }
+
+   // A field given more than once is parsed as the value indexed,
+   // so that the value seen by any user is the one the request is
+   // framed by. The lists joined are not longer than the head, which
+   // keeps their views valid while they are appended
+   if (std::find(repeated.begin(), repeated.end(), true) != repeated.end())
+      _joinedFields.reserve(head.size());
+
+   for (size_t field = 0; field < fieldCount; ++field)
+   {
+      if (repeated[field])
+         mergeRepeatedField(Field(field));
+   }
+
+   for (size_t field = 0; field < fieldCount; ++field)
+      parseHeader(Field(field), _fields[field]);
+
+   return parseRequestLine(requestLine);
+}
 
 /* -------------------------------------------------------------------------- */
 
-void HttpRequest::parseMethod(const std::string &method)
+void HttpRequest::mergeRepeatedField(Field field)
+{
+   auto &fieldValue = _fields[size_t(field)];
+
+   switch (field)
+   {
+   // Lengths which differ make the body length unknown, the request
+   // could be framed in different ways along the way (RFC 7230, 3.3.2)
+   case Field::contentLength:
+   {
+      uint64_t first = 0;
+      const bool valid = parseLength(fieldValue, first);
+
+      for (const auto &header : _headerList)
+      {
+         uint64_t length = 0;
+
+         if (findField(header.name) == field && 
+             !header.value.empty() &&
+             (!valid || !parseLength(header.value, length) || length != first))
+         {
+            _malformedBody = true;
+         }
+      }
+      break;
+   }
+
+   // The values of a list are joined, as if they were sent in a single
+   // line (RFC 7230, 3.2.2)
+   case Field::acceptEncoding:
+   case Field::connection:
+   case Field::ifNoneMatch:
+   case Field::keepAlive:
+   case Field::transferEncoding:
+   {
+      // Room for all the lists is made in advance (see parseHead())
+      const size_t begin = _joinedFields.size();
+
+      for (const auto &header : _headerList)
+      {
+         if (findField(header.name) != field || header.value.empty())
+            continue;
+
+         if (_joinedFields.size() > begin)
+            _joinedFields.append(", ");
+
+         _joinedFields.append(header.value.data(), header.value.size());
+      }
+
+      assert(_joinedFields.capacity() >= _head.size());
+      fieldValue = std::string_view(_joinedFields).substr(begin);
+      break;
+   }
+
+   // The first value is taken
+   default:
+      break;
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpRequest::parseRequestLine(std::string_view line)
+{
+   // The request line consists of exactly 3 tokens, such as:
+   //
+   // GET /files HTTP/1.1
+   //
+   const size_t sp1 = line.find(' ');
+   const size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+
+   if (sp2 == std::string_view::npos || line.find(' ', sp2 + 1) != std::string_view::npos)
+      return false;
+
+   const auto method = line.substr(0, sp1);
+
+   _uri = line.substr(sp1 + 1, sp2 - sp1 - 1);
+
+   parseMethod(method);
+   parseVersion(line.substr(sp2 + 1));
+
+   // The endpoint is resolved just once, along with the request line
+   _route = HttpRouter::resolve(method, _uri);
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequest::parseMethod(std::string_view method)
 {
    if (method == "GET")
       _method = Method::GET;
@@ -26,10 +236,10 @@ void HttpRequest::parseMethod(const std::string &method)
 
 /* -------------------------------------------------------------------------- */
 
-void HttpRequest::parseVersion(const std::string &ver)
+void HttpRequest::parseVersion(std::string_view ver)
 {
    const size_t vstrlen = sizeof("HTTP/x.x") - 1;
-   std::string v = ver.size() > vstrlen ? ver.substr(0, vstrlen) : ver;
+   const auto v = ver.substr(0, vstrlen);
 
    if (v == "HTTP/1.0")
       _version = Version::HTTP_1_0;
@@ -41,14 +251,106 @@ void HttpRequest::parseVersion(const std::string &ver)
 
 /* -------------------------------------------------------------------------- */
 
-std::ostream &HttpRequest::dump(std::ostream &os, const std::string &id)
+void HttpRequest::persist()
+{
+   if (_head.empty() || _head.data() == _headStorage.data())
+      return;
+
+   const char *const oldBase = _head.data();
+   _headStorage.assign(_head.data(), _head.size());
+
+   const auto rebase = [&](std::string_view &view) {
+      // A list joined is already held by the request
+      if (!view.empty() && view.data() >= _joinedFields.data() &&
+          view.data() < _joinedFields.data() + _joinedFields.size())
+      {
+         return;
+      }
+
+      view = view.empty() ? std::string_view() :
+         std::string_view(_headStorage.data() + (view.data() - oldBase), view.size());
+   };
+
+   _head = _headStorage;
+
+   rebase(_uri);
+   rebase(_route.id);
+
+   for (auto &header : _headerList)
+   {
+      rebase(header.name);
+      rebase(header.value);
+   }
+
+   for (auto &value : _fields)
+      rebase(value);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequest::clear()
+{
+   _head = std::string_view();
+   _headStorage.clear();
+   _joinedFields.clear();
+   _bodyHeaderLines.clear();
+   _headerList.clear();
+   _fields.fill(std::string_view());
+   _method = Method::UNKNOWN;
+   _version = Version::UNKNOWN;
+   _uri = std::string_view();
+   _route = HttpRouter::Route();
+   _body.clear();
+   _upload.reset();
+   _malformedBody = false;
+   _errorStatus = 0;
+   _chunked = false;
+   _unsupportedTransferCoding = false;
+   _contentLength = 0;
+   _filename.clear();
+   _boundary.clear();
+   _expected_100_continue = false;
+   _connectionClose = false;
+   _connectionKeepAlive = false;
+   _keepAliveTimeout = -1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+HttpRequest::Field HttpRequest::findField(std::string_view name) noexcept
+{
+   const int index = fieldHash.find(name);
+
+   return index >= 0 ? Field(index) : Field::count;
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::string_view HttpRequest::getHeader(std::string_view name) const noexcept
+{
+   const Field field = findField(name);
+
+   if (field != Field::count)
+      return _fields[size_t(field)];
+
+   for (const auto &header : _headerList)
+   {
+      if (StrUtils::iequals(header.name, name))
+         return header.value;
+   }
+
+   return std::string_view();
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::ostream &HttpRequest::dump(std::ostream &os, const std::string &id) const
 {
    std::string ss;
 
    ss = ">>> REQUEST " + id + "\n";
-
-   for (auto e : getHeaderList())
-      ss += e;
+   ss.append(_head.data(), _head.size());
+   ss += _bodyHeaderLines;
 
    os << ss << std::endl;
 
@@ -57,129 +359,218 @@ std::ostream &HttpRequest::dump(std::ostream &os, const std::string &id)
 
 /* -------------------------------------------------------------------------- */
 
-void HttpRequest::parseHeader(const std::string &header)
+void HttpRequest::parseHeaderLine(std::string_view line)
 {
-   const auto prefix = ::toupper(header.c_str()[0]);
+   // The line is kept for logging purposes only
+   _bodyHeaderLines.append(line.data(), line.size());
+
+   const size_t colon = line.find(':');
 
-   if (prefix == 'C' || prefix == 'E')
+   if (colon != std::string_view::npos)
    {
-      std::vector<std::string> tokens;
+      parseHeader(
+         findField(line.substr(0, colon)),
+         StrUtils::trimView(line.substr(colon + 1)));
+   }
+}
 
-      StrUtils::splitLineInTokens(header, tokens, " ");
+/* -------------------------------------------------------------------------- */
 
-      const auto headerName = StrUtils::uppercase(tokens[0]);
+void HttpRequest::parseConnectionHeader(std::string_view value)
+{
+   // The header value is a comma separated list of options, such as:
+   //
+   // Connection: keep-alive, Upgrade
+   //
+   for (auto option : StrUtils::tokenize(value, ","))
+   {
+      option = StrUtils::trimView(option);
 
-      if (tokens.size() >= 2)
+      if (StrUtils::iequals(option, "close"))
+         _connectionClose = true;
+      else if (StrUtils::iequals(option, "keep-alive"))
+         _connectionKeepAlive = true;
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequest::parseKeepAliveHeader(std::string_view value)
+{
+   // The header value is a comma separated list of parameters, such as:
+   //
+   // Keep-Alive: timeout=5, max=1000
+   //
+   const std::string_view searched_prefix = "timeout=";
+
+   for (auto param : StrUtils::tokenize(value, ","))
+   {
+      param = StrUtils::trimView(param);
+
+      if (param.size() > searched_prefix.size() &&
+          StrUtils::istartsWith(param, searched_prefix))
       {
-         if (prefix == 'C')
-         {
-            // Parse the Content-Length header
-            if (headerName == "CONTENT-LENGTH:")
-            {
-               try
-               {
-                  _contentLength = std::stoi(tokens[1]);
-               }
-               catch (...)
-               {
-                  _contentLength = 0;
-               }
-            }
-            // Parse the content type searching for the boundary marker
-            // which looks like as in the following example:
-            //
-            // Content-Type: multipart/form-data; boundary=-----490a4289f7afa3e5
-            //
-            else if (headerName == "CONTENT-TYPE:")
-            {
-               _contentType = tokens[1];
-               std::vector<std::string> content_type;
-               StrUtils::splitLineInTokens(header, content_type, ";");
-               if (!content_type.empty())
-               {
-                  const std::string searched_prefix = "boundary=";
-
-                  for (const auto &item : content_type)
-                  {
-                     auto field = StrUtils::trim(item);
-                     if (field.size() > searched_prefix.size() &&
-                         field.substr(0, searched_prefix.size()) == searched_prefix)
-                     {
-                        _boundary = field.substr(
-                            searched_prefix.size(), field.size() - searched_prefix.size());
-                        break;
-                     }
-                  }
-               }
-            }
-            //  Parse multipart content and search for content disposition:
-            //  From such header get the filename field used to store file content
-            //  Such header looks like in the following example:
-            //
-            //  Content-Disposition: form-data; name="file"; filename="File02.txt"
-            //
-            else if (headerName == "CONTENT-DISPOSITION:")
-            {
-               std::vector<std::string> htoken;
-               StrUtils::splitLineInTokens(header, htoken, ";");
-
-               if (!htoken.empty())
-               {
-                  const std::string searched_prefix = "filename=\"";
-
-                  for (const auto &item : htoken)
-                  {
-                     auto field = StrUtils::trim(item);
-                     if (field.size() > searched_prefix.size() &&
-                         field.substr(0, searched_prefix.size()) == searched_prefix)
-                     {
-                        _filename.clear();
-                        for (auto i = searched_prefix.size(); i < field.size(); ++i)
-                        {
-                           const bool escape = field[i-1]=='\\';
-
-                           /*
-                           Escape punctuation characters:
-                          
-                           Even if RFC6266 - Appendix D reccomends not to use them
-                           CURL and other clients might use escape in quoted string,
-                           so we try to fix it by removing such useless characters (here)
-
-                           \" = quotation mark (backslash not required for '"')
-                           \' = apostrophe (backslash not required for "'")
-                           \? = question mark (used to avoid trigraphs)
-                           \\ = backslash
-                           */
-                           const auto ch=field[i];
-                           const bool punctuation = escape && (ch=='\"' || ch=='\'' || ch=='\?' || ch=='\\'); 
-
-                           if (escape && punctuation && !_filename.empty()) {
-                              _filename.resize(_filename.size()-1); // remove last backslash
-                              _filename += ch; // replace it with punctuation
-                           }
-                           else if (ch == '\"')
-                              break;
-                           else   
-                              _filename += ch;
-                        }
-
-                        break;
-                     }
-                  }
-               }
-            }
+         _keepAliveTimeout = parseNumber(param.substr(searched_prefix.size()));
+      }
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequest::parseContentTypeHeader(std::string_view value)
+{
+   // Parse the content type searching for the boundary marker
+   // which looks like as in the following example:
+   //
+   // Content-Type: multipart/form-data; boundary=-----490a4289f7afa3e5
+   //
+   const std::string_view searched_prefix = "boundary=";
+
+   for (auto field : StrUtils::tokenize(value, ";"))
+   {
+      field = StrUtils::trimView(field);
+
+      if (_boundary.empty() &&
+          field.size() > searched_prefix.size() &&
+          field.substr(0, searched_prefix.size()) == searched_prefix)
+      {
+         _boundary.assign(field.data() + searched_prefix.size(),
+                          field.size() - searched_prefix.size());
+      }
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequest::parseContentDispositionHeader(std::string_view value)
+{
+   //  Parse multipart content and search for content disposition:
+   //  From such header get the filename field used to store file content
+   //  Such header looks like in the following example:
+   //
+   //  Content-Disposition: form-data; name="file"; filename="File02.txt"
+   //
+   const std::string_view searched_prefix = "filename=\"";
+   for (auto field : StrUtils::tokenize(value, ";"))
+   {
+      field = StrUtils::trimView(field);
+
+      if (field.size() <= searched_prefix.size() ||
+          field.substr(0, searched_prefix.size()) != searched_prefix)
+      {
+         continue;
+      }
+
+      _filename.clear();
+
+      for (auto i = searched_prefix.size(); i < field.size(); ++i)
+      {
+         const bool escape = field[i-1]=='\\';
+
+         /*
+         Escape punctuation characters:
+
+         Even if RFC6266 - Appendix D reccomends not to use them
+         CURL and other clients might use escape in quoted string,
+         so we try to fix it by removing such useless characters (here)
+
+         \" = quotation mark (backslash not required for '"')
+         \' = apostrophe (backslash not required for "'")
+         \? = question mark (used to avoid trigraphs)
+         \\ = backslash
+         */
+         const auto ch=field[i];
+         const bool punctuation = escape && (ch=='\"' || ch=='\'' || ch=='\?' || ch=='\\');
+
+         if (escape && punctuation && !_filename.empty()) {
+            _filename.resize(_filename.size()-1); // remove last backslash
+            _filename += ch; // replace it with punctuation
          }
-         // Parse the Expect header, to identify the request to 
-         // send 100-Continue to the client in order to get the
-         // rest of multi-part header/body
+         else if (ch == '\"')
+            break;
          else
-         {
-            if (headerName == "EXPECT:" && tokens[1][0] == '1')
-            {
-               const auto value = StrUtils::uppercase(StrUtils::trim(tokens[1]));
-               _expected_100_continue = value == "100-CONTINUE";
-            }
-         }
+            _filename += ch;
       }
+
+      // Only the first filename is taken
+      break;
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequest::parseTransferEncodingHeader(std::string_view value)
+{
+   // The header value is the list of the codings applied, such as:
+   //
+   // Transfer-Encoding: chunked
+   //
+   // Only the chunked coding is supported, any other coding makes
+   // the body length unknown
+   bool chunked = false;
+   bool others = false;
+
+   for (auto coding : StrUtils::tokenize(value, ","))
+   {
+      coding = StrUtils::trimView(coding);
+
+      if (StrUtils::iequals(coding, "chunked"))
+         chunked = true;
+      else if (!coding.empty())
+         others = true;
+   }
+
+   _chunked = chunked && !others;
+   _unsupportedTransferCoding = !_chunked;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequest::parseHeader(Field field, std::string_view value)
+{
+   if (value.empty())
+      return;
+
+   switch (field)
+   {
+   case Field::keepAlive:
+      parseKeepAliveHeader(value);
+      break;
+
+   case Field::connection:
+      parseConnectionHeader(value);
+      break;
+
+   // A length which is not a valid number makes the body
+   // length unknown
+   case Field::contentLength:
+      if (!parseLength(value, _contentLength))
+      {
+         _contentLength = 0;
+         _malformedBody = true;
+      }
+      break;
+
+   case Field::contentType:
+      parseContentTypeHeader(value);
+      break;
+
+   case Field::contentDisposition:
+      parseContentDispositionHeader(value);
+      break;
+
+   // Parse the Expect header, to identify the request to
+   // send 100-Continue to the client in order to get the
+   // rest of multi-part header/body
+   case Field::expect:
+      _expected_100_continue = StrUtils::iequals(value, "100-continue");
+      break;
+
+   case Field::transferEncoding:
+      parseTransferEncodingHeader(value);
+      break;
+
+   default:
+      break;
    }
 }
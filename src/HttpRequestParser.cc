@@ -0,0 +1,495 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "HttpRequestParser.h"
+#include "StrUtils.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequestParser::reset(HttpRequest::Handle handle)
+{
+   _request = handle;
+   _stage = Stage::head;
+   _head.clear();
+   _partSt = PartSt::preamble;
+   _parts = 0;
+   _line.clear();
+   _upload.reset();
+   _body.clear();
+   _bodyToReceive = 0;
+   _bodyReceived = 0;
+   _chunked = false;
+   _delimited = false;
+   _complete = false;
+   _idle = true;
+
+   // A request whose head has been already received goes on
+   // with its body
+   if (_request && _request->hasHead())
+      startBody();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequestParser::reject(int status)
+{
+   _request->setErrorStatus(status);
+   _request->setMalformedBody();
+   _complete = true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpRequestParser::admitBody(size_t size)
+{
+   _bodyReceived += size;
+
+   if (_limits.maxBodySize > 0 && _bodyReceived > _limits.maxBodySize)
+   {
+      reject(413); // Payload Too Large
+      return false;
+   }
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequestParser::startBody()
+{
+   // The body length cannot be determined (or its Content-Length
+   // is not valid)
+   if (_request->hasUnsupportedTransferCoding() || _request->isMalformedBody())
+   {
+      _request->setMalformedBody();
+      _stage = Stage::body;
+      _complete = true;
+      return;
+   }
+
+   // A chunked body is framed by its last chunk, any other body
+   // by the Content-Length header
+   _chunked = _request->isChunked();
+   _bodyToReceive = _chunked ? 0 : size_t(_request->getContentLength());
+
+
+   if (_chunked)
+      _decoder.reset(_limits.chunked);
+
+   const auto &boundary = _request->getBoundary();
+
+   // A multipart body whose length is not given otherwise is framed
+   // by its close delimiter
+   if (!boundary.empty())
+   {
+      _stage = Stage::multipartBody;
+      _delimited = !_chunked && _bodyToReceive == 0;
+      _scanner.reset(boundary);
+      return;
+   }
+
+   _stage = Stage::body;
+   _complete = !_chunked && _bodyToReceive == 0;
+
+   if (!_complete)
+      startUpload();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequestParser::startUpload()
+{
+   // Only the content of a file posted is written to the repository,
+   // if it cannot be created the content is received in memory
+   if (_repository &&
+       _request->getRoute().endpoint == HttpRouter::Endpoint::store &&
+       !_request->getFileName().empty())
+   {
+      _upload = _repository->createUpload(_request->getFileName());
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequestParser::appendBody(const char *data, size_t size)
+{
+   if (size == 0)
+      return;
+
+   // A write error is reported once the upload is committed
+   if (_upload)
+      _upload->write(data, size);
+   else
+      _body.append(data, size);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequestParser::processHead(std::string_view head, bool copied)
+{
+   // Each header field takes a line following the request line
+   if (_limits.maxHeaders > 0 &&
+       size_t(std::count(head.begin(), head.end(), '\n')) > _limits.maxHeaders + 1)
+   {
+      _head.clear();
+      reject(431); // Request Header Fields Too Large
+      return;
+   }
+
+   _request->parseHead(head);
+
+   // Client is waiting for a 100-Continue response before sending
+   // the rest of the request, so the receive buffer will be reused
+   // while the request is still pending
+   const bool expectContinue = _request->isExpected_100_Continue_Response();
+
+   if (copied || expectContinue)
+      _request->persist();
+
+   _head.clear();
+
+   // A body announced larger than allowed is rejected before any
+   // part of it is received, rather than being solicited by a
+   // 100-Continue response (unless its length is not valid)
+   if (!_request->isChunked() &&
+       !_request->isMalformedBody() &&
+       _limits.maxBodySize > 0 &&
+       _request->getContentLength() > _limits.maxBodySize)
+   {
+      reject(413); // Payload Too Large
+      return;
+   }
+
+   if (expectContinue)
+   {
+      _stage = Stage::body;
+      _complete = true;
+      return;
+   }
+
+   startBody();
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t HttpRequestParser::feedHead(const char *data, size_t size)
+{
+   size_t pos = 0;
+
+   if (_head.empty())
+   {
+      // Any empty line preceding the request line is ignored
+      while (pos < size && (data[pos] == '\r' || data[pos] == '\n'))
+         ++pos;
+
+      if (pos == size)
+         return pos;
+
+      const std::string_view chunk(data + pos, size - pos);
+      const size_t end = chunk.find("\r\n\r\n");
+      const size_t maxSize = _limits.maxHeadSize;
+
+      // The head has been received in a single chunk: it is parsed
+      // where it is, without copying it
+      if (end != std::string_view::npos && (maxSize == 0 || end + 4 <= maxSize))
+      {
+         processHead(chunk.substr(0, end + 2), false);
+         return pos + end + 4;
+      }
+
+      // The head cannot end within the limit
+      if (maxSize > 0 && chunk.size() >= maxSize)
+      {
+         reject(431); // Request Header Fields Too Large
+         return size;
+      }
+
+      _head.assign(chunk.data(), chunk.size());
+      return size;
+   }
+
+   // The head is split across chunks, so it has to be gathered.
+   // The terminator search goes on where it stopped, taking into
+   // account a terminator split across chunks too
+   const size_t gathered = _head.size();
+   const size_t scanFrom = gathered >= 3 ? gathered - 3 : 0;
+   const size_t maxSize = _limits.maxHeadSize;
+
+   // Nothing beyond the limit is gathered
+   const size_t len = maxSize > 0 ? std::min(size, maxSize - gathered) : size;
+
+   _head.append(data, len);
+
+   const size_t end = _head.find("\r\n\r\n", scanFrom);
+
+   if (end == std::string::npos)
+   {
+      if (maxSize > 0 && _head.size() >= maxSize)
+      {
+         _head.clear();
+         reject(431); // Request Header Fields Too Large
+      }
+
+      return len;
+   }
+
+   _head.resize(end + 2);
+   processHead(_head, true);
+
+   return end + 4 - gathered;
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t HttpRequestParser::feedMultipartBody(const char *data, size_t size)
+{
+   // The part content is searched for the delimiter of the next part,
+   // while anything else (the line ending a delimiter, the part headers)
+   // is parsed line by line
+   if (_partSt == PartSt::preamble || _partSt == PartSt::content)
+   {
+      const auto res = _scanner.scan(data, size);
+
+      // Only the content of the first part is kept, the preamble
+      // and any further part are ignored
+      if (_partSt == PartSt::content && _parts == 1)
+      {
+         appendBody(res.carry.data(), res.carry.size());
+         appendBody(res.span.data(), res.span.size());
+      }
+
+      if (res.found)
+         _partSt = PartSt::delimiter;
+
+      return res.consumed;
+   }
+
+   // Anything following the close delimiter is ignored
+   if (_partSt == PartSt::epilogue)
+      return size;
+
+   const char *eol = static_cast<const char *>(std::memchr(data, '\n', size));
+   const size_t len = eol ? size_t(eol - data) + 1 : size;
+
+   // Part header lines are bounded as the request head is
+   if (_limits.maxHeadSize > 0 && _line.size() + len > _limits.maxHeadSize)
+   {
+      reject(431); // Request Header Fields Too Large
+      return size;
+   }
+
+   _line.append(data, len);
+
+   if (eol)
+   {
+      processPartLine();
+      _line.clear();
+   }
+
+   return len;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequestParser::processPartLine()
+{
+   if (_partSt == PartSt::delimiter)
+   {
+      // The close delimiter "--<boundary>--" terminates the multipart
+      // body, unless its length is given by Content-Length
+      if (isCloseDelimiter())
+      {
+         _partSt = PartSt::epilogue;
+         _complete = _delimited;
+         return;
+      }
+
+      // Any other delimiter is followed by the headers of a new part
+      // (and possibly by some white space)
+      _partSt = PartSt::headers;
+
+      if (++_parts == 1)
+      {
+         // The delimiter line is kept for logging purposes only
+         const auto &delimiter = _scanner.getDelimiter();
+         _request->parseHeaderLine(std::string_view(delimiter).substr(2));
+         _request->parseHeaderLine(_line);
+      }
+
+      return;
+   }
+
+   // The empty line following the part headers starts the part content
+   if (_line == "\r\n")
+   {
+      _partSt = PartSt::content;
+      _scanner.resume();
+
+      if (_parts == 1)
+         startUpload();
+
+      return;
+   }
+
+   if (_parts == 1)
+      _request->parseHeaderLine(_line);
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t HttpRequestParser::feedChunked(const char *data, size_t size)
+{
+   std::string_view content;
+   const size_t consumed = _decoder.decode(data, size, content);
+
+   if (!admitBody(content.size()))
+      return consumed;
+
+   // The content decoded is passed through as the content received
+   if (_stage == Stage::multipartBody)
+   {
+      while (!content.empty())
+         content.remove_prefix(feedMultipartBody(content.data(), content.size()));
+   }
+   else
+   {
+      appendBody(content.data(), content.size());
+   }
+
+   if (_decoder.isError())
+   {
+      _request->setMalformedBody();
+      _complete = true;
+   }
+   else if (_decoder.isDone())
+   {
+      completeBody();
+   }
+
+   return consumed;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequestParser::completeBody()
+{
+   // A multipart body must end with its close delimiter
+   if (_stage == Stage::multipartBody &&
+       _partSt != PartSt::epilogue &&
+       !isCloseDelimiter())
+   {
+      _request->setMalformedBody();
+   }
+
+   _complete = true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t HttpRequestParser::feed(const char *data, size_t size)
+{
+   assert(_request);
+
+   size_t pos = 0;
+
+   if (_complete)
+      return pos;
+
+   if (size > 0)
+      _idle = false;
+
+   while (pos < size && !_complete)
+   {
+      if (_chunked && _stage != Stage::head)
+      {
+         pos += feedChunked(data + pos, size - pos);
+         continue;
+      }
+
+      switch (_stage)
+      {
+      case Stage::head:
+         pos += feedHead(data + pos, size - pos);
+         break;
+
+      case Stage::multipartBody:
+      {
+         const size_t len = _bodyToReceive > 0 ?
+            std::min(_bodyToReceive, size - pos) : size - pos;
+
+         const size_t consumed = feedMultipartBody(data + pos, len);
+         pos += consumed;
+
+         // A body framed by its close delimiter is bounded as it
+         // is received
+         if (_delimited && !admitBody(consumed))
+            break;
+
+         if (_bodyToReceive > 0)
+         {
+            _bodyToReceive -= consumed;
+
+            // The body is over, even if its close delimiter is
+            // not followed by a line terminator
+            if (_bodyToReceive == 0)
+               completeBody();
+         }
+         break;
+      }
+
+      // Raw body framed by the Content-Length header
+      case Stage::body:
+      default:
+      {
+         const size_t len = std::min(_bodyToReceive, size - pos);
+         appendBody(data + pos, len);
+         pos += len;
+         _bodyToReceive -= len;
+         _complete = _bodyToReceive == 0;
+         break;
+      }
+      }
+   }
+
+   // The body goes on in the next chunks, which may overwrite
+   // the receive buffer the request head refers to
+   if (!_complete && _stage != Stage::head)
+      _request->persist();
+
+   if (_complete)
+      finalize();
+
+   return pos;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpRequestParser::finalize()
+{
+   // The content of a malformed body is discarded, including
+   // any upload in progress
+   if (_request->isMalformedBody())
+   {
+      _upload.reset();
+      _body.clear();
+      return;
+   }
+
+   if (_upload)
+      _request->setUpload(std::move(_upload));
+   else if (!_body.empty())
+      _request->setBody(std::move(_body));
+
+   _body.clear();
+}
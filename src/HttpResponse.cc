@@ -14,38 +14,603 @@
 #include "FileUtils.h"
 #include "SysUtils.h"
 
+#include "PerfectHash.h"
+
 #include "config.h"
 
+#include <array>
+#include <charconv>
+#include <iterator>
+
 /* -------------------------------------------------------------------------- */
 
-void HttpResponse::formatError(int code)
+namespace
+{
+
+// Fragments of the response headers, composed at compile time, so that
+// a header is put together by a few copies
+constexpr std::string_view okStatusLine = HTTPSRV_VER " 200 OK\r\nDate: ";
+constexpr std::string_view dateField = "\r\nDate: ";
+constexpr std::string_view serverField = "\r\nServer: " HTTPSRV_NAME "\r\nContent-Length: ";
+constexpr std::string_view chunkedField = "\r\nServer: " HTTPSRV_NAME "\r\nTransfer-Encoding: chunked";
+constexpr std::string_view lastModifiedField = "\r\nLast Modified: ";
+constexpr std::string_view contentTypeField = "\r\nContent-Type: ";
+constexpr std::string_view endOfHeader = "\r\n\r\n";
+
+// Room reserved up front for a header, which is then filled
+// without reallocations
+constexpr size_t headerCapacity = 256;
+
+// Appends the decimal representation of a number
+template <typename String, typename T>
+void appendNumber(String &str, T value)
+{
+   char digits[24];
+   const auto res = std::to_chars(digits, digits + sizeof(digits), value);
+   str.append(digits, res.ptr);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+namespace
 {
-   auto it = _errTbl.find(code);
 
-   std::string msg;
+//! Entry of the MIME type table
+struct MimeType
+{
+   std::string_view ext;
+   std::string_view type;
+};
 
-   if (it != _errTbl.end())
+// Content types by file extension, in lowercase and sorted. Where an
+// extension is listed more than once, its first entry is the one in use.
+constexpr MimeType mimeTypes[] = {
+   {".3dm", "x-world/x-3dmf"},
+   {".3dmf", "x-world/x-3dmf"},
+   {".a", "application/octet-stream"},
+   {".aab", "application/x-authorware-bin"},
+   {".aam", "application/x-authorware-map"},
+   {".aas", "application/x-authorware-seg"},
+   {".abc", "text/vnd.abc"},
+   {".acgi", "text/html"},
+   {".afl", "video/animaflex"},
+   {".ai", "application/postscript"},
+   {".aif", "audio/aiff"},
+   {".aifc", "audio/aiff"},
+   {".aiff", "audio/aiff"},
+   {".aim", "application/x-aim"},
+   {".aip", "text/x-audiosoft-intra"},
+   {".ani", "application/x-navi-animation"},
+   {".aos", "application/x-nokia-9000-communicator-add-on-software"},
+   {".aps", "application/mime"},
+   {".arc", "application/octet-stream"},
+   {".arj", "application/arj"},
+   {".art", "image/x-jg"},
+   {".asf", "video/x-ms-asf"},
+   {".asm", "text/x-asm"},
+   {".asp", "text/asp"},
+   {".asx", "application/x-mplayer2"},
+   {".au", "audio/basic"},
+   {".avi", "video/avi"},
+   {".avs", "video/avs-video"},
+   {".bcpio", "application/x-bcpio"},
+   {".bin", "application/octet-stream"},
+   {".bm", "image/bmp"},
+   {".bmp", "image/bmp"},
+   {".boo", "application/book"},
+   {".book", "application/book"},
+   {".boz", "application/x-bzip2"},
+   {".bsh", "application/x-bsh"},
+   {".bz", "application/x-bzip"},
+   {".bz2", "application/x-bzip2"},
+   {".c", "text/plain"},
+   {".c++", "text/plain"},
+   {".cat", "application/vnd.ms-pki.seccat"},
+   {".cc", "text/x-c"},
+   {".ccad", "application/clariscad"},
+   {".cco", "application/x-cocoa"},
+   {".cdf", "application/cdf"},
+   {".cer", "application/pkix-cert"},
+   {".cha", "application/x-chat"},
+   {".chat", "application/x-chat"},
+   {".class", "application/java"},
+   {".com", "application/octet-stream"},
+   {".conf", "text/plain"},
+   {".cpio", "application/x-cpio"},
+   {".cpp", "text/x-c"},
+   {".cpt", "application/x-cpt"},
+   {".crl", "application/pkcs-crl"},
+   {".crt", "application/pkix-cert"},
+   {".csh", "application/x-csh"},
+   {".css", "text/css"},
+   {".cxx", "text/plain"},
+   {".dcr", "application/x-director"},
+   {".deepv", "application/x-deepv"},
+   {".def", "text/plain"},
+   {".der", "application/x-x509-ca-cert"},
+   {".dif", "video/x-dv"},
+   {".dir", "application/x-director"},
+   {".dl", "video/dl"},
+   {".doc", "application/msword"},
+   {".docx", "application/"
+             "vnd.openxmlformats-officedocument.wordprocessingml.document"},
+   {".dot", "application/msword"},
+   {".dp", "application/commonground"},
+   {".drw", "application/drafting"},
+   {".dump", "application/octet-stream"},
+   {".dv", "video/x-dv"},
+   {".dvi", "application/x-dvi"},
+   {".dwf", "drawing/x-dwf (old)"},
+   {".dwg", "application/acad"},
+   {".dxf", "application/dxf"},
+   {".dxr", "application/x-director"},
+   {".el", "text/x-script.elisp"},
+   {".elc", "application/x-elc"},
+   {".env", "application/x-envoy"},
+   {".eps", "application/postscript"},
+   {".es", "application/x-esrehber"},
+   {".etx", "text/x-setext"},
+   {".evy", "application/envoy"},
+   {".exe", "application/octet-stream"},
+   {".f", "text/x-fortran"},
+   {".f77", "text/x-fortran"},
+   {".f90", "text/x-fortran"},
+   {".fdf", "application/vnd.fdf"},
+   {".fif", "image/fif"},
+   {".fli", "video/fli"},
+   {".flo", "image/florian"},
+   {".flx", "text/vnd.fmi.flexstor"},
+   {".fmf", "video/x-atomic3d-feature"},
+   {".for", "text/x-fortran"},
+   {".fpx", "image/vnd.fpx"},
+   {".frl", "application/freeloader"},
+   {".funk", "audio/make"},
+   {".g", "text/plain"},
+   {".g3", "image/g3fax"},
+   {".gif", "image/gif"},
+   {".gl", "video/gl"},
+   {".gsd", "audio/x-gsm"},
+   {".gsm", "audio/x-gsm"},
+   {".gsp", "application/x-gsp"},
+   {".gss", "application/x-gss"},
+   {".gtar", "application/x-gtar"},
+   {".gz", "application/x-compressed"},
+   {".gzip", "application/x-gzip"},
+   {".h", "text/x-h"},
+   {".hdf", "application/x-hdf"},
+   {".help", "application/x-helpfile"},
+   {".hgl", "application/vnd.hp-hpgl"},
+   {".hh", "text/x-h"},
+   {".hlb", "text/x-script"},
+   {".hlp", "application/hlp"},
+   {".hpg", "application/vnd.hp-hpgl"},
+   {".hpgl", "application/vnd.hp-hpgl"},
+   {".hqx", "application/binhex"},
+   {".hta", "application/hta"},
+   {".htc", "text/x-component"},
+   {".htm", "text/html"},
+   {".html", "text/html"},
+   {".htmls", "text/html"},
+   {".htt", "text/webviewhtml"},
+   {".htx", "text/html"},
+   {".ice", "x-conference/x-cooltalk"},
+   {".ico", "image/x-icon"},
+   {".idc", "text/plain"},
+   {".ief", "image/ief"},
+   {".iefs", "image/ief"},
+   {".iges", "application/iges"},
+   {".igs", "application/iges"},
+   {".ima", "application/x-ima"},
+   {".imap", "application/x-httpd-imap"},
+   {".inf", "application/inf"},
+   {".ins", "application/x-internett-signup"},
+   {".ip", "application/x-ip2"},
+   {".isu", "video/x-isvideo"},
+   {".it", "audio/it"},
+   {".iv", "application/x-inventor"},
+   {".ivr", "i-world/i-vrml"},
+   {".ivy", "application/x-livescreen"},
+   {".jam", "audio/x-jam"},
+   {".jav", "text/x-java-source"},
+   {".java", "text/x-java-source"},
+   {".jcm", "application/x-java-commerce"},
+   {".jfif", "image/jpeg"},
+   {".jpe", "image/jpeg"},
+   {".jpeg", "image/jpeg"},
+   {".jpg", "image/jpeg"},
+   {".jps", "image/x-jps"},
+   {".js", "application/javascript"},
+   {".json", "application/json"},
+   {".jut", "image/jutvision"},
+   {".kar", "audio/midi"},
+   {".ksh", "application/x-ksh"},
+   {".la", "audio/nspaudio"},
+   {".lam", "audio/x-liveaudio"},
+   {".latex", "application/x-latex"},
+   {".lha", "application/lha"},
+   {".lhx", "application/octet-stream"},
+   {".list", "text/plain"},
+   {".lma", "audio/nspaudio"},
+   {".log", "text/plain"},
+   {".lsp", "application/x-lisp"},
+   {".lst", "text/plain"},
+   {".lsx", "text/x-la-asf"},
+   {".ltx", "application/x-latex"},
+   {".lzh", "application/x-lzh"},
+   {".lzx", "application/lzx"},
+   {".m", "text/x-m"},
+   {".m1v", "video/mpeg"},
+   {".m2a", "audio/mpeg"},
+   {".m2v", "video/mpeg"},
+   {".m3u", "audio/x-mpequrl"},
+   {".man", "application/x-troff-man"},
+   {".map", "application/x-navimap"},
+   {".mar", "text/plain"},
+   {".mbd", "application/mbedlet"},
+   {".mcd", "application/mcad"},
+   {".mcf", "image/vasa"},
+   {".mcp", "application/netmc"},
+   {".me", "application/x-troff-me"},
+   {".mht", "message/rfc822"},
+   {".mhtml", "message/rfc822"},
+   {".mid", "audio/midi"},
+   {".midi", "audio/midi"},
+   {".mif", "application/x-frame"},
+   {".mime", "message/rfc822"},
+   {".mjf", "audio/x-vnd.audioexplosion.mjuicemediafile"},
+   {".mjpg", "video/x-motion-jpeg"},
+   {".mm", "application/base64"},
+   {".mme", "application/base64"},
+   {".mod", "audio/mod"},
+   {".moov", "video/quicktime"},
+   {".mov", "video/quicktime"},
+   {".movie", "video/x-sgi-movie"},
+   {".mp2", "audio/mpeg"},
+   {".mp3", "audio/mpeg3"},
+   {".mpa", "audio/mpeg"},
+   {".mpc", "application/x-project"},
+   {".mpe", "video/mpeg"},
+   {".mpeg", "video/mpeg"},
+   {".mpg", "audio/mpeg"},
+   {".mpga", "audio/mpeg"},
+   {".mpp", "application/vnd.ms-project"},
+   {".mpt", "application/x-project"},
+   {".mpv", "application/x-project"},
+   {".mpx", "application/x-project"},
+   {".mrc", "application/marc"},
+   {".ms", "application/x-troff-ms"},
+   {".mv", "video/x-sgi-movie"},
+   {".my", "audio/make"},
+   {".mzz", "application/x-vnd.audioexplosion.mzz"},
+   {".nap", "image/naplps"},
+   {".naplps", "image/naplps"},
+   {".nc", "application/x-netcdf"},
+   {".ncm", "application/vnd.nokia.configuration-message"},
+   {".nif", "image/x-niff"},
+   {".niff", "image/x-niff"},
+   {".nix", "application/x-mix-transfer"},
+   {".nsc", "application/x-conference"},
+   {".nvd", "application/x-navidoc"},
+   {".o", "application/octet-stream"},
+   {".oda", "application/oda"},
+   {".omc", "application/x-omc"},
+   {".omcd", "application/x-omcdatamaker"},
+   {".omcr", "application/x-omcregerator"},
+   {".p", "text/x-pascal"},
+   {".p10", "application/pkcs10"},
+   {".p12", "application/pkcs-12"},
+   {".p7a", "application/x-pkcs7-signature"},
+   {".p7c", "application/pkcs7-mime"},
+   {".p7m", "application/pkcs7-mime"},
+   {".p7r", "application/x-pkcs7-certreqresp"},
+   {".p7s", "application/pkcs7-signature"},
+   {".part", "application/pro_eng"},
+   {".pas", "text/pascal"},
+   {".pbm", "image/x-portable-bitmap"},
+   {".pcl", "application/vnd.hp-pcl"},
+   {".pct", "image/x-pict"},
+   {".pcx", "image/x-pcx"},
+   {".pdb", "chemical/x-pdb"},
+   {".pdf", "application/pdf"},
+   {".pfunk", "audio/make"},
+   {".pgm", "image/x-portable-graymap"},
+   {".pic", "image/pict"},
+   {".pict", "image/pict"},
+   {".pkg", "application/x-newton-compatible-pkg"},
+   {".pko", "application/vnd.ms-pki.pko"},
+   {".pl", "text/x-script.perl"},
+   {".plx", "application/x-pixclscript"},
+   {".pm", "text/x-script.perl-module"},
+   {".pm4", "application/x-pagemaker"},
+   {".pm5", "application/x-pagemaker"},
+   {".png", "image/png"},
+   {".pnm", "application/x-portable-anymap"},
+   {".pot", "application/vnd.ms-powerpoint"},
+   {".pov", "model/x-pov"},
+   {".ppa", "application/vnd.ms-powerpoint"},
+   {".ppm", "image/x-portable-pixmap"},
+   {".pps", "application/vnd.ms-powerpoint"},
+   {".ppt", "application/vnd.ms-powerpoint"},
+   {".ppz", "application/vnd.ms-powerpoint"},
+   {".pre", "application/x-freelance"},
+   {".prt", "application/pro_eng"},
+   {".ps", "application/postscript"},
+   {".psd", "application/octet-stream"},
+   {".pvu", "paleovu/x-pv"},
+   {".pwz", "application/vnd.ms-powerpoint"},
+   {".py", "text/x-script.phyton"},
+   {".pyc", "applicaiton/x-bytecode.python"},
+   {".qcp", "audio/vnd.qcelp"},
+   {".qd3", "x-world/x-3dmf"},
+   {".qd3d", "x-world/x-3dmf"},
+   {".qif", "image/x-quicktime"},
+   {".qt", "video/quicktime"},
+   {".qtc", "video/x-qtc"},
+   {".qti", "image/x-quicktime"},
+   {".qtif", "image/x-quicktime"},
+   {".ra", "audio/x-pn-realaudio"},
+   {".ram", "audio/x-pn-realaudio"},
+   {".ras", "image/cmu-raster"},
+   {".rast", "image/cmu-raster"},
+   {".rexx", "text/x-script.rexx"},
+   {".rf", "image/vnd.rn-realflash"},
+   {".rgb", "image/x-rgb"},
+   {".rm", "audio/x-pn-realaudio"},
+   {".rmi", "audio/mid"},
+   {".rmm", "audio/x-pn-realaudio"},
+   {".rmp", "audio/x-pn-realaudio"},
+   {".rng", "application/ringing-tones"},
+   {".rnx", "application/vnd.rn-realplayer"},
+   {".roff", "application/x-troff"},
+   {".rp", "image/vnd.rn-realpix"},
+   {".rpm", "audio/x-pn-realaudio-plugin"},
+   {".rt", "text/richtext"},
+   {".rtf", "application/rtf"},
+   {".rtx", "application/rtf"},
+   {".rv", "video/vnd.rn-realvideo"},
+   {".s", "text/x-asm"},
+   {".s3m", "audio/s3m"},
+   {".saveme", "application/octet-stream"},
+   {".sbk", "application/x-tbook"},
+   {".scm", "application/x-lotusscreencam"},
+   {".sdml", "text/plain"},
+   {".sdp", "application/sdp"},
+   {".sdr", "application/sounder"},
+   {".sea", "application/sea"},
+   {".set", "application/set"},
+   {".sgm", "text/sgml"},
+   {".sgml", "text/sgml"},
+   {".sh", "application/x-sh"},
+   {".shar", "application/x-shar"},
+   {".shtml", "text/html"},
+   {".sid", "audio/x-psid"},
+   {".sit", "application/x-sit"},
+   {".skd", "application/x-koan"},
+   {".skm", "application/x-koan"},
+   {".skp", "application/x-koan"},
+   {".skt", "application/x-koan"},
+   {".sl", "application/x-seelogo"},
+   {".smi", "application/smil"},
+   {".smil", "application/smil"},
+   {".snd", "audio/basic"},
+   {".sol", "application/solids"},
+   {".spc", "text/x-speech"},
+   {".spl", "application/futuresplash"},
+   {".spr", "application/x-sprite"},
+   {".sprite", "application/x-sprite"},
+   {".src", "application/x-wais-source"},
+   {".ssi", "text/x-server-parsed-html"},
+   {".ssm", "application/streamingmedia"},
+   {".sst", "application/vnd.ms-pki.certstore"},
+   {".step", "application/step"},
+   {".stl", "application/sla"},
+   {".stp", "application/step"},
+   {".sv4cpio", "application/x-sv4cpio"},
+   {".sv4crc", "application/x-sv4crc"},
+   {".svf", "image/vnd.dwg"},
+   {".svr", "application/x-world"},
+   {".swf", "application/x-shockwave-flash"},
+   {".t", "application/x-troff"},
+   {".talk", "text/x-speech"},
+   {".tar", "application/x-tar"},
+   {".tbk", "application/toolbook"},
+   {".tcl", "application/x-tcl"},
+   {".tcsh", "text/x-script.tcsh"},
+   {".tex", "application/x-tex"},
+   {".texi", "application/x-texinfo"},
+   {".texinfo", "application/x-texinfo"},
+   {".text", "text/plain"},
+   {".tgz", "application/x-compressed"},
+   {".tif", "image/tiff"},
+   {".tiff", "image/x-tiff"},
+   {".tr", "application/x-troff"},
+   {".tsi", "audio/tsp-audio"},
+   {".tsp", "audio/tsplayer"},
+   {".tsv", "text/tab-separated-values"},
+   {".turbot", "image/florian"},
+   {".txt", "text/plain"},
+   {".uil", "text/x-uil"},
+   {".uni", "text/uri-list"},
+   {".unis", "text/uri-list"},
+   {".unv", "application/i-deas"},
+   {".uri", "text/uri-list"},
+   {".uris", "text/uri-list"},
+   {".ustar", "application/x-ustar"},
+   {".uu", "text/x-uuencode"},
+   {".uue", "text/x-uuencode"},
+   {".vcd", "application/x-cdlink"},
+   {".vcs", "text/x-vcalendar"},
+   {".vda", "application/vda"},
+   {".vdo", "video/vdo"},
+   {".vew", "application/groupwise"},
+   {".viv", "video/vivo"},
+   {".vivo", "video/vivo"},
+   {".vmd", "application/vocaltec-media-desc"},
+   {".vmf", "application/vocaltec-media-file"},
+   {".voc", "audio/voc"},
+   {".vos", "video/vosaic"},
+   {".vox", "audio/voxware"},
+   {".vqe", "audio/x-twinvq-plugin"},
+   {".vqf", "audio/x-twinvq"},
+   {".vql", "audio/x-twinvq-plugin"},
+   {".vrml", "model/vrml"},
+   {".vrt", "x-world/x-vrt"},
+   {".vsd", "application/x-visio"},
+   {".vst", "application/x-visio"},
+   {".vsw", "application/x-visio"},
+   {".w60", "application/wordperfect6.0"},
+   {".w61", "application/wordperfect6.1"},
+   {".w6w", "application/msword"},
+   {".wav", "audio/wav"},
+   {".wb1", "application/x-qpro"},
+   {".wbmp", "image/vnd.wap.wbmp"},
+   {".web", "application/vnd.xara"},
+   {".wiz", "application/msword"},
+   {".wk1", "application/x-123"},
+   {".wmf", "windows/metafile"},
+   {".wml", "text/vnd.wap.wml"},
+   {".wmlc", "application/vnd.wap.wmlc"},
+   {".wmls", "text/vnd.wap.wmlscript"},
+   {".wmlsc", "application/vnd.wap.wmlscriptc"},
+   {".word", "application/msword"},
+   {".wp", "application/wordperfect"},
+   {".wp5", "application/wordperfect"},
+   {".wp6", "application/wordperfect"},
+   {".wpd", "application/wordperfect"},
+   {".wq1", "application/x-lotus"},
+   {".wri", "application/mswrite"},
+   {".wrl", "model/vrml"},
+   {".wrz", "model/vrml"},
+   {".wsc", "text/scriplet"},
+   {".wsrc", "application/x-wais-source"},
+   {".wtk", "application/x-wintalk"},
+   {".xbm", "image/x-xbitmap"},
+   {".xdr", "video/x-amt-demorun"},
+   {".xgz", "xgl/drawing"},
+   {".xif", "image/vnd.xiff"},
+   {".xl", "application/vnd.ms-excel"},
+   {".xla", "application/vnd.ms-excel"},
+   {".xlb", "application/vnd.ms-excel"},
+   {".xlc", "application/vnd.ms-excel"},
+   {".xld", "application/vnd.ms-excel"},
+   {".xlk", "application/vnd.ms-excel"},
+   {".xll", "application/vnd.ms-excel"},
+   {".xlm", "application/vnd.ms-excel"},
+   {".xls", "application/vnd.ms-excel"},
+   {".xlt", "application/vnd.ms-excel"},
+   {".xlv", "application/vnd.ms-excel"},
+   {".xlw", "application/vnd.ms-excel"},
+   {".xm", "audio/xm"},
+   {".xml", "application/xml"},
+   {".xmz", "xgl/movie"},
+   {".xpix", "application/x-vnd.ls-xpix"},
+   {".xpm", "image/xpm"},
+   {".xsr", "video/x-amt-showrun"},
+   {".xwd", "image/x-xwd"},
+   {".xyz", "chemical/x-pdb"},
+   {".z", "application/x-compress"},
+   {".zip", "application/zip"},
+   {".zoo", "application/octet-stream"},
+   {".zsh", "text/x-script.zsh"},
+};
+
+constexpr size_t mimeTypeCount = std::size(mimeTypes);
+
+constexpr bool isLowercase(std::string_view str) noexcept
+{
+   for (char c : str)
    {
-      msg = it->second;
+      if (c >= 'A' && c <= 'Z')
+         return false;
    }
-   else
+
+   return true;
+}
+
+constexpr bool isMimeTableValid() noexcept
+{
+   for (size_t entry = 0; entry < mimeTypeCount; ++entry)
    {
-      code = 500;
-      msg = "Internal Server Error";
+      if (!isLowercase(mimeTypes[entry].ext))
+         return false;
+
+      if (entry > 0 && mimeTypes[entry].ext < mimeTypes[entry - 1].ext)
+         return false;
    }
 
-   std::string scode = std::to_string(code);
+   return true;
+}
+
+static_assert(isMimeTableValid(), "MIME type table must be lowercase and sorted");
+
+constexpr std::array<std::string_view, mimeTypeCount> getMimeExtensions() noexcept
+{
+   std::array<std::string_view, mimeTypeCount> extensions{};
+
+   for (size_t entry = 0; entry < mimeTypeCount; ++entry)
+      extensions[entry] = mimeTypes[entry].ext;
+
+   return extensions;
+}
+
+// Extensions are found regardless of their case
+constexpr PerfectHash<mimeTypeCount, true> mimeHash(getMimeExtensions());
+
+static_assert(mimeHash.hasDistinctKeys(), "Duplicate extension in the MIME type table");
+static_assert(mimeHash.isPerfect(), "No perfect hash found for the MIME type table");
+
+//! Returns the content type of a file extension (e.g. ".txt")
+std::string_view findMimeType(std::string_view ext) noexcept
+{
+   const int i = mimeHash.find(ext);
+
+   return i < 0 ?
+      std::string_view("application/octet-stream") :
+      mimeTypes[size_t(i)].type;
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+//! Error response serialized once, which is sent along with its date
+struct HttpResponse::PreparedError
+{
+   //! Status line, headers and body
+   std::string data;
+
+   //! Position of the date within data
+   size_t dateOffset = 0;
+
+   //! Returns the slices of the response, the date replaced
+   Slices getSlices(std::string_view date) const noexcept
+   {
+      const std::string_view view(data);
+
+      return {
+         view.substr(0, dateOffset),
+         date,
+         view.substr(dateOffset + date.size())};
+   }
+};
+
+/* -------------------------------------------------------------------------- */
+
+void HttpResponse::formatError(int code)
+{
+   auto it = _preparedErrTbl.find(code);
+
+   if (it == _preparedErrTbl.end())
+      it = _preparedErrTbl.find(500);
 
-   std::string error_html 
-      = "<html><head><title>" + scode + " " + msg + "</title></head>" 
-      + "<body>" + msg + "</body></html>\r\n";
+   // Only the date is stored, status line, headers and body are shared
+   _preparedError = &it->second;
+   _date.assign(SysUtils::getHttpDate());
 
-   _response = HTTPSRV_VER " " + scode + " " + msg + "\r\n";
-   _response += "Date: " + SysUtils::getUtcTime() + "\r\n";
-   _response += "Server: " HTTPSRV_NAME "\r\n";
-   _response += "Content-Length: " + std::to_string(error_html.size()) + "\r\n";
-   _response += "Content-Type: text/html\r\n\r\n";
-   _response += error_html;
+   _header.clear();
+   _body.clear();
 
    _errorResponse = true;
 }
@@ -53,25 +618,37 @@ void HttpResponse::formatError(int code)
 /* -------------------------------------------------------------------------- */
 
 void HttpResponse::formatPositiveResponse(
-    const std::string &fileTime,
-    const std::string &fileExt,
-    const size_t &contentLen)
+    std::string_view fileTime,
+    std::string_view fileExt,
+    size_t contentLen)
 {
-
-   _response = HTTPSRV_VER " 200 OK\r\n";
-   _response += "Date: " + SysUtils::getUtcTime() + "\r\n";
-   _response += "Server: " HTTPSRV_NAME "\r\n";
-   _response += "Content-Length: " + std::to_string(contentLen) + "\r\n";
-   _response += "Last Modified: " + fileTime + "\r\n";
-   _response += "Content-Type: ";
+   _header.reserve(headerCapacity);
+   _header.assign(okStatusLine).append(SysUtils::getHttpDate());
+   _header.append(serverField);
+   appendNumber(_header, contentLen);
+   _header.append(lastModifiedField).append(fileTime);
+   _header.append(contentTypeField);
 
    // Resolve mime type using the uri/file extension
-   auto it = _mimeTbl.find(fileExt);
-
-   _response += it != _mimeTbl.end() ? it->second : "application/octet-stream";
+   _header.append(findMimeType(fileExt));
 
    // Close the rensponse header by using the sequence CRLF twice
-   _response += "\r\n\r\n";
+   _header.append(endOfHeader);
+
+   _errorResponse = false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpResponse::formatChunkedResponse(std::string_view fileExt)
+{
+   // The content is generated while it is sent
+   _header.reserve(headerCapacity);
+   _header.assign(okStatusLine).append(SysUtils::getHttpDate());
+   _header.append(chunkedField);
+   _header.append(lastModifiedField).append(SysUtils::getHttpDate());
+   _header.append(contentTypeField).append(findMimeType(fileExt));
+   _header.append(endOfHeader);
 
    _errorResponse = false;
 }
@@ -80,17 +657,21 @@ void HttpResponse::formatPositiveResponse(
 
 void HttpResponse::formatContinueResponse()
 {
-   _response = HTTPSRV_VER " 100 Continue\r\n\r\n";
+   _header = HTTPSRV_VER " 100 Continue\r\n\r\n";
    _errorResponse = false;
+   _continueResponse = true;
 }
 
 /* -------------------------------------------------------------------------- */
 
 HttpResponse::HttpResponse(
     const HttpRequest &request,
-    const std::string &body,
+    std::pmr::string body,
     const std::string &bodyFormat,
-    const std::string &nameOfFileToSend)
+    const char *nameOfFileToSend)
+    : _header(body.get_allocator()),
+      _body(body.get_allocator()),
+      _date(body.get_allocator())
 {
    if (request.getMethod() == HttpRequest::Method::UNKNOWN)
    {
@@ -106,7 +687,7 @@ HttpResponse::HttpResponse(
       }
       else
       {
-         if (request.getUri() != HTTPSRV_POST_STORE)
+         if (request.getRoute().endpoint != HttpRouter::Endpoint::store)
          {
             formatError(400); // Bad Request Error
          }
@@ -117,11 +698,11 @@ HttpResponse::HttpResponse(
          else
          {
             formatPositiveResponse(
-                SysUtils::getUtcTime(),
-                std::string(bodyFormat),
+                SysUtils::getHttpDate(),
+                bodyFormat,
                 body.size());
 
-            _response += body;
+            _body = std::move(body);
          }
       }
    }
@@ -129,7 +710,8 @@ HttpResponse::HttpResponse(
    { // GET
       if (body.empty())
       {
-         std::string fileTime, fileExt;
+         std::string fileTime;
+         std::string_view fileExt;
          size_t contentLen = 0;
 
          if (FileUtils::fileStat(nameOfFileToSend, fileTime, fileExt, contentLen))
@@ -144,22 +726,80 @@ HttpResponse::HttpResponse(
       else
       {
          formatPositiveResponse(
-             SysUtils::getUtcTime(),
-             std::string(bodyFormat),
+             SysUtils::getHttpDate(),
+             bodyFormat,
              body.size());
 
-         _response += body;
+         _body = std::move(body);
       }
    }
 }
 
 /* -------------------------------------------------------------------------- */
 
-std::ostream &HttpResponse::dump(std::ostream &os, const std::string &id)
+void HttpResponse::setConnectionHeaders(bool keepAlive, int timeout, int maxRequests)
+{
+   // An error response is pre-serialized closing the connection
+   if (_continueResponse || _preparedError)
+      return;
+
+   // Append the headers in place of the empty line closing the
+   // header section, which is then restored
+   assert(_header.size() >= 2);
+   _header.resize(_header.size() - 2);
+
+   if (keepAlive)
+   {
+      _header.append("Connection: keep-alive\r\n");
+      _header.append("Keep-Alive: timeout=");
+      appendNumber(_header, timeout);
+      _header.append(", max=");
+      appendNumber(_header, maxRequests);
+      _header.append("\r\n");
+   }
+   else
+   {
+      _header.append("Connection: close\r\n");
+   }
+
+   _header.append("\r\n");
+}
+
+/* -------------------------------------------------------------------------- */
+
+HttpResponse::Slices HttpResponse::getSlices() const noexcept
+{
+   if (_preparedError)
+      return _preparedError->getSlices(_date);
+
+   return {_header, _body, std::string_view()};
+}
+
+/* -------------------------------------------------------------------------- */
+
+HttpResponse::Slices HttpResponse::getErrorSlices(
+   int code, std::string_view date) noexcept
+{
+   auto it = _preparedErrTbl.find(code);
+
+   if (it == _preparedErrTbl.end())
+      it = _preparedErrTbl.find(500);
+
+   assert(date.size() == SysUtils::httpDateLength);
+
+   return it->second.getSlices(date);
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::ostream &HttpResponse::dump(std::ostream &os, const std::string &id) const
 {
    std::string ss;
    ss = "<<< RESPONSE " + id + "\n";
-   ss += _response;
+
+   for (const auto slice : getSlices())
+      ss += slice;
+
    os << ss << "\n";
    os.flush();
 
@@ -173,478 +813,59 @@ std::unordered_map<int, std::string> HttpResponse::_errTbl = {
     {403, "Forbidden"},
     {404, "Not Found"},
     {406, "Not Acceptable"},
+    {408, "Request Timeout"},
+    {413, "Payload Too Large"},
+    {429, "Too Many Requests"},
+    {431, "Request Header Fields Too Large"},
     {500, "Internal Server Error"},
     {501, "Not Implemented"},
+    {503, "Service Unavailable"},
 };
 
 /* -------------------------------------------------------------------------- */
 
-std::unordered_map<std::string, std::string> HttpResponse::_mimeTbl = {
-    {".3dm", "x-world/x-3dmf"},
-    {".3dmf", "x-world/x-3dmf"},
-    {".a", "application/octet-stream"},
-    {".aab", "application/x-authorware-bin"},
-    {".aam", "application/x-authorware-map"},
-    {".aas", "application/x-authorware-seg"},
-    {".abc", "text/vnd.abc"},
-    {".acgi", "text/html"},
-    {".afl", "video/animaflex"},
-    {".ai", "application/postscript"},
-    {".aif", "audio/aiff"},
-    {".aifc", "audio/aiff"},
-    {".aiff", "audio/aiff"},
-    {".aim", "application/x-aim"},
-    {".aip", "text/x-audiosoft-intra"},
-    {".ani", "application/x-navi-animation"},
-    {".aos", "application/x-nokia-9000-communicator-add-on-software"},
-    {".aps", "application/mime"},
-    {".arc", "application/octet-stream"},
-    {".arj", "application/arj"},
-    {".art", "image/x-jg"},
-    {".asf", "video/x-ms-asf"},
-    {".asm", "text/x-asm"},
-    {".asp", "text/asp"},
-    {".asx", "application/x-mplayer2"},
-    {".au", "audio/basic"},
-    {".avi", "video/avi"},
-    {".avs", "video/avs-video"},
-    {".bcpio", "application/x-bcpio"},
-    {".bin", "application/octet-stream"},
-    {".bm", "image/bmp"},
-    {".bmp", "image/bmp"},
-    {".boo", "application/book"},
-    {".book", "application/book"},
-    {".boz", "application/x-bzip2"},
-    {".bsh", "application/x-bsh"},
-    {".bz", "application/x-bzip"},
-    {".bz2", "application/x-bzip2"},
-    {".c", "text/plain"},
-    {".c++", "text/plain"},
-    {".cat", "application/vnd.ms-pki.seccat"},
-    {".cc", "text/x-c"},
-    {".ccad", "application/clariscad"},
-    {".cco", "application/x-cocoa"},
-    {".cdf", "application/cdf"},
-    {".cer", "application/pkix-cert"},
-    {".cha", "application/x-chat"},
-    {".chat", "application/x-chat"},
-    {".class", "application/java"},
-    {".com", "application/octet-stream"},
-    {".com", "text/plain"},
-    {".conf", "text/plain"},
-    {".cpio", "application/x-cpio"},
-    {".cpp", "text/x-c"},
-    {".cpt", "application/x-cpt"},
-    {".crl", "application/pkcs-crl"},
-    {".crt", "application/pkix-cert"},
-    {".csh", "application/x-csh"},
-    {".csh", "text/x-script.csh"},
-    {".css", "text/css"},
-    {".cxx", "text/plain"},
-    {".dcr", "application/x-director"},
-    {".deepv", "application/x-deepv"},
-    {".def", "text/plain"},
-    {".der", "application/x-x509-ca-cert"},
-    {".dif", "video/x-dv"},
-    {".dir", "application/x-director"},
-    {".dl", "video/dl"},
-    {".doc", "application/msword"},
-    {".docx", "application/"
-              "vnd.openxmlformats-officedocument.wordprocessingml.document"},
-    {".dot", "application/msword"},
-    {".dp", "application/commonground"},
-    {".drw", "application/drafting"},
-    {".dump", "application/octet-stream"},
-    {".dv", "video/x-dv"},
-    {".dvi", "application/x-dvi"},
-    {".dwf", "drawing/x-dwf (old)"},
-    {".dwf", "model/vnd.dwf"},
-    {".dwg", "application/acad"},
-    {".dxf", "application/dxf"},
-    {".dxr", "application/x-director"},
-    {".el", "text/x-script.elisp"},
-    {".elc", "application/x-elc"},
-    {".env", "application/x-envoy"},
-    {".eps", "application/postscript"},
-    {".es", "application/x-esrehber"},
-    {".etx", "text/x-setext"},
-    {".evy", "application/envoy"},
-    {".exe", "application/octet-stream"},
-    {".f", "text/x-fortran"},
-    {".f77", "text/x-fortran"},
-    {".f90", "text/x-fortran"},
-    {".fdf", "application/vnd.fdf"},
-    {".fif", "image/fif"},
-    {".fli", "video/fli"},
-    {".flo", "image/florian"},
-    {".flx", "text/vnd.fmi.flexstor"},
-    {".fmf", "video/x-atomic3d-feature"},
-    {".for", "text/x-fortran"},
-    {".fpx", "image/vnd.fpx"},
-    {".frl", "application/freeloader"},
-    {".funk", "audio/make"},
-    {".g", "text/plain"},
-    {".g3", "image/g3fax"},
-    {".gif", "image/gif"},
-    {".gl", "video/gl"},
-    {".gsd", "audio/x-gsm"},
-    {".gsm", "audio/x-gsm"},
-    {".gsp", "application/x-gsp"},
-    {".gss", "application/x-gss"},
-    {".gtar", "application/x-gtar"},
-    {".gz", "application/x-compressed"},
-    {".gz", "application/x-gzip"},
-    {".gzip", "application/x-gzip"},
-    {".h", "text/x-h"},
-    {".hdf", "application/x-hdf"},
-    {".help", "application/x-helpfile"},
-    {".hgl", "application/vnd.hp-hpgl"},
-    {".hh", "text/x-h"},
-    {".hlb", "text/x-script"},
-    {".hlp", "application/hlp"},
-    {".hpg", "application/vnd.hp-hpgl"},
-    {".hpgl", "application/vnd.hp-hpgl"},
-    {".hqx", "application/binhex"},
-    {".hqx", "application/binhex4"},
-    {".hta", "application/hta"},
-    {".htc", "text/x-component"},
-    {".htm", "text/html"},
-    {".html", "text/html"},
-    {".htmls", "text/html"},
-    {".htt", "text/webviewhtml"},
-    {".htx", "text/html"},
-    {".ice", "x-conference/x-cooltalk"},
-    {".ico", "image/x-icon"},
-    {".idc", "text/plain"},
-    {".ief", "image/ief"},
-    {".iefs", "image/ief"},
-    {".iges", "application/iges"},
-    {".iges", "model/iges"},
-    {".igs", "application/iges"},
-    {".igs", "model/iges"},
-    {".ima", "application/x-ima"},
-    {".imap", "application/x-httpd-imap"},
-    {".inf", "application/inf"},
-    {".ins", "application/x-internett-signup"},
-    {".ip", "application/x-ip2"},
-    {".isu", "video/x-isvideo"},
-    {".it", "audio/it"},
-    {".iv", "application/x-inventor"},
-    {".ivr", "i-world/i-vrml"},
-    {".ivy", "application/x-livescreen"},
-    {".jam", "audio/x-jam"},
-    {".jav", "text/x-java-source"},
-    {".java", "text/x-java-source"},
-    {".jcm", "application/x-java-commerce"},
-    {".jfif", "image/jpeg"},
-    {".jfif", "image/pjpeg"},
-    {".jpe", "image/jpeg"},
-    {".jpeg", "image/jpeg"},
-    {".jpg", "image/jpeg"},
-    {".jps", "image/x-jps"},
-    {".js", "application/javascript"},
-    {".jut", "image/jutvision"},
-    {".kar", "audio/midi"},
-    {".ksh", "application/x-ksh"},
-    {".la", "audio/nspaudio"},
-    {".lam", "audio/x-liveaudio"},
-    {".latex", "application/x-latex"},
-    {".lha", "application/lha"},
-    {".lhx", "application/octet-stream"},
-    {".list", "text/plain"},
-    {".lma", "audio/nspaudio"},
-    {".lma", "audio/x-nspaudio"},
-    {".log", "text/plain"},
-    {".lsp", "application/x-lisp"},
-    {".lst", "text/plain"},
-    {".lsx", "text/x-la-asf"},
-    {".ltx", "application/x-latex"},
-    {".lzh", "application/x-lzh"},
-    {".lzx", "application/lzx"},
-    {".m", "text/x-m"},
-    {".m1v", "video/mpeg"},
-    {".m2a", "audio/mpeg"},
-    {".m2v", "video/mpeg"},
-    {".m3u", "audio/x-mpequrl"},
-    {".man", "application/x-troff-man"},
-    {".map", "application/x-navimap"},
-    {".mar", "text/plain"},
-    {".mbd", "application/mbedlet"},
-    {".mcd", "application/mcad"},
-    {".mcf", "image/vasa"},
-    {".mcf", "text/mcf"},
-    {".mcp", "application/netmc"},
-    {".me", "application/x-troff-me"},
-    {".mht", "message/rfc822"},
-    {".mhtml", "message/rfc822"},
-    {".mid", "audio/midi"},
-    {".midi", "audio/midi"},
-    {".mif", "application/x-frame"},
-    {".mime", "message/rfc822"},
-    {".mjf", "audio/x-vnd.audioexplosion.mjuicemediafile"},
-    {".mjpg", "video/x-motion-jpeg"},
-    {".mm", "application/base64"},
-    {".mme", "application/base64"},
-    {".mod", "audio/mod"},
-    {".moov", "video/quicktime"},
-    {".mov", "video/quicktime"},
-    {".movie", "video/x-sgi-movie"},
-    {".mp2", "audio/mpeg"},
-    {".mp3", "audio/mpeg3"},
-    {".mpa", "audio/mpeg"},
-    {".mpc", "application/x-project"},
-    {".mpe", "video/mpeg"},
-    {".mpeg", "video/mpeg"},
-    {".mpg", "audio/mpeg"},
-    {".mpga", "audio/mpeg"},
-    {".mpp", "application/vnd.ms-project"},
-    {".mpt", "application/x-project"},
-    {".mpv", "application/x-project"},
-    {".mpx", "application/x-project"},
-    {".mrc", "application/marc"},
-    {".ms", "application/x-troff-ms"},
-    {".mv", "video/x-sgi-movie"},
-    {".my", "audio/make"},
-    {".mzz", "application/x-vnd.audioexplosion.mzz"},
-    {".nap", "image/naplps"},
-    {".naplps", "image/naplps"},
-    {".nc", "application/x-netcdf"},
-    {".ncm", "application/vnd.nokia.configuration-message"},
-    {".nif", "image/x-niff"},
-    {".niff", "image/x-niff"},
-    {".nix", "application/x-mix-transfer"},
-    {".nsc", "application/x-conference"},
-    {".nvd", "application/x-navidoc"},
-    {".o", "application/octet-stream"},
-    {".oda", "application/oda"},
-    {".omc", "application/x-omc"},
-    {".omcd", "application/x-omcdatamaker"},
-    {".omcr", "application/x-omcregerator"},
-    {".p", "text/x-pascal"},
-    {".p10", "application/pkcs10"},
-    {".p12", "application/pkcs-12"},
-    {".p7a", "application/x-pkcs7-signature"},
-    {".p7c", "application/pkcs7-mime"},
-    {".p7c", "application/x-pkcs7-mime"},
-    {".p7m", "application/pkcs7-mime"},
-    {".p7r", "application/x-pkcs7-certreqresp"},
-    {".p7s", "application/pkcs7-signature"},
-    {".part", "application/pro_eng"},
-    {".pas", "text/pascal"},
-    {".pbm", "image/x-portable-bitmap"},
-    {".pcl", "application/vnd.hp-pcl"},
-    {".pct", "image/x-pict"},
-    {".pcx", "image/x-pcx"},
-    {".pdb", "chemical/x-pdb"},
-    {".pdf", "application/pdf"},
-    {".pfunk", "audio/make"},
-    {".pgm", "image/x-portable-graymap"},
-    {".pic", "image/pict"},
-    {".pict", "image/pict"},
-    {".pkg", "application/x-newton-compatible-pkg"},
-    {".pko", "application/vnd.ms-pki.pko"},
-    {".pl", "text/x-script.perl"},
-    {".plx", "application/x-pixclscript"},
-    {".pm", "text/x-script.perl-module"},
-    {".pm4", "application/x-pagemaker"},
-    {".pm5", "application/x-pagemaker"},
-    {".png", "image/png"},
-    {".pnm", "application/x-portable-anymap"},
-    {".pnm", "image/x-portable-anymap"},
-    {".pot", "application/vnd.ms-powerpoint"},
-    {".pot", "application/vnd.ms-powerpoint"},
-    {".pov", "model/x-pov"},
-    {".ppa", "application/vnd.ms-powerpoint"},
-    {".ppm", "image/x-portable-pixmap"},
-    {".pps", "application/vnd.ms-powerpoint"},
-    {".ppt", "application/vnd.ms-powerpoint"},
-    {".ppz", "application/vnd.ms-powerpoint"},
-    {".pre", "application/x-freelance"},
-    {".prt", "application/pro_eng"},
-    {".ps", "application/postscript"},
-    {".psd", "application/octet-stream"},
-    {".pvu", "paleovu/x-pv"},
-    {".pwz", "application/vnd.ms-powerpoint"},
-    {".py", "text/x-script.phyton"},
-    {".pyc", "applicaiton/x-bytecode.python"},
-    {".qcp", "audio/vnd.qcelp"},
-    {".qd3", "x-world/x-3dmf"},
-    {".qd3d", "x-world/x-3dmf"},
-    {".qif", "image/x-quicktime"},
-    {".qt", "video/quicktime"},
-    {".qtc", "video/x-qtc"},
-    {".qti", "image/x-quicktime"},
-    {".qtif", "image/x-quicktime"},
-    {".ra", "audio/x-pn-realaudio"},
-    {".ram", "audio/x-pn-realaudio"},
-    {".ras", "image/cmu-raster"},
-    {".rast", "image/cmu-raster"},
-    {".rexx", "text/x-script.rexx"},
-    {".rf", "image/vnd.rn-realflash"},
-    {".rgb", "image/x-rgb"},
-    {".rm", "audio/x-pn-realaudio"},
-    {".rmi", "audio/mid"},
-    {".rmm", "audio/x-pn-realaudio"},
-    {".rmp", "audio/x-pn-realaudio"},
-    {".rng", "application/ringing-tones"},
-    {".rnx", "application/vnd.rn-realplayer"},
-    {".roff", "application/x-troff"},
-    {".rp", "image/vnd.rn-realpix"},
-    {".rpm", "audio/x-pn-realaudio-plugin"},
-    {".rt", "text/richtext"},
-    {".rtf", "application/rtf"},
-    {".rtx", "application/rtf"},
-    {".rtx", "text/richtext"},
-    {".rv", "video/vnd.rn-realvideo"},
-    {".s", "text/x-asm"},
-    {".s3m", "audio/s3m"},
-    {".saveme", "application/octet-stream"},
-    {".sbk", "application/x-tbook"},
-    {".scm", "application/x-lotusscreencam"},
-    {".scm", "text/x-script.guile"},
-    {".sdml", "text/plain"},
-    {".sdp", "application/sdp"},
-    {".sdr", "application/sounder"},
-    {".sea", "application/sea"},
-    {".set", "application/set"},
-    {".sgm", "text/sgml"},
-    {".sgml", "text/sgml"},
-    {".sh", "application/x-sh"},
-    {".shar", "application/x-shar"},
-    {".shtml", "text/html"},
-    {".sid", "audio/x-psid"},
-    {".sit", "application/x-sit"},
-    {".skd", "application/x-koan"},
-    {".skm", "application/x-koan"},
-    {".skp", "application/x-koan"},
-    {".skt", "application/x-koan"},
-    {".sl", "application/x-seelogo"},
-    {".smi", "application/smil"},
-    {".smil", "application/smil"},
-    {".snd", "audio/basic"},
-    {".snd", "audio/x-adpcm"},
-    {".sol", "application/solids"},
-    {".spc", "text/x-speech"},
-    {".spl", "application/futuresplash"},
-    {".spr", "application/x-sprite"},
-    {".sprite", "application/x-sprite"},
-    {".src", "application/x-wais-source"},
-    {".ssi", "text/x-server-parsed-html"},
-    {".ssm", "application/streamingmedia"},
-    {".sst", "application/vnd.ms-pki.certstore"},
-    {".step", "application/step"},
-    {".stl", "application/sla"},
-    {".stp", "application/step"},
-    {".sv4cpio", "application/x-sv4cpio"},
-    {".sv4crc", "application/x-sv4crc"},
-    {".svf", "image/vnd.dwg"},
-    {".svr", "application/x-world"},
-    {".swf", "application/x-shockwave-flash"},
-    {".t", "application/x-troff"},
-    {".talk", "text/x-speech"},
-    {".tar", "application/x-tar"},
-    {".tbk", "application/toolbook"},
-    {".tcl", "application/x-tcl"},
-    {".tcsh", "text/x-script.tcsh"},
-    {".tex", "application/x-tex"},
-    {".texi", "application/x-texinfo"},
-    {".texinfo", "application/x-texinfo"},
-    {".text", "text/plain"},
-    {".tgz", "application/x-compressed"},
-    {".tif", "image/tiff"},
-    {".tiff", "image/x-tiff"},
-    {".tr", "application/x-troff"},
-    {".tsi", "audio/tsp-audio"},
-    {".tsp", "audio/tsplayer"},
-    {".tsv", "text/tab-separated-values"},
-    {".turbot", "image/florian"},
-    {".txt", "text/plain"},
-    {".uil", "text/x-uil"},
-    {".uni", "text/uri-list"},
-    {".unis", "text/uri-list"},
-    {".unv", "application/i-deas"},
-    {".uri", "text/uri-list"},
-    {".uris", "text/uri-list"},
-    {".ustar", "application/x-ustar"},
-    {".uu", "text/x-uuencode"},
-    {".uue", "text/x-uuencode"},
-    {".vcd", "application/x-cdlink"},
-    {".vcs", "text/x-vcalendar"},
-    {".vda", "application/vda"},
-    {".vdo", "video/vdo"},
-    {".vew", "application/groupwise"},
-    {".viv", "video/vivo"},
-    {".viv", "video/vnd.vivo"},
-    {".vivo", "video/vivo"},
-    {".vmd", "application/vocaltec-media-desc"},
-    {".vmf", "application/vocaltec-media-file"},
-    {".voc", "audio/voc"},
-    {".vos", "video/vosaic"},
-    {".vox", "audio/voxware"},
-    {".vqe", "audio/x-twinvq-plugin"},
-    {".vqf", "audio/x-twinvq"},
-    {".vql", "audio/x-twinvq-plugin"},
-    {".vrml", "model/vrml"},
-    {".vrt", "x-world/x-vrt"},
-    {".vsd", "application/x-visio"},
-    {".vst", "application/x-visio"},
-    {".vsw", "application/x-visio"},
-    {".w60", "application/wordperfect6.0"},
-    {".w61", "application/wordperfect6.1"},
-    {".w6w", "application/msword"},
-    {".wav", "audio/wav"},
-    {".wb1", "application/x-qpro"},
-    {".wbmp", "image/vnd.wap.wbmp"},
-    {".web", "application/vnd.xara"},
-    {".wiz", "application/msword"},
-    {".wk1", "application/x-123"},
-    {".wmf", "windows/metafile"},
-    {".wml", "text/vnd.wap.wml"},
-    {".wmlc", "application/vnd.wap.wmlc"},
-    {".wmls", "text/vnd.wap.wmlscript"},
-    {".wmlsc", "application/vnd.wap.wmlscriptc"},
-    {".word", "application/msword"},
-    {".wp", "application/wordperfect"},
-    {".wp5", "application/wordperfect"},
-    {".wp5", "application/wordperfect6.0"},
-    {".wp6", "application/wordperfect"},
-    {".wpd", "application/wordperfect"},
-    {".wpd", "application/x-wpwin"},
-    {".wq1", "application/x-lotus"},
-    {".wri", "application/mswrite"},
-    {".wrl", "model/vrml"},
-    {".wrz", "model/vrml"},
-    {".wsc", "text/scriplet"},
-    {".wsrc", "application/x-wais-source"},
-    {".wtk", "application/x-wintalk"},
-    {".xbm", "image/x-xbitmap"},
-    {".xdr", "video/x-amt-demorun"},
-    {".xgz", "xgl/drawing"},
-    {".xif", "image/vnd.xiff"},
-    {".xl", "application/vnd.ms-excel"},
-    {".xla", "application/vnd.ms-excel"},
-    {".xlb", "application/vnd.ms-excel"},
-    {".xlc", "application/vnd.ms-excel"},
-    {".xld", "application/vnd.ms-excel"},
-    {".xlk", "application/vnd.ms-excel"},
-    {".xll", "application/vnd.ms-excel"},
-    {".xlm", "application/vnd.ms-excel"},
-    {".xls", "application/vnd.ms-excel"},
-    {".xlt", "application/vnd.ms-excel"},
-    {".xlv", "application/vnd.ms-excel"},
-    {".xlw", "application/vnd.ms-excel"},
-    {".xm", "audio/xm"},
-    {".xml", "application/xml"},
-    {".xmz", "xgl/movie"},
-    {".xpix", "application/x-vnd.ls-xpix"},
-    {".xpm", "image/xpm"},
-    {".xsr", "video/x-amt-showrun"},
-    {".xwd", "image/x-xwd"},
-    {".xyz", "chemical/x-pdb"},
-    {".z", "application/x-compress"},
-    {".zip", "application/zip"},
-    {".zoo", "application/octet-stream"},
-    {".zsh", "text/x-script.zsh"},
-};
+// Built when the program starts, from the error table defined above
+const std::unordered_map<int, HttpResponse::PreparedError>
+   HttpResponse::_preparedErrTbl = []
+{
+   std::unordered_map<int, PreparedError> preparedErrTbl;
+
+   for (const auto &[code, msg] : _errTbl)
+   {
+      std::string body = "<html><head><title>";
+      appendNumber(body, code);
+      body.append(" ").append(msg);
+      body.append("</title></head><body>").append(msg).append("</body></html>\r\n");
+
+      PreparedError &error = preparedErrTbl[code];
+      std::string &data = error.data;
+
+      data.assign(HTTPSRV_VER " ");
+      appendNumber(data, code);
+      data.append(" ").append(msg).append(dateField);
+
+      // The date is filled in when the response is sent
+      error.dateOffset = data.size();
+      data.append(SysUtils::httpDateLength, ' ');
+
+      data.append(serverField);
+      appendNumber(data, body.size());
+      data.append("\r\nContent-Type: text/html\r\n");
+
+      // The client is told when an overloaded server can be retried
+      if (code == 429 || code == 503)
+      {
+         data.append("Retry-After: ");
+         appendNumber(data, HTTPSRV_RETRY_AFTER_SEC);
+         data.append("\r\n");
+      }
+
+      // The connection is closed after an error, as the peer could be
+      // out of sync (e.g. a body has been partially received)
+      data.append("Connection: close\r\n\r\n").append(body);
+   }
+
+   return preparedErrTbl;
+}();
 
 /* -------------------------------------------------------------------------- */
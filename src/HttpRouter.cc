@@ -0,0 +1,277 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "HttpRouter.h"
+#include "PerfectHash.h"
+#include "config.h"
+
+#include <array>
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+using Endpoint = HttpRouter::Endpoint;
+
+//! Entry of the route table
+struct RouteDef
+{
+   std::string_view method;
+   std::string_view path;
+   Endpoint endpoint;
+};
+
+// Route table: a path is a sequence of "/" separated segments, each one
+// either a literal or the capture "{id}", which matches any not empty
+// segment not matched by a literal
+constexpr RouteDef routes[] = {
+   {"GET", HTTPSRV_GET_FILES, Endpoint::files},
+   {"GET", HTTPSRV_GET_FILE, Endpoint::file},
+   {"GET", HTTPSRV_GET_FILE_ZIP, Endpoint::fileZip},
+   {"GET", HTTPSRV_GET_MRUFILES, Endpoint::mruFiles},
+   {"GET", HTTPSRV_GET_MRUFILES_ZIP, Endpoint::mruFilesZip},
+   {"POST", HTTPSRV_POST_STORE, Endpoint::store},
+   {"GET", HTTPSRV_GET_STATS, Endpoint::stats},
+};
+
+constexpr size_t routeCount = sizeof(routes) / sizeof(routes[0]);
+constexpr std::string_view capture = HTTP_URIARG_ID;
+
+/* -------------------------------------------------------------------------- */
+
+//! Returns the number of segments of a path ("/files/{id}" has 2)
+constexpr size_t countSegments(std::string_view path) noexcept
+{
+   size_t count = 0;
+
+   for (char c : path)
+      count += c == '/';
+
+   return count;
+}
+
+/* -------------------------------------------------------------------------- */
+
+//! Returns the i-th segment of a path
+constexpr std::string_view getSegment(std::string_view path, size_t i) noexcept
+{
+   size_t begin = 0;
+
+   for (size_t n = 0; n <= i; ++n)
+      begin = path.find('/', begin) + 1;
+
+   const size_t end = path.find('/', begin);
+
+   return path.substr(begin, end == std::string_view::npos ? end : end - begin);
+}
+
+/* -------------------------------------------------------------------------- */
+
+//! Returns true if every path is well formed and routed once
+constexpr bool isValidRouteTable() noexcept
+{
+   for (size_t i = 0; i < routeCount; ++i)
+   {
+      const auto path = routes[i].path;
+
+      if (path.empty() || path[0] != '/' || routes[i].endpoint == Endpoint::count)
+         return false;
+
+      size_t captures = 0;
+
+      for (size_t s = 0; s < countSegments(path); ++s)
+      {
+         const auto segment = getSegment(path, s);
+
+         if (segment.empty() || (segment[0] == '{' && segment != capture))
+            return false;
+
+         captures += segment == capture;
+      }
+
+      if (captures > 1)
+         return false;
+
+      for (size_t j = 0; j < i; ++j)
+      {
+         if (routes[j].path == path)
+            return false;
+      }
+   }
+
+   return true;
+}
+
+static_assert(isValidRouteTable(), "Malformed route table");
+
+/* -------------------------------------------------------------------------- */
+
+constexpr size_t countAllSegments() noexcept
+{
+   size_t count = 0;
+
+   for (const auto &route : routes)
+      count += countSegments(route.path);
+
+   return count;
+}
+
+constexpr size_t segmentCount = countAllSegments();
+
+/* -------------------------------------------------------------------------- */
+
+//! Distinct literal segments of the route table
+struct Literals
+{
+   std::array<std::string_view, segmentCount> names{};
+   size_t count = 0;
+};
+
+constexpr Literals collectLiterals() noexcept
+{
+   Literals literals;
+
+   for (const auto &route : routes)
+   {
+      for (size_t s = 0; s < countSegments(route.path); ++s)
+      {
+         const auto segment = getSegment(route.path, s);
+         bool found = segment == capture;
+
+         for (size_t i = 0; i < literals.count && !found; ++i)
+            found = literals.names[i] == segment;
+
+         if (!found)
+            literals.names[literals.count++] = segment;
+      }
+   }
+
+   return literals;
+}
+
+constexpr Literals literals = collectLiterals();
+
+// Tokens identify the literal segments, followed by the capture
+constexpr size_t captureToken = literals.count;
+constexpr size_t tokenCount = literals.count + 1;
+
+/* -------------------------------------------------------------------------- */
+
+// Literal segments are found by a perfect hash
+constexpr PerfectHash<segmentCount> literalHash(literals.names, literals.count);
+
+static_assert(literalHash.isPerfect(), "No perfect hash found for the route table");
+
+/* -------------------------------------------------------------------------- */
+
+constexpr int noNode = -1;
+
+//! Trie of the route table, node 0 being the root
+struct Trie
+{
+   std::array<std::array<int, tokenCount>, segmentCount + 1> next{};
+   std::array<int, segmentCount + 1> route{};
+   size_t nodes = 1;
+};
+
+constexpr size_t findToken(std::string_view segment) noexcept
+{
+   for (size_t token = 0; token < literals.count; ++token)
+   {
+      if (literals.names[token] == segment)
+         return token;
+   }
+
+   return captureToken;
+}
+
+constexpr Trie buildTrie() noexcept
+{
+   Trie trie;
+
+   for (auto &node : trie.next)
+   {
+      for (auto &next : node)
+         next = noNode;
+   }
+
+   for (auto &route : trie.route)
+      route = -1;
+
+   for (size_t i = 0; i < routeCount; ++i)
+   {
+      size_t node = 0;
+
+      for (size_t s = 0; s < countSegments(routes[i].path); ++s)
+      {
+         const size_t token = findToken(getSegment(routes[i].path, s));
+
+         if (trie.next[node][token] == noNode)
+            trie.next[node][token] = int(trie.nodes++);
+
+         node = size_t(trie.next[node][token]);
+      }
+
+      trie.route[node] = int(i);
+   }
+
+   return trie;
+}
+
+constexpr Trie trie = buildTrie();
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+HttpRouter::Route HttpRouter::resolve(
+   std::string_view method,
+   std::string_view uri) noexcept
+{
+   Route route;
+
+   if (uri.empty() || uri[0] != '/')
+      return route;
+
+   int node = 0;
+
+   while (!uri.empty())
+   {
+      uri.remove_prefix(1); // '/'
+
+      const auto segment = uri.substr(0, uri.find('/'));
+      const int token = literalHash.find(segment);
+
+      int next = token >= 0 ? trie.next[node][token] : noNode;
+
+      // A literal segment takes precedence over the capture
+      if (next == noNode && !segment.empty())
+      {
+         next = trie.next[node][captureToken];
+         route.id = segment;
+      }
+
+      if (next == noNode)
+         return Route();
+
+      node = next;
+      uri.remove_prefix(segment.size());
+   }
+
+   const int index = trie.route[node];
+
+   if (index < 0 || routes[index].method != method)
+      return Route();
+
+   route.endpoint = routes[index].endpoint;
+
+   return route;
+}
@@ -13,8 +13,13 @@
 
 #include "HttpServer.h"
 #include "HttpSession.h"
+#include "EventLoop.h"
+#include "UringEventLoop.h"
 
+#include <algorithm>
 #include <thread>
+#include <type_traits>
+#include <vector>
 
 /* -------------------------------------------------------------------------- */
 // HttpServer
@@ -40,34 +45,238 @@ auto HttpServer::getInstance() -> HttpServer &
 
 bool HttpServer::bind(TranspPort port)
 {
-   _tcpServer = TcpListener::create();
-   assert(_tcpServer);
+   _listeners.clear();
 
-   if (!_tcpServer)
-      return false;
+   const int acceptors = std::max(1, _acceptors);
+
+   for (int i = 0; i < acceptors; ++i)
+   {
+      TcpListener::Handle listener = TcpListener::create();
+      assert(listener);
+
+      if (!listener)
+         return false;
+
+      // Multiple listeners can be bound to the same port only if
+      // each of them enables the port reusing
+      if (acceptors > 1 && !listener->setReusePort())
+         return false;
+
+      if (!listener->bind(port))
+         return false;
+
+      _listeners.push_back(std::move(listener));
+   }
+
+   _serverPort = port;
 
-   return _tcpServer->bind(port);
+   return true;
 }
 
 /* -------------------------------------------------------------------------- */
 
 bool HttpServer::listen(int maxConnections)
 {
-   if (!_tcpServer)
+   if (_listeners.empty())
       return false;
 
-   return _tcpServer->listen(maxConnections);
+   for (auto &listener : _listeners)
+   {
+      if (!listener->listen(maxConnections))
+         return false;
+   }
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpServer::pinThreadToCpu(size_t index)
+{
+   if (!_cpuAffinity)
+      return;
+
+   const size_t cpus = std::max(1U, std::thread::hardware_concurrency());
+   const int cpu = int(index % cpus);
+
+   if (!SysUtils::setThreadCpuAffinity(cpu) && _verboseModeOn)
+   {
+      *_loggerOStreamPtr 
+         << "HttpServer::run() cannot pin thread to CPU " << cpu << std::endl;
+   }
 }
 
 /* -------------------------------------------------------------------------- */
 
 bool HttpServer::run()
 {
-   // Create a thread for each TCP accepted connection and
-   // delegate it to handle HTTP request / response
+   if (_listeners.empty())
+      return false;
+
+   _sessionConfig.loadShedder = LoadShedder::create(_limits);
+
+   if (!_sessionConfig.loadShedder)
+      return false;
+
+   switch (_ioModel)
+   {
+   case IoModel::ioUring:
+      if (UringEventLoop::isSupported())
+         return runEventLoops<UringEventLoop>();
+
+      if (_verboseModeOn)
+      {
+         *_loggerOStreamPtr 
+            << "HttpServer::run() io_uring is not supported, "
+            << "falling back to epoll" << std::endl;
+      }
+
+      return runEventLoops<EventLoop>();
+
+   case IoModel::eventLoop:
+      return runEventLoops<EventLoop>();
+
+   case IoModel::threadPool:
+      // An idle connection becoming readable while the admission queue
+      // is full is answered at once, like a new one
+      _workerPool = WorkerPool::create(
+         _workerThreads, 
+         _workerQueueSize,
+         [this](const HttpSession::Handle &session) {
+            _sessionConfig.loadShedder->countShedConnection();
+            rejectConnection(session->getTcpSocketHandle());
+         });
+
+      if (!_workerPool)
+         return false;
+
+      return runAcceptors();
+
+   case IoModel::threadPerConnection:
+   default:
+      return runAcceptors();
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+template <typename Loop>
+bool HttpServer::runEventLoops()
+{
+   if (!Loop::isSupported())
+      return false;
+
+   // Readiness-based event loops accept connections without blocking
+   for (auto &listener : _listeners)
+   {
+      if (std::is_same<Loop, EventLoop>::value && !listener->setNonBlocking())
+         return false;
+   }
+
+   int loopsCount = _eventLoops;
+
+   if (loopsCount < 1)
+      loopsCount = std::max(1, int(std::thread::hardware_concurrency()));
+
+   // Each acceptor owns at least an event loop
+   loopsCount = std::max(loopsCount, int(_listeners.size()));
+
+   assert(_loggerOStreamPtr);
+
+   // The blocking business logic (e.g. zip archives, directory walks,
+   // uploads) is run by a worker pool, not to stall the other
+   // connections of a loop
+   _workerPool = WorkerPool::create(_workerThreads, _workerQueueSize, nullptr);
+
+   if (!_workerPool)
+      return false;
+
+   _sessionConfig.workerPool = _workerPool.get();
+
+   std::vector<typename Loop::Handle> loops;
+
+   for (int i = 0; i < loopsCount; ++i)
+   {
+      // Event loops are evenly spread among the listeners
+      auto loop = Loop::create(
+          *_listeners[i % _listeners.size()],
+          _verboseModeOn,
+          *_loggerOStreamPtr,
+          _FileRepository,
+          _sessionConfig);
+
+      if (!loop)
+         return false;
+
+      loops.push_back(std::move(loop));
+   }
+
+   // The first loop runs in the caller context, while each of the
+   // others runs in a dedicated thread
+   for (size_t i = 1; i < loops.size(); ++i)
+   {
+      std::thread loopThread([this, i](Loop *loop) {
+            pinThreadToCpu(i);
+            loop->run();
+         }, 
+         loops[i].get());
+
+      loopThread.detach();
+   }
+
+   pinThreadToCpu(0);
+
+   return loops[0]->run();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpServer::rejectConnection(const TcpSocket::Handle &handle)
+{
+   if (_verboseModeOn)
+   {
+      *_loggerOStreamPtr 
+         << "HttpServer::run() server is overloaded, connection from "
+         << handle->getRemoteIpAddress() << ":" << handle->getRemotePort()
+         << " rejected (" << getShedStats().connections << " so far)" 
+         << std::endl;
+   }
+
+   _sessionConfig.loadShedder->rejectConnection(handle);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpServer::runAcceptors()
+{
+   // The first acceptor runs in the caller context, while each of the
+   // others runs in a dedicated thread
+   for (size_t i = 1; i < _listeners.size(); ++i)
+   {
+      std::thread acceptorThread([this, i](TcpListener *listener) {
+            pinThreadToCpu(i);
+            runAcceptLoop(*listener);
+         }, 
+         _listeners[i].get());
+
+      acceptorThread.detach();
+   }
+
+   pinThreadToCpu(0);
+
+   return runAcceptLoop(*_listeners[0]);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpServer::runAcceptLoop(TcpListener &listener)
+{
+   // For each TCP accepted connection create an HTTP session and
+   // delegate it to handle HTTP request / response either to a new
+   // thread or to the worker pool
    while (true)
    {
-      const TcpSocket::Handle handle = accept();
+      const TcpSocket::Handle handle = listener.accept();
 
       assert(_loggerOStreamPtr);
 
@@ -83,19 +292,55 @@ bool HttpServer::run()
          continue;
       }
 
+      // Too many connections: answer at once and close
+      LoadShedder::Ticket ticket = _sessionConfig.loadShedder->admitConnection();
+
+      if (!ticket)
+      {
+         rejectConnection(handle);
+         continue;
+      }
+
       // Create a new http session context
       HttpSession::Handle sessionHandle = HttpSession::create(
           _verboseModeOn,
           *_loggerOStreamPtr,
           handle,
-          _FileRepository);
-
-      // the function operator() will because of *sessionHandle
-      // reference, while the sessionHandle itself will be
-      // copied to the thread stack as parameter, this will force
-      // to increment the handle reference count until the worker thread
-      // is running preserving the context integrity
-      std::thread workerThread(*sessionHandle, sessionHandle);
+          _FileRepository,
+          _sessionConfig,
+          std::move(ticket));
+
+      // Out of memory: answer at once, as when overloaded (the
+      // connection ticket has been released along with the arguments)
+      if (!sessionHandle)
+      {
+         _sessionConfig.loadShedder->countShedConnection();
+         rejectConnection(handle);
+         continue;
+      }
+
+      if (_workerPool)
+      {
+         // The admission queue is full: answer at once without
+         // taking on more work
+         if (!_workerPool->submit(sessionHandle))
+         {
+            // The connection ticket is released along with the session
+            sessionHandle.reset();
+
+            _sessionConfig.loadShedder->countShedConnection();
+            rejectConnection(handle);
+         }
+
+         continue;
+      }
+
+      // the sessionHandle is copied to the thread context, this will
+      // force to increment the handle reference count until the worker
+      // thread is running preserving the context integrity
+      std::thread workerThread(
+         [](HttpSession::Handle session) { (*session)(session); }, 
+         sessionHandle);
 
       workerThread.detach();
    }
@@ -12,16 +12,16 @@
 /* -------------------------------------------------------------------------- */
 
 #include "HttpSession.h"
-#include "HttpSocket.h"
+#include "HeapStats.h"
+#include "JsonWriter.h"
+#include "WorkerPool.h"
 
+#include <algorithm>
 #include <cassert>
 
 /* -------------------------------------------------------------------------- */
 // HttpSession
 
-/* -------------------------------------------------------------------------- */
-
-
 /* -------------------------------------------------------------------------- */
 
 void HttpSession::logSessionBegin()
@@ -43,7 +43,12 @@ void HttpSession::logEnd()
    if (!_verboseModeOn)
       return;
 
-   log() << _sessionId << "---- HTTP SERVER SESSION ENDS" << std::endl
+   const auto &stats = _arena.getStats();
+
+   log() << _sessionId << "---- HTTP SERVER SESSION ENDS ("
+      << _requestsServed << " requests, "
+      << stats.allocations << " arena allocations, "
+      << stats.heapAllocations << " heap allocations)" << std::endl
       << std::endl;
    log().flush();
 }
@@ -51,57 +56,69 @@ void HttpSession::logEnd()
 //! Process HTTP GET Method
 HttpSession::processAction HttpSession::processGetRequest(
    HttpRequest& incomingRequest,
-   std::string& json,
-   std::string& nameOfFileToSend,
-   FileUtils::DirectoryRipper::Handle& zipCleaner)
+   std::pmr::string& json,
+   Reply& reply)
 {
-   const auto& uri = incomingRequest.getUri();
+   const auto& route = incomingRequest.getRoute();
+   auto& nameOfFileToSend = reply.nameOfFileToSend;
+   auto& zipCleaner = reply.zipCleaner;
 
-   // command /files
-   if (uri == HTTPSRV_GET_FILES &&
-      _FileRepository->getFilenameMap().
-      locked_updateMakeJson(getLocalStorePath(), json))
+   switch (route.endpoint)
    {
-      return processAction::sendJsonFileList;
-   }
+   // command /files
+   case HttpRouter::Endpoint::files:
+      // An HTTP/1.1 client is sent the listing in chunks, written
+      // while the repository is scanned
+      if (incomingRequest.getVersion() == HttpRequest::Version::HTTP_1_1)
+      {
+         reply.listing.emplace(
+            _FileRepository->getFilenameMap(), getLocalStorePath(), &_arena);
+
+         if (reply.listing->isValid())
+            return processAction::sendJsonFileList;
+
+         reply.listing.reset();
+      }
+      else if (_FileRepository->getFilenameMap().
+         locked_updateMakeJson(getLocalStorePath(), json))
+      {
+         return processAction::sendJsonFileList;
+      }
+      break;
 
    // command /mrufiles
-   if (uri == HTTPSRV_GET_MRUFILES)
-   {
+   case HttpRouter::Endpoint::mruFiles:
       return !_FileRepository->createJsonMruFilesList(json) ?
          processAction::sendInternalError :
          processAction::sendMruFiles;
-   }
 
    // command /mrufiles/zip
-   if (uri == HTTPSRV_GET_MRUFILES_ZIP)
-   {
+   case HttpRouter::Endpoint::mruFilesZip:
       return _FileRepository->createMruFilesZip(nameOfFileToSend, zipCleaner) ?
          processAction::sendZipFile :
          processAction::sendInternalError;
-   }
-
-   const auto& uriArgs = incomingRequest.getUriArgs();
 
-   // command /files/<id> is split in 3 args (first one, arg[0] is dummy)
-   if (uriArgs.size() == 3 && uriArgs[1] == HTTP_URIPFX_FILES)
-   {
-      const auto& id = incomingRequest.getUriArgs()[2];
+   // command /files/<id>
+   case HttpRouter::Endpoint::file:
       if (!_FileRepository->getFilenameMap().
-         jsonStatFileUpdateTS(getLocalStorePath(), id, json, true))
+         jsonStatFileUpdateTS(getLocalStorePath(), route.id, json, true))
       {
          return processAction::sendInternalError;
       }
-   }
+      break;
 
-   // command /files/<id>/zip is split in 4 args (first one, arg[0] is dummy)
-   if (uriArgs.size() == 4 &&
-      uriArgs[1] == HTTP_URIPFX_FILES &&
-      uriArgs[3] == HTTP_URISFX_ZIP)
-   {
-      const auto& id = uriArgs[2];
-      const auto res = _FileRepository->createFileZip(id, nameOfFileToSend, zipCleaner);
-      switch (res)
+   // command /stats
+   case HttpRouter::Endpoint::stats:
+      if (!_config.loadShedder)
+         return processAction::sendInternalError;
+
+      jsonStats(json);
+      return processAction::sendStats;
+
+   // command /files/<id>/zip
+   case HttpRouter::Endpoint::fileZip:
+      switch (_FileRepository->createFileZip(
+         route.id, nameOfFileToSend, zipCleaner))
       {
       case FileRepository::createFileZipRes::idNotFound:
          return processAction::sendNotFound;
@@ -113,6 +130,10 @@ HttpSession::processAction HttpSession::processGetRequest(
       case FileRepository::createFileZipRes::success:
          return processAction::sendZipFile;
       }
+      break;
+
+   default:
+      break;
    }
 
    return processAction::sendErrorInvalidRequest;
@@ -123,7 +144,7 @@ HttpSession::processAction HttpSession::processGetRequest(
 //! Process HTTP POST method
 void HttpSession::processPostRequest(
    HttpRequest& incomingRequest, 
-   std::string& jsonResponse)
+   std::pmr::string& jsonResponse)
 {
    const auto& fileName = incomingRequest.getFileName();
 
@@ -133,7 +154,15 @@ void HttpSession::processPostRequest(
       log().flush();
    }
 
-   if (!_FileRepository->store(fileName, incomingRequest.getBody(), jsonResponse))
+   // The content has been either written to the repository while
+   // it was received or received in memory
+   auto *upload = incomingRequest.getUpload();
+
+   const bool stored = upload ?
+      _FileRepository->store(*upload, jsonResponse) :
+      _FileRepository->store(fileName, incomingRequest.getBody(), jsonResponse);
+
+   if (!stored)
    {
       if (_verboseModeOn)
       {
@@ -145,6 +174,143 @@ void HttpSession::processPostRequest(
 
 /* -------------------------------------------------------------------------- */
 
+void HttpSession::processRequest(HttpRequest &incomingRequest, Reply &reply)
+{
+   std::pmr::string jsonResponse(&_arena);
+
+   // The request exceeds a limit enforced by the parser
+   if (incomingRequest.getErrorStatus() != 0)
+   {
+      reply.response.emplace(incomingRequest.getErrorStatus(), &_arena);
+
+      if (_verboseModeOn)
+      {
+         log() << _sessionId << "Request rejected, exceeding a limit" << std::endl;
+         log().flush();
+      }
+   }
+
+   // Shed the request if its endpoint is overloaded
+   else if (!admitRequest(incomingRequest, reply))
+   {
+      // Service Unavailable, with a Retry-After header
+      reply.response.emplace(503, &_arena);
+
+      if (_verboseModeOn)
+      {
+         log() << _sessionId << "Server is overloaded, request shed" << std::endl;
+         log().flush();
+      }
+   }
+
+   // if this is a pending POST-request containing 'Expected: 100-Continue'
+   else if (incomingRequest.isExpected_100_Continue_Response() ||
+      // or it is not, then checks if incoming request is
+      // a valid POST request 
+      incomingRequest.isValidPostRequest())
+   {
+      processPostRequest(incomingRequest, jsonResponse);
+   }
+
+   // else checks if incomingRequest is valid GET request
+   else if (incomingRequest.isValidGetRequest())
+   {
+      reply.action = processGetRequest(incomingRequest, jsonResponse, reply);
+   }
+
+   // None of above -> respond 400 - Bad Request to the client
+   else
+   {
+      reply.response.emplace(400, &_arena); // Bad Request
+   }
+
+   // The header of a listing sent in chunks
+   if (!reply.response && reply.listing)
+   {
+      reply.response.emplace(std::string_view(".json"), &_arena);
+   }
+
+   if (!reply.response)
+   {
+      const char *bodyFormat = jsonResponse.empty() ? "" : ".json";
+
+      // Format a response to previous HTTP client request
+      reply.response.emplace(
+         incomingRequest,
+         std::move(jsonResponse),
+         bodyFormat,
+         reply.nameOfFileToSend.c_str());
+   }
+
+   reply.keepAlive = applyKeepAlivePolicy(incomingRequest, *reply.response);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpSession::admitRequest(const HttpRequest &request, Reply &reply)
+{
+   const auto &loadShedder = _config.loadShedder;
+
+   if (!loadShedder)
+      return true;
+
+   using Endpoint = LoadShedder::Endpoint;
+
+   const Endpoint endpoint = request.getRoute().endpoint;
+
+   // Invalid requests are not accounted
+   if (endpoint == Endpoint::count)
+      return true;
+
+   reply.requestTicket = loadShedder->admitRequest(endpoint);
+
+   if (!reply.requestTicket)
+      return false;
+
+   if (endpoint == Endpoint::fileZip || endpoint == Endpoint::mruFilesZip)
+   {
+      reply.zipJobTicket = loadShedder->admitZipJob();
+
+      if (!reply.zipJobTicket)
+         return false;
+   }
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpSession::applyKeepAlivePolicy(
+   const HttpRequest &request, 
+   HttpResponse &response)
+{
+   // The final response to the same request is still to come
+   if (response.isContinueResponse())
+      return true;
+
+   ++_requestsServed;
+
+   // The client can ask for a shorter idle timeout
+   if (request.getKeepAliveTimeout() >= 0)
+      _idleTimeout = std::min(_config.keepAliveTimeout, request.getKeepAliveTimeout());
+
+   const int requestsLeft = _config.keepAliveMaxRequests - _requestsServed;
+
+   // After an error the connection is closed, as the peer could be 
+   // out of sync (e.g. a body has been partially received)
+   const bool keepAlive = 
+      request.isKeepAliveRequested() &&
+      !response.isErrorResponse() &&
+      requestsLeft > 0 &&
+      _idleTimeout > 0;
+
+   response.setConnectionHeaders(keepAlive, _idleTimeout, requestsLeft);
+
+   return keepAlive;
+}
+
+/* -------------------------------------------------------------------------- */
+
 // Handles the HTTP server request
 // This method executes in a specific thread context for
 // each accepted HTTP request
@@ -152,18 +318,38 @@ void HttpSession::operator()(Handle taskHandle)
 {
    (void)taskHandle;
 
-   logSessionBegin();
+   serve(false);
+}
 
-   HttpRequest::Handle incomingRequest(new (std::nothrow) HttpRequest);
+/* -------------------------------------------------------------------------- */
+
+bool HttpSession::serve(bool returnWhenIdle)
+{
+   if (!_started)
+   {
+      _started = true;
+      logSessionBegin();
+
+      // The request and the http socket around the connected tcp socket
+      // last as long as the session, so that their memory (e.g. the
+      // receive buffer) is reused by all the requests
+      _incomingRequest.reset(new (std::nothrow) HttpRequest);
+      _httpSocket.setUploadRepository(_FileRepository);
+      _httpSocket.setParserLimits(_config.requestLimits);
+   }
+
+   HttpRequest::Handle &incomingRequest = _incomingRequest;
 
    assert(incomingRequest);
    if (!incomingRequest) // out-of-memory?
-      return;
+      return false;
+
+   HttpSocket &httpSocket = _httpSocket;
 
    while (getTcpSocketHandle())
    {
-      // Create an http socket around a connected tcp socket
-      HttpSocket httpSocket(getTcpSocketHandle());
+      // An idle connection is closed once the timeout expires
+      httpSocket.setConnectionTimeout(_idleTimeout * 1000);
 
       httpSocket >> incomingRequest;
 
@@ -171,107 +357,569 @@ void HttpSession::operator()(Handle taskHandle)
       if (!httpSocket)
          break;
 
+      // The client stopped sending in the middle of a request
+      if (httpSocket.hasTimedOut())
+      {
+         HttpResponse response(408); // Request Timeout
+         response.setConnectionHeaders(false, 0, 0);
+
+         httpSocket << response;
+
+         if (_verboseModeOn)
+            response.dump(log(), _sessionId);
+
+         break;
+      }
+
       // Log the request
       if (_verboseModeOn)
          incomingRequest->dump(log(), _sessionId);
 
-      std::string jsonResponse;
-      std::string nameOfFileToSend;
-      processAction action = processAction::none;
+      Reply &reply = newReply();
+
+      processRequest(*incomingRequest, reply);
 
-      HttpResponse::Handle outgoingResponse;
+      assert(reply.response);
+      if (!reply.response)
+         break;
 
-      // if assigned with non-null DirectoryRipper Handle (a shared pointer)
-      // on session termination the DirectoryRipper will eventually clean up the
-      // temporary directory and its content created for the zip archive
-      // required by GET files/<id>/zip or GET mrufiles/zip operations
-      FileUtils::DirectoryRipper::Handle zipCleaner;
+      // Queue the response header and any not empty json content, any
+      // binary content is sent following the HTTP response header
+      const char *nameOfFileToSend =
+         reply.action == processAction::sendZipFile ? 
+         reply.nameOfFileToSend.c_str() : "";
 
-      // if this is a pending POST-request containing 'Expected: 100-Continue'
-      if (incomingRequest->isExpected_100_Continue_Response() ||
-         // or it is not, then checks if incoming request is
-         // a valid POST request 
-         incomingRequest->isValidPostRequest())
+      if (!httpSocket.queue(*reply.response, nameOfFileToSend))
       {
-         processPostRequest(*incomingRequest, jsonResponse);
+         // The content announced by the header cannot be sent
+         reply.keepAlive = false;
+
+         if (_verboseModeOn)
+         {
+            log() << _sessionId << "Error sending '" << nameOfFileToSend
+               << "'" << std::endl
+               << std::endl;
+
+            log().flush();
+         }
       }
 
-      // else checks if incomingRequest is valid GET request
-      else if (incomingRequest->isValidGetRequest())
+      // The first chunk of a listing is sent along with the header
+      if (reply.listing)
+         httpSocket.queue(nextListingChunk(*reply.listing));
+
+      const bool keepAlive = reply.keepAlive;
+
+      if (keepAlive)
+         renewRequest(*incomingRequest);
+
+      // Any further request already received is processed before
+      // sending, so that the responses are coalesced in a single write
+      // (unless a listing is still to be sent)
+      if (keepAlive && 
+          !reply.listing &&
+          _pipeline->size() < size_t(_config.pipelineDepth) &&
+          httpSocket.parseBuffered(incomingRequest))
       {
-         action = processGetRequest(
-            *incomingRequest,
-            jsonResponse,
-            nameOfFileToSend,
-            zipCleaner);
+         continue;
       }
 
-      // None of above -> respond 400 - Bad Request to the client
-      else
+      if (!httpSocket.flush())
+         break;
+
+      // The rest of a listing is written a chunk at a time, once the
+      // previous one has been sent, so that its buffer is reused
+      auto &listing = _pipeline->back().listing;
+      bool sent = true;
+
+      while (listing && !listing->isOver() && sent)
       {
-         outgoingResponse = std::make_unique<HttpResponse>(400); // Bad Request
+         httpSocket.queue(nextListingChunk(*listing));
+         sent = httpSocket.flush();
       }
 
-      if (!outgoingResponse)
+      if (!sent)
+         break;
+
+      if (_verboseModeOn)
       {
-         // Format a response to previous HTTP client request
-         outgoingResponse = std::make_unique<HttpResponse>(
-            *incomingRequest,
-            jsonResponse,
-            jsonResponse.empty() ? "" : ".json",
-            nameOfFileToSend);
+         for (const auto &sentReply : *_pipeline)
+            sentReply.response->dump(log(), _sessionId);
       }
 
-      assert(outgoingResponse);
-      if (!outgoingResponse)
+      // The rest of a request answered by 100-Continue is pending
+      const bool continued = _pipeline->back().response->isContinueResponse();
+
+      releaseReplies();
+
+      // Close the session if the connection is not persistent
+      if (!keepAlive)
          break;
 
-      // Send the response header and any not empty json content to remote peer
-      httpSocket << *outgoingResponse;
+      // An idle connection is given back to the caller, rather than
+      // holding this thread until next request is received
+      if (returnWhenIdle && !continued && !httpSocket.hasPendingData())
+         return true;
+   }
+
+   terminate();
+   return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpSession::terminate()
+{
+   getTcpSocketHandle()->shutdown();
+
+   logEnd();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpSession::start(IoChannel &channel, Resumer resumer)
+{
+   logSessionBegin();
+
+   _ioChannel = &channel;
+   _resumer = std::move(resumer);
+   _state = State::receivingRequest;
+   _parser.setUploadRepository(_FileRepository);
+   _parser.setLimits(_config.requestLimits);
+   _parser.reset(std::make_shared<HttpRequest>());
+}
+
+/* -------------------------------------------------------------------------- */
+
+HttpSession::IoResult HttpSession::receiveRequest()
+{
+   assert(_ioChannel);
+
+   while (!parseBufferedRequest())
+   {
+      const char *data = nullptr;
+      size_t size = 0;
+
+      switch (_ioChannel->recv(data, size))
+      {
+      case IoChannel::Status::done:
+         break;
+      case IoChannel::Status::wouldBlock:
+         return IoResult::wouldBlock;
+      case IoChannel::Status::closed: // Connection closed by remote peer
+      case IoChannel::Status::failed:
+      default:
+         return IoResult::failed;
+      }
+
+      const size_t consumed = _parser.feed(data, size);
+
+      // Keep any byte beyond the end of current request
+      if (consumed < size)
+      {
+         _rxPending.assign(data + consumed, size - consumed);
+         _rxPendingBegin = 0;
+      }
+   }
+
+   return IoResult::done;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpSession::parseBufferedRequest()
+{
+   if (_rxPendingBegin < _rxPending.size() && !_parser.isComplete())
+   {
+      // A complete request refers to the buffered data, which are
+      // kept until the request has been processed
+      _rxPendingBegin += _parser.feed(
+         _rxPending.data() + _rxPendingBegin,
+         _rxPending.size() - _rxPendingBegin);
+   }
+
+   return _parser.isComplete();
+}
+
+/* -------------------------------------------------------------------------- */
 
-      // Any binary content is sent following the HTTP response header
-      // already sent to the client
-      if (action == processAction::sendZipFile)
+bool HttpSession::queueReply(Reply &reply)
+{
+   // The response is referred by the queue, it is kept
+   // unchanged (and not moved) until the reply is over
+   for (const auto slice : reply.response->getSlices())
+      _txQueue.append(slice.data(), slice.size());
+
+   // The first chunk of a listing is sent along with the header
+   if (reply.listing)
+      queueListingChunk();
+
+   // Any binary content is sent following the HTTP response header
+   if (reply.action == processAction::sendZipFile)
+   {
+      uint64_t fileSize = 0;
+      const int fd = SysUtils::openFileForReading(
+         reply.nameOfFileToSend.c_str(), fileSize);
+
+      if (fd >= 0)
       {
-         if (0 > httpSocket.sendFile(nameOfFileToSend))
+         _txQueue.appendFile(fd, 0, fileSize);
+      }
+      else
+      {
+         // The content announced by the header cannot be sent
+         reply.keepAlive = false;
+
+         if (_verboseModeOn)
          {
-            if (_verboseModeOn)
-            {
-               log() << _sessionId << "Error sending '" << nameOfFileToSend
-                  << "'" << std::endl
-                  << std::endl;
+            log() << _sessionId << "Error sending '" << reply.nameOfFileToSend
+               << "'" << std::endl
+               << std::endl;
 
-               log().flush();
-            }
-            break;
+            log().flush();
          }
       }
+   }
 
-      if (_verboseModeOn)
-         outgoingResponse->dump(log(), _sessionId);
+   return reply.keepAlive;
+}
+
+/* -------------------------------------------------------------------------- */
+
+HttpSession::IoResult HttpSession::sendReplies()
+{
+   assert(_ioChannel);
+
+   switch (_txQueue.flush(*_ioChannel))
+   {
+   case IoChannel::Status::done:
+      return IoResult::done;
+   case IoChannel::Status::wouldBlock:
+      return IoResult::wouldBlock;
+   case IoChannel::Status::closed:
+   case IoChannel::Status::failed:
+   default:
+      return IoResult::failed;
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpSession::renewRequest(HttpRequest &request)
+{
+   // The request object (and any memory it holds) is reused
+   if (!request.isExpected_100_Continue_Response())
+      request.clear();
+   else
+      request.clearExpectedContinueFlag();
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::string_view HttpSession::nextListingChunk(FilenameMap::Listing &listing)
+{
+   // The size of the chunk is written in front of its data once they
+   // are complete, as hex digits padded with zeros
+   constexpr size_t sizeDigits = 8;
+   constexpr size_t sizeLineLength = sizeDigits + 2;
+
+   std::pmr::string &text = listing.getText();
+
+   // A record can exceed the chunk size, room is made once for it
+   text.reserve(2 * HTTPSRV_LISTING_CHUNK_SIZE);
+   text.assign(sizeLineLength, '0');
+
+   listing.write(sizeLineLength + HTTPSRV_LISTING_CHUNK_SIZE);
+
+   size_t size = text.size() - sizeLineLength;
+   assert(size > 0);
+
+   for (size_t i = sizeDigits; i-- > 0; size >>= 4)
+      text[i] = "0123456789abcdef"[size & 0xf];
+
+   text[sizeDigits] = '\r';
+   text[sizeDigits + 1] = '\n';
+   text.append("\r\n");
+
+   // The last chunk (of zero size) ends the content
+   if (listing.isOver())
+      text.append("0\r\n\r\n");
+
+   return text;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpSession::queueListingChunk()
+{
+   const auto chunk = nextListingChunk(*_pipeline->back().listing);
+   _txQueue.append(chunk.data(), chunk.size());
+}
+
+/* -------------------------------------------------------------------------- */
+
+HttpSession::Reply &HttpSession::newReply()
+{
+   if (!_pipeline)
+      _pipeline.emplace(&_arena);
+
+   return _pipeline->emplace_back(&_arena);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpSession::releaseReplies()
+{
+   // The queues are allocated from the arena too: they are
+   // released before it is reset, and rebuilt when needed
+   _pipeline.reset();
+   _txQueue.release();
+   _httpSocket.release();
+
+   _arena.reset();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpSession::jsonStats(std::pmr::string &json) const
+{
+   const auto heapStats = HeapStats::getStats();
+   const auto arenaStats = RequestArena::getTotalStats();
+
+   JsonWriter writer(json);
+   writer.beginObject();
+
+   _config.loadShedder->jsonStats(writer);
+
+   // The requests served in steady state should not increase the
+   // counters of the global allocator, but the arena ones only
+   writer.beginObject("memory");
+   writer.value("heapAllocations", heapStats.allocations);
+   writer.value("heapDeallocations", heapStats.deallocations);
+   writer.value("arenaAllocations", arenaStats.allocations);
+   writer.value("arenaHeapAllocations", arenaStats.heapAllocations);
+   writer.value("arenaResets", arenaStats.resets);
+   writer.endObject();
+
+   writer.endObject();
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpSession::isBlocking(const HttpRequest &request) noexcept
+{
+   const auto endpoint = request.getRoute().endpoint;
+
+   // Errors, unknown URIs and the shed counters are answered from memory
+   return
+      request.getErrorStatus() == 0 &&
+      endpoint != HttpRouter::Endpoint::count &&
+      endpoint != HttpRouter::Endpoint::stats;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpSession::startJob(Job job, State stateAfterJob)
+{
+   _job = job;
+   _stateAfterJob = stateAfterJob;
+   _jobDone.store(false, std::memory_order_relaxed);
+   _state = State::runningJob;
 
-      // If we have generated an error, close the session
-      if (outgoingResponse->isErrorResponse())
+   // The pool holds the session until the job is done
+   if (_config.workerPool->submit(shared_from_this()))
+      return true;
+
+   _job = Job::none;
+   _state = State::processingRequest;
+
+   return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpSession::runJob()
+{
+   switch (_job)
+   {
+   case Job::processRequest:
+      processRequest(*_parser.getRequest(), _pipeline->back());
+      break;
+
+   case Job::writeListingChunk:
+      queueListingChunk();
+      break;
+
+   case Job::none:
+   default:
+      break;
+   }
+
+   _job = Job::none;
+   _jobDone.store(true, std::memory_order_release);
+
+   if (_resumer)
+      _resumer(shared_from_this());
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpSession::shedRequest(HttpRequest &request, Reply &reply)
+{
+   // Service Unavailable, with a Retry-After header
+   reply.response.emplace(503, &_arena);
+   reply.keepAlive = applyKeepAlivePolicy(request, *reply.response);
+
+   if (_config.loadShedder)
+      _config.loadShedder->countShedRequest(request.getRoute().endpoint);
+
+   if (_verboseModeOn)
+   {
+      log() << _sessionId << "Worker pool is overloaded, request shed" << std::endl;
+      log().flush();
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void HttpSession::prepareNextRequest()
+{
+   renewRequest(*_parser.getRequest());
+   _parser.reset(_parser.getRequest());
+
+   // The request processed no longer refers to the data received
+   // in advance, which are dropped once they have all been parsed
+   if (_rxPendingBegin == _rxPending.size())
+   {
+      _rxPending.clear();
+      _rxPendingBegin = 0;
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool HttpSession::onIoEvent()
+{
+   while (true)
+   {
+      IoResult res = IoResult::done;
+
+      switch (_state)
+      {
+      case State::receivingRequest:
+         res = receiveRequest();
+         if (res == IoResult::done)
+            _state = State::processingRequest;
          break;
 
-      if (!incomingRequest->isExpected_100_Continue_Response())
+      case State::processingRequest:
       {
-         incomingRequest.reset(new (std::nothrow) HttpRequest);
-         assert(incomingRequest);
-         if (!incomingRequest)
+         HttpRequest &request = *_parser.getRequest();
+
+         // Log the request
+         if (_verboseModeOn)
+            request.dump(log(), _sessionId);
+
+         Reply &reply = newReply();
+
+         // The business logic accessing the repository is run by the
+         // worker pool, so that the other connections are not stalled
+         if (!_config.workerPool || !isBlocking(request))
+            processRequest(request, reply);
+         else if (startJob(Job::processRequest, State::requestProcessed))
             break;
+         else
+            shedRequest(request, reply);
+
+         _state = State::requestProcessed;
+         break;
       }
-      else
+
+      case State::runningJob:
+         // Any I/O event is ignored until the job is done
+         if (!_jobDone.load(std::memory_order_acquire))
+            return true;
+
+         _state = _stateAfterJob;
+         break;
+
+      case State::requestProcessed:
       {
-         incomingRequest->clearExpectedContinueFlag();
+         Reply &reply = _pipeline->back();
+
+         assert(reply.response);
+         if (!reply.response)
+         {
+            _state = State::closing;
+            break;
+         }
+
+         const bool keepAlive = queueReply(reply);
+
+         if (keepAlive)
+            prepareNextRequest();
+
+         // Any further request already received is processed before
+         // sending, so that the responses are coalesced in a single write
+         // (unless a listing is still to be sent)
+         if (keepAlive && 
+             !_pipeline->back().listing &&
+             _pipeline->size() < size_t(_config.pipelineDepth) &&
+             parseBufferedRequest())
+         {
+            _state = State::processingRequest;
+            break;
+         }
+
+         _state = State::sendingResponse;
+         break;
       }
 
-      // After sent a file we can close the HTTP Session
-      if (action == processAction::sendZipFile)
+      case State::sendingResponse:
+         res = sendReplies();
+
+         // The rest of a listing is written a chunk at a time, once the
+         // previous one has been sent, so that its buffer is reused
+         if (res == IoResult::done &&
+             _pipeline->back().listing &&
+             !_pipeline->back().listing->isOver())
+         {
+            // A response under way cannot be shed: if the pool is
+            // overloaded the chunk is written by the caller
+            if (!_config.workerPool ||
+                !startJob(Job::writeListingChunk, State::sendingResponse))
+            {
+               queueListingChunk();
+               _state = State::sendingResponse;
+            }
+            break;
+         }
+
+         if (res == IoResult::done)
+         {
+            const bool keepAlive = _pipeline->back().keepAlive;
+
+            if (_verboseModeOn)
+            {
+               for (const auto &reply : *_pipeline)
+                  reply.response->dump(log(), _sessionId);
+            }
+
+            releaseReplies();
+
+            // Close the session if the connection is not persistent
+            _state = keepAlive ? State::receivingRequest : State::closing;
+         }
          break;
-   }
 
-   getTcpSocketHandle()->shutdown();
+      case State::closing:
+         return false;
+      }
 
-   logEnd();
+      if (res == IoResult::wouldBlock)
+         return true;
+
+      if (res == IoResult::failed)
+         _state = State::closing;
+   }
 }
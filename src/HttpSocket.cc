@@ -12,206 +12,139 @@
 #include "StrUtils.h"
 #include "SysUtils.h"
 
-#include <vector>
-#include <thread>
+#include <cassert>
 
 /* -------------------------------------------------------------------------- */
 
 HttpSocket &HttpSocket::operator=(TcpSocket::Handle handle)
 {
    _socketHandle = handle;
+   _rxBegin = _rxEnd = 0;
+   _parsing = false;
+   _timedOut = false;
+   _txQueue.clear();
    return *this;
 }
 
 /* -------------------------------------------------------------------------- */
 
-bool HttpSocket::recv(HttpRequest::Handle &handle)
+bool HttpSocket::parseBuffered(HttpRequest::Handle &handle)
 {
-   char c = 0;
-   int ret = 1;
-
-   enum class CrLfSeq
+   if (!_parsing)
    {
-      CR1,
-      LF1,
-      CR2,
-      LF2,
-      IDLE
-   } crlf_st = CrLfSeq::IDLE;
-
-   auto feed_crlf_fsm = [&crlf_st](char c) {
-      switch (crlf_st)
-      {
-      case CrLfSeq::IDLE:
-         crlf_st = (c == '\r') ? CrLfSeq::CR1 : CrLfSeq::IDLE;
-         break;
-      case CrLfSeq::CR1:
-         crlf_st = (c == '\n') ? CrLfSeq::LF1 : CrLfSeq::IDLE;
-         break;
-      case CrLfSeq::LF1:
-         crlf_st = (c == '\r') ? CrLfSeq::CR2 : CrLfSeq::IDLE;
-         break;
-      case CrLfSeq::CR2:
-         crlf_st = (c == '\n') ? CrLfSeq::LF2 : CrLfSeq::IDLE;
-         break;
-      default:
-         crlf_st = CrLfSeq::IDLE;
-         break;
-      }
-   };
+      _parser.reset(handle);
+      _parsing = true;
+   }
 
-   std::string line;
-   std::string body;
+   assert(_parser.getRequest() == handle);
 
-   bool receivingBody = false;
-   bool boundary_maker = false;
-   bool timeout = false;
+   if (_rxBegin < _rxEnd && !_parser.isComplete())
+      _rxBegin += _parser.feed(_rxBuffer.data() + _rxBegin, _rxEnd - _rxBegin);
 
-   while (ret > 0 && _connUp && _socketHandle)
-   {
-      std::chrono::milliseconds msec(getConnectionTimeout());
+   return _parser.isComplete();
+}
 
-      auto recvEv = _socketHandle->waitForRecvEvent(msec);
+/* -------------------------------------------------------------------------- */
 
-      switch (recvEv)
-      {
-      case TransportSocket::RecvEvent::RECV_ERROR:
-         _connUp = false;
-         break;
-      case TransportSocket::RecvEvent::TIMEOUT:
-         timeout = true;
-         break;
-      default:
-         break;
-      }
+bool HttpSocket::recv(HttpRequest::Handle &handle)
+{
+   // Go on parsing any request partially parsed in advance
+   if (!_parsing)
+      _parser.reset(handle);
 
-      if (!_connUp || timeout)
-         break;
+   assert(_parser.getRequest() == handle);
+   _parsing = false;
 
-      ret = _socketHandle->recv(&c, 1);
+   if (_rxBuffer.empty())
+      _rxBuffer.resize(HTTPSRV_RX_BUF_SIZE);
 
-      if (ret > 0)
+   while (_connUp && _socketHandle && !_parser.isComplete())
+   {
+      // Consume first any data already received
+      if (_rxBegin < _rxEnd)
       {
-         line += c;
+         _rxBegin += _parser.feed(_rxBuffer.data() + _rxBegin, _rxEnd - _rxBegin);
+         continue;
       }
-      else if (ret <= 0)
+
+      std::chrono::milliseconds msec(getConnectionTimeout());
+
+      auto recvEv = _socketHandle->waitForRecvEvent(msec);
+
+      if (recvEv == TransportSocket::RecvEvent::RECV_ERROR)
       {
          _connUp = false;
          break;
       }
 
-      feed_crlf_fsm(c);
-
-      if (!receivingBody && crlf_st == CrLfSeq::LF2)
+      if (recvEv == TransportSocket::RecvEvent::TIMEOUT)
       {
-         if (line == "\r\n")
-            line.clear();
-
-         if (!handle->isExpected_100_Continue_Response())
-         {
-            receivingBody = handle->getBoundary().empty() || boundary_maker;
-         }
+         // An idle connection has expired, while a request partially
+         // received is never processed as if it were complete
+         if (_parser.isIdle())
+            _connUp = false;
          else
-            break;
+            _timedOut = true;
+
+         break;
       }
 
-      if ((crlf_st == CrLfSeq::LF1 || crlf_st == CrLfSeq::LF2) && !line.empty())
+      const int ret = _socketHandle->recv(_rxBuffer.data(), int(_rxBuffer.size()));
+
+      if (ret <= 0)
       {
-         if (!handle->getBoundary().empty())
-         {
-            const std::string boundary_begin = "--" + handle->getBoundary();
-            const std::string boundary_end = "--" + handle->getBoundary() + "--";
-
-            const std::string trimmedLine = StrUtils::trim(line);
-
-            if (!receivingBody && !boundary_maker && trimmedLine == boundary_begin)
-            {
-               boundary_maker = true;
-            }
-            else if (receivingBody && boundary_maker && trimmedLine == boundary_end)
-            {
-               receivingBody = false;
-               line.clear();
-            }
-         }
-
-         if (!line.empty())
-         {
-            if (!receivingBody)
-            {
-               handle->parseHeader(line);
-               handle->addLine(line);
-            }
-            else
-            {
-               body += line;
-            }
-
-            line.clear();
-         }
+         _connUp = false;
+         break;
       }
-   }
 
-   if (ret < 0 || !_socketHandle || handle->getHeaderList().empty())
-   {
-      return false;
+      _rxBegin = 0;
+      _rxEnd = size_t(ret);
    }
 
-   std::string request = *handle->getHeaderList().cbegin();
-   std::vector<std::string> tokens;
+   return _socketHandle && _parser.isComplete();
+}
 
-   if (!StrUtils::splitLineInTokens(request, tokens, " "))
-   {
-      return false;
-   }
+/* -------------------------------------------------------------------------- */
 
-   if (tokens.size() != 3)
-   {
-      return false;
-   }
+bool HttpSocket::queue(const HttpResponse &response, const char *fileName)
+{
+   // The response is referred by the queue, not copied
+   for (const auto slice : response.getSlices())
+      _txQueue.append(slice.data(), slice.size());
 
-   handle->parseMethod(tokens[0]);
-   handle->parseUri(tokens[1]);
-   handle->parseVersion(tokens[2]);
+   if (!fileName || !*fileName)
+      return true;
 
-   //in case the body is encapsulated in boundary markers a prior CRLF sequence
-   //that was already added to the body should be still considered part of the
-   //boundary marker itself rather than part of body. Such CRLF must be removed
-   if (boundary_maker && body.size() > 2)
-      body.resize(body.size() - 2);
+   uint64_t fileSize = 0;
+   const int fd = SysUtils::openFileForReading(fileName, fileSize);
 
-   if (!body.empty())
-      handle->setBody(std::move(body));
+   if (fd < 0)
+      return false;
 
+   _txQueue.appendFile(fd, 0, fileSize);
    return true;
 }
 
 /* -------------------------------------------------------------------------- */
 
-HttpSocket &HttpSocket::operator<<(const HttpResponse &response)
+bool HttpSocket::flush()
 {
-   const std::string &response_txt = response;
-   size_t to_send = response_txt.size();
-
-   while (to_send > 0)
+   if (!_connUp || !_socketHandle)
    {
-      int sent = _socketHandle->send(response);
-      
-      if (sent < 0)
-      {
-         _connUp = false;
-         break;
-      }
+      _txQueue.clear();
+      return false;
+   }
 
-      if (sent == 0)
-      {
-         // tx queue congested, wait for a while
-         std::this_thread::sleep_for(std::chrono::seconds(1));
-         continue;
-      }
+   SocketIoChannel channel(*_socketHandle);
 
-      to_send -= sent;
+   // The socket is blocking: each operation returns once it made
+   // some progress, so the queue is flushed by a single call
+   if (_txQueue.flush(channel) != IoChannel::Status::done)
+   {
+      _txQueue.clear();
+      _connUp = false;
+      return false;
    }
 
-   return *this;
+   return true;
 }
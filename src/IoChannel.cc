@@ -0,0 +1,74 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "IoChannel.h"
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+// Channels are driven by the thread of their event loop, so the receive
+// buffer can be shared by all the connections of the same loop
+thread_local char rxScratchBuffer[HTTPSRV_RX_BUF_SIZE];
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+IoChannel::Status SocketIoChannel::recv(const char *&data, size_t &size)
+{
+   const int ret = _socket.recv(rxScratchBuffer, int(sizeof(rxScratchBuffer)));
+
+   if (ret < 0)
+      return SysUtils::isWouldBlockSocketError() ? Status::wouldBlock : Status::failed;
+
+   if (ret == 0)
+      return Status::closed;
+
+   data = rxScratchBuffer;
+   size = size_t(ret);
+
+   return Status::done;
+}
+
+/* -------------------------------------------------------------------------- */
+
+IoChannel::Status SocketIoChannel::sendv(
+    const IoSlice *slices, size_t count, bool more, size_t &sent)
+{
+   const long ret = _socket.sendv(slices, count, more);
+
+   if (ret < 0)
+      return SysUtils::isWouldBlockSocketError() ? Status::wouldBlock : Status::failed;
+
+   sent = size_t(ret);
+
+   return Status::done;
+}
+
+/* -------------------------------------------------------------------------- */
+
+IoChannel::Status SocketIoChannel::sendFile(
+    int fd, uint64_t offset, size_t size, size_t &sent)
+{
+   const long ret = _socket.sendFile(fd, offset, size);
+
+   if (ret < 0)
+      return SysUtils::isWouldBlockSocketError() ? Status::wouldBlock : Status::failed;
+
+   // The file is shorter than expected
+   if (ret == 0)
+      return Status::failed;
+
+   sent = size_t(ret);
+
+   return Status::done;
+}
@@ -0,0 +1,264 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "IoUring.h"
+
+#ifdef HTTPSRV_IO_URING
+
+/* -------------------------------------------------------------------------- */
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <cstring>
+#include <new>
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+int sysIoUringSetup(unsigned entries, io_uring_params *params)
+{
+   return int(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sysIoUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+   return int(::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int sysIoUringRegister(int fd, unsigned opcode, void *arg, unsigned nrArgs)
+{
+   return int(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+template <typename T>
+T *ringPtr(void *ring, unsigned offset)
+{
+   return reinterpret_cast<T *>(static_cast<char *>(ring) + offset);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+IoUring::Handle IoUring::create(unsigned entries)
+{
+   Handle handle(new (std::nothrow) IoUring());
+
+   return handle && handle->init(entries) ? std::move(handle) : nullptr;
+}
+
+/* -------------------------------------------------------------------------- */
+
+IoUring::~IoUring()
+{
+   if (_sqes)
+      ::munmap(_sqes, _sqesSize);
+
+   if (_cqRing && _cqRing != _sqRing)
+      ::munmap(_cqRing, _cqRingSize);
+
+   if (_sqRing)
+      ::munmap(_sqRing, _sqRingSize);
+
+   if (_ringFd >= 0)
+      ::close(_ringFd);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool IoUring::init(unsigned entries)
+{
+   io_uring_params params;
+   memset(&params, 0, sizeof(params));
+
+   _ringFd = sysIoUringSetup(entries, &params);
+
+   // Not supported by the kernel or denied by a security policy
+   if (_ringFd < 0)
+      return false;
+
+   _features = params.features;
+
+   _sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+   _cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+   // Both rings can be mapped at once
+   if (_features & IORING_FEAT_SINGLE_MMAP)
+   {
+      if (_cqRingSize > _sqRingSize)
+         _sqRingSize = _cqRingSize;
+
+      _cqRingSize = _sqRingSize;
+   }
+
+   void *ptr = ::mmap(
+       nullptr, _sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+       _ringFd, IORING_OFF_SQ_RING);
+
+   if (ptr == MAP_FAILED)
+      return false;
+
+   _sqRing = ptr;
+
+   if (_features & IORING_FEAT_SINGLE_MMAP)
+   {
+      _cqRing = _sqRing;
+   }
+   else
+   {
+      ptr = ::mmap(
+          nullptr, _cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+          _ringFd, IORING_OFF_CQ_RING);
+
+      if (ptr == MAP_FAILED)
+         return false;
+
+      _cqRing = ptr;
+   }
+
+   _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+
+   ptr = ::mmap(
+       nullptr, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+       _ringFd, IORING_OFF_SQES);
+
+   if (ptr == MAP_FAILED)
+      return false;
+
+   _sqes = static_cast<io_uring_sqe *>(ptr);
+
+   _sqHead = ringPtr<unsigned>(_sqRing, params.sq_off.head);
+   _sqTail = ringPtr<unsigned>(_sqRing, params.sq_off.tail);
+   _sqMask = *ringPtr<unsigned>(_sqRing, params.sq_off.ring_mask);
+   _sqEntries = *ringPtr<unsigned>(_sqRing, params.sq_off.ring_entries);
+   _sqeTail = *_sqTail;
+
+   // Submission queue entries are always used in order, so the
+   // indirection array is set up once and for all
+   unsigned *sqArray = ringPtr<unsigned>(_sqRing, params.sq_off.array);
+
+   for (unsigned i = 0; i < _sqEntries; ++i)
+      sqArray[i] = i;
+
+   _cqHead = ringPtr<unsigned>(_cqRing, params.cq_off.head);
+   _cqTail = ringPtr<unsigned>(_cqRing, params.cq_off.tail);
+   _cqMask = *ringPtr<unsigned>(_cqRing, params.cq_off.ring_mask);
+   _cqes = ringPtr<io_uring_cqe>(_cqRing, params.cq_off.cqes);
+
+   probe();
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void IoUring::probe()
+{
+   enum { MAX_OPS = 256 };
+
+   const size_t size = sizeof(io_uring_probe) + MAX_OPS * sizeof(io_uring_probe_op);
+   std::unique_ptr<uint8_t[]> buffer(new (std::nothrow) uint8_t[size]);
+
+   if (!buffer)
+      return;
+
+   memset(buffer.get(), 0, size);
+
+   auto probe = reinterpret_cast<io_uring_probe *>(buffer.get());
+
+   // Probing is available since kernel 5.6: older kernels
+   // are reported as supporting no operation at all
+   if (sysIoUringRegister(_ringFd, IORING_REGISTER_PROBE, probe, MAX_OPS) < 0)
+      return;
+
+   _supportedOpsCount = probe->ops_len;
+   _supportedOps.reset(new (std::nothrow) uint8_t[_supportedOpsCount]);
+
+   if (!_supportedOps)
+   {
+      _supportedOpsCount = 0;
+      return;
+   }
+
+   for (unsigned i = 0; i < _supportedOpsCount; ++i)
+      _supportedOps[i] = (probe->ops[i].flags & IO_URING_OP_SUPPORTED) ? 1 : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool IoUring::isSupported(std::initializer_list<int> opcodes) const noexcept
+{
+   for (const int opcode : opcodes)
+   {
+      if (opcode < 0 || unsigned(opcode) >= _supportedOpsCount || !_supportedOps[opcode])
+         return false;
+   }
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool IoUring::registerBuffers(const iovec *iovecs, unsigned count) noexcept
+{
+   return 0 == sysIoUringRegister(
+      _ringFd, IORING_REGISTER_BUFFERS, const_cast<iovec *>(iovecs), count);
+}
+
+/* -------------------------------------------------------------------------- */
+
+unsigned IoUring::getSqSpaceLeft() const noexcept
+{
+   const unsigned head = __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE);
+
+   return _sqEntries - (_sqeTail - head);
+}
+
+/* -------------------------------------------------------------------------- */
+
+io_uring_sqe *IoUring::getSqe() noexcept
+{
+   if (getSqSpaceLeft() == 0)
+      return nullptr;
+
+   io_uring_sqe *sqe = &_sqes[_sqeTail & _sqMask];
+   ++_sqeTail;
+
+   memset(sqe, 0, sizeof(*sqe));
+
+   return sqe;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int IoUring::submit(unsigned waitCount) noexcept
+{
+   const unsigned toSubmit = _sqeTail - *_sqTail;
+
+   // Publish the new entries to the kernel
+   __atomic_store_n(_sqTail, _sqeTail, __ATOMIC_RELEASE);
+
+   if (toSubmit == 0 && waitCount == 0)
+      return 0;
+
+   const int ret = sysIoUringEnter(
+      _ringFd, toSubmit, waitCount, waitCount > 0 ? IORING_ENTER_GETEVENTS : 0);
+
+   return ret < 0 ? -errno : ret;
+}
+
+/* -------------------------------------------------------------------------- */
+
+#endif // HTTPSRV_IO_URING
@@ -0,0 +1,90 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "JsonWriter.h"
+#include "StrUtils.h"
+#include "SysUtils.h"
+
+#include <charconv>
+
+/* -------------------------------------------------------------------------- */
+
+void JsonWriter::beginValue(std::string_view name)
+{
+   const uint32_t bit = uint32_t(1) << _depth;
+
+   if (_notEmpty & bit)
+      _out.append(",\n", 2);
+
+   _notEmpty |= bit;
+
+   _out.append(2 * _depth, ' ');
+
+   if (!name.empty())
+   {
+      _out.push_back('"');
+      _out.append(name);
+      _out.append("\": ", 3);
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void JsonWriter::endValue(char bracket)
+{
+   assert(_depth > 0);
+   --_depth;
+
+   _out.push_back('\n');
+   _out.append(2 * _depth, ' ');
+   _out.push_back(bracket);
+
+   // The outermost value is over
+   if (_depth == 0)
+      _out.push_back('\n');
+}
+
+/* -------------------------------------------------------------------------- */
+
+void JsonWriter::value(std::string_view name, std::string_view str)
+{
+   beginValue(name);
+
+   _out.push_back('"');
+   StrUtils::escapeJson(str, _out);
+   _out.push_back('"');
+}
+
+/* -------------------------------------------------------------------------- */
+
+void JsonWriter::value(std::string_view name, uint64_t number)
+{
+   beginValue(name);
+
+   char digits[20];
+   const auto res = std::to_chars(digits, digits + sizeof(digits), number);
+   _out.append(digits, res.ptr);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void JsonWriter::timestamp(
+   std::string_view name, std::time_t t, unsigned microseconds)
+{
+   beginValue(name);
+
+   char buf[SysUtils::isoTimestampLength + 2];
+
+   buf[0] = '"';
+   SysUtils::formatIsoTimestamp(t, microseconds, buf + 1);
+   buf[sizeof(buf) - 1] = '"';
+
+   _out.append(buf, sizeof(buf));
+}
@@ -0,0 +1,134 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "LoadShedder.h"
+#include "HttpResponse.h"
+#include "JsonWriter.h"
+#include "SysUtils.h"
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+const char *const endpointNames[LoadShedder::endpointCount] = {
+   "files",
+   "file",
+   "filezip",
+   "mrufiles",
+   "mrufileszip",
+   "store",
+   "stats"
+};
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+LoadShedder::LoadShedder(const Limits &limits) : _limits(limits)
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+LoadShedder::Ticket LoadShedder::admit(
+   std::atomic<int> &inUse,
+   int limit,
+   std::atomic<uint64_t> &shed) noexcept
+{
+   const int count = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+
+   if (limit > 0 && count > limit)
+   {
+      inUse.fetch_sub(1, std::memory_order_relaxed);
+      shed.fetch_add(1, std::memory_order_relaxed);
+      return Ticket();
+   }
+
+   return Ticket(&inUse);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void LoadShedder::rejectConnection(const TcpSocket::Handle &handle) noexcept
+{
+   // The response is pre-serialized, so rejecting a connection costs
+   // a single gather operation. The socket has just been accepted,
+   // so its send buffer is empty: the response is written without
+   // blocking.
+   const auto slices = HttpResponse::getErrorSlices(503, SysUtils::getHttpDate());
+
+   IoSlice ioSlices[std::tuple_size<HttpResponse::Slices>::value];
+
+   for (size_t i = 0; i < slices.size(); ++i)
+      ioSlices[i] = {slices[i].data(), slices[i].size()};
+
+   handle->sendv(ioSlices, slices.size());
+   handle->shutdown();
+}
+
+/* -------------------------------------------------------------------------- */
+
+LoadShedder::Stats LoadShedder::getStats() const noexcept
+{
+   Stats stats;
+
+   stats.connections = _shedConnections.load(std::memory_order_relaxed);
+   stats.zipJobs = _shedZipJobs.load(std::memory_order_relaxed);
+
+   for (size_t i = 0; i < endpointCount; ++i)
+      stats.requests[i] = _shedRequests[i].load(std::memory_order_relaxed);
+
+   return stats;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void LoadShedder::jsonStats(JsonWriter &writer) const
+{
+   const Stats stats = getStats();
+
+   writer.beginObject("shed");
+
+   writer.value("connections", stats.connections);
+   writer.value("zipJobs", stats.zipJobs);
+
+   writer.beginObject("requests");
+
+   for (size_t i = 0; i < endpointCount; ++i)
+      writer.value(endpointNames[i], stats.requests[i]);
+
+   writer.endObject();
+   writer.endObject();
+}
+
+/* -------------------------------------------------------------------------- */
+
+const char *LoadShedder::getEndpointName(Endpoint endpoint) noexcept
+{
+   const size_t i = size_t(endpoint);
+   return i < endpointCount ? endpointNames[i] : "";
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool LoadShedder::findEndpoint(const std::string &name, Endpoint &endpoint) noexcept
+{
+   for (size_t i = 0; i < endpointCount; ++i)
+   {
+      if (name == endpointNames[i])
+      {
+         endpoint = Endpoint(i);
+         return true;
+      }
+   }
+
+   return false;
+}
@@ -0,0 +1,161 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "RequestArena.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+// Counters of all the arenas
+std::atomic<uint64_t> totalAllocations{0};
+std::atomic<uint64_t> totalHeapAllocations{0};
+std::atomic<uint64_t> totalResets{0};
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+RequestArena::~RequestArena()
+{
+   publishStats();
+   releaseBlocks();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void *RequestArena::do_allocate(size_t bytes, size_t alignment)
+{
+   ++_stats.allocations;
+
+   auto align = [alignment](char *p) {
+      const uintptr_t addr = reinterpret_cast<uintptr_t>(p);
+      return reinterpret_cast<char *>((addr + alignment - 1) & ~uintptr_t(alignment - 1));
+   };
+
+   char *p = _cursor ? align(_cursor) : nullptr;
+
+   if (!p || p + bytes > _end)
+   {
+      addBlock(bytes + alignment);
+      p = align(_cursor);
+   }
+
+   _cursor = p + bytes;
+
+   return p;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestArena::addBlock(size_t size)
+{
+   // Blocks grow geometrically, so a large content takes a few of them
+   const size_t lastSize = _blocks ? _blocks->size : _blockSize / 2;
+   size = std::max(size, lastSize * 2);
+
+   // Throws std::bad_alloc as expected by a memory resource
+   Block *block = static_cast<Block *>(::operator new(sizeof(Block) + size));
+   block->next = _blocks;
+   block->size = size;
+
+   ++_stats.heapAllocations;
+
+   _blocks = block;
+   _cursor = reinterpret_cast<char *>(block + 1);
+   _end = _cursor + size;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestArena::reset() noexcept
+{
+   ++_stats.resets;
+
+   if (_blocks && _blocks->next)
+   {
+      // Next batch is given a single block, as large as the ones
+      // used so far, unless it is too large to be retained
+      size_t size = 0;
+
+      for (Block *block = _blocks; block; block = block->next)
+         size += block->size;
+
+      releaseBlocks();
+
+      if (size <= _maxRetainedSize)
+      {
+         Block *block = static_cast<Block *>(
+            ::operator new(sizeof(Block) + size, std::nothrow));
+
+         if (block)
+         {
+            block->next = nullptr;
+            block->size = size;
+            _blocks = block;
+
+            ++_stats.heapAllocations;
+         }
+      }
+   }
+
+   _cursor = _blocks ? reinterpret_cast<char *>(_blocks + 1) : nullptr;
+   _end = _blocks ? _cursor + _blocks->size : nullptr;
+
+   publishStats();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestArena::releaseBlocks() noexcept
+{
+   while (_blocks)
+   {
+      Block *next = _blocks->next;
+      ::operator delete(_blocks);
+      _blocks = next;
+   }
+
+   _cursor = nullptr;
+   _end = nullptr;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestArena::publishStats() noexcept
+{
+   totalAllocations.fetch_add(
+      _stats.allocations - _published.allocations, std::memory_order_relaxed);
+
+   totalHeapAllocations.fetch_add(
+      _stats.heapAllocations - _published.heapAllocations, std::memory_order_relaxed);
+
+   totalResets.fetch_add(_stats.resets - _published.resets, std::memory_order_relaxed);
+
+   _published = _stats;
+}
+
+/* -------------------------------------------------------------------------- */
+
+RequestArena::Stats RequestArena::getTotalStats() noexcept
+{
+   Stats stats;
+
+   stats.allocations = totalAllocations.load(std::memory_order_relaxed);
+   stats.heapAllocations = totalHeapAllocations.load(std::memory_order_relaxed);
+   stats.resets = totalResets.load(std::memory_order_relaxed);
+
+   return stats;
+}
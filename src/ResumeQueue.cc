@@ -0,0 +1,110 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "ResumeQueue.h"
+
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef __linux__
+
+/* -------------------------------------------------------------------------- */
+
+ResumeQueue::~ResumeQueue()
+{
+   if (_fd >= 0)
+      ::close(_fd);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool ResumeQueue::init() noexcept
+{
+   // A blocking descriptor, as io_uring fails any read of a non-blocking
+   // one at once instead of waiting for the notification
+   _fd = ::eventfd(0, EFD_CLOEXEC);
+
+   return _fd >= 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ResumeQueue::push(const HttpSession::Handle &session)
+{
+   bool notify = false;
+
+   {
+      std::lock_guard<std::mutex> lock(_mtx);
+      notify = _sessions.empty();
+      _sessions.push_back(session);
+   }
+
+   if (notify)
+   {
+      const uint64_t one = 1;
+      const auto ret = ::write(_fd, &one, sizeof(one));
+      (void)ret; // The counter is already non-zero if it cannot be written
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ResumeQueue::clearNotification() noexcept
+{
+   uint64_t counter = 0;
+   const auto ret = ::read(_fd, &counter, sizeof(counter));
+   (void)ret;
+}
+
+/* -------------------------------------------------------------------------- */
+
+#else
+
+/* -------------------------------------------------------------------------- */
+// Other platforms
+
+/* -------------------------------------------------------------------------- */
+
+ResumeQueue::~ResumeQueue()
+{
+}
+
+bool ResumeQueue::init() noexcept
+{
+   return false;
+}
+
+void ResumeQueue::push(const HttpSession::Handle &session)
+{
+   std::lock_guard<std::mutex> lock(_mtx);
+   _sessions.push_back(session);
+}
+
+void ResumeQueue::clearNotification() noexcept
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+void ResumeQueue::take(std::vector<HttpSession::Handle> &sessions)
+{
+   sessions.clear();
+
+   std::lock_guard<std::mutex> lock(_mtx);
+   sessions.swap(_sessions);
+}
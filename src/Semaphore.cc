@@ -0,0 +1,93 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "Semaphore.h"
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef __linux__
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+long futex(std::atomic<uint32_t> &word, int op, uint32_t value) noexcept
+{
+   return ::syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word),
+      op, value, nullptr, nullptr, 0);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void Semaphore::post() noexcept
+{
+   _count.fetch_add(1, std::memory_order_release);
+   futex(_count, FUTEX_WAKE_PRIVATE, 1);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void Semaphore::wait() noexcept
+{
+   while (true)
+   {
+      uint32_t count = _count.load(std::memory_order_relaxed);
+
+      while (count > 0)
+      {
+         if (_count.compare_exchange_weak(
+                count, count - 1, std::memory_order_acquire))
+         {
+            return;
+         }
+      }
+
+      // Sleeps unless a unit has been released meanwhile
+      futex(_count, FUTEX_WAIT_PRIVATE, 0);
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+#else
+
+/* -------------------------------------------------------------------------- */
+
+void Semaphore::post() noexcept
+{
+   {
+      std::lock_guard<std::mutex> lock(_mtx);
+      ++_count;
+   }
+
+   _cv.notify_one();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void Semaphore::wait() noexcept
+{
+   std::unique_lock<std::mutex> lock(_mtx);
+   _cv.wait(lock, [this] { return _count > 0; });
+   --_count;
+}
+
+/* -------------------------------------------------------------------------- */
+
+#endif
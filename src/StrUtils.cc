@@ -10,15 +10,13 @@
 
 #include "StrUtils.h"
 
-#include <sstream>
-#include <iomanip>
-
 /* -------------------------------------------------------------------------- */
 
 void StrUtils::removeLastCharIf(std::string &s, char c)
 {
-   while (!s.empty() && s.c_str()[s.size() - 1] == c)
-      s = s.substr(0, s.size() - 1);
+   const size_t end = s.find_last_not_of(c);
+
+   s.resize(end == std::string::npos ? 0 : end + 1);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -30,23 +28,46 @@ bool StrUtils::splitLineInTokens(
    if (line.empty() || line.size() < sep.size())
       return false;
 
-   std::string subline = line;
+   for (const auto token : tokenize(line, sep))
+      tokens.emplace_back(token);
 
-   while (!subline.empty())
-   {
-      size_t pos = subline.find(sep);
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::string StrUtils::trim(const std::string &str)
+{
+   return std::string(trimView(str));
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::string_view StrUtils::trimView(std::string_view str) noexcept
+{
+   const auto strBegin = str.find_first_not_of(" \t\r\n");
+   if (strBegin == std::string_view::npos)
+      return std::string_view(); // no content
+
+   const auto strEnd = str.find_last_not_of(" \t\r\n");
 
-      if (pos == std::string::npos)
-      {
-         tokens.push_back(subline);
-         return true;
-      }
+   return str.substr(strBegin, strEnd - strBegin + 1);
+}
 
-      tokens.push_back(subline.substr(0, pos));
+/* -------------------------------------------------------------------------- */
 
-      size_t off = pos + sep.size();
+bool StrUtils::iequals(std::string_view a, std::string_view b) noexcept
+{
+   if (a.size() != b.size())
+      return false;
 
-      subline = subline.substr(off, subline.size() - off);
+   for (size_t i = 0; i < a.size(); ++i)
+   {
+      const char ca = a[i] >= 'a' && a[i] <= 'z' ? char(a[i] - 'a' + 'A') : a[i];
+      const char cb = b[i] >= 'a' && b[i] <= 'z' ? char(b[i] - 'a' + 'A') : b[i];
+
+      if (ca != cb)
+         return false;
    }
 
    return true;
@@ -54,46 +75,43 @@ bool StrUtils::splitLineInTokens(
 
 /* -------------------------------------------------------------------------- */
 
-std::string StrUtils::trim(const std::string &str)
+size_t StrUtils::makeJsonEscape(char ch, char *seq) noexcept
 {
-   const auto strBegin = str.find_first_not_of(" \t\r\n");
-   if (strBegin == std::string::npos)
-      return ""; // no content
+   seq[0] = '\\';
 
-   const auto strEnd = str.find_last_not_of(" \t\r\n");
-   const auto strRange = strEnd - strBegin + 1;
+   switch (ch)
+   {
+   case '\\': seq[1] = '\\'; return 2;
+   case '"': seq[1] = '"'; return 2;
+   case '\t': seq[1] = 't'; return 2;
+   case '\r': seq[1] = 'r'; return 2;
+   case '\b': seq[1] = 'b'; return 2;
+   case '\n': seq[1] = 'n'; return 2;
+   case '\f': seq[1] = 'f'; return 2;
+   default:
+      break;
+   }
+
+   // Any other control character
+   const char *hex = "0123456789abcdef";
 
-   return str.substr(strBegin, strRange);
+   seq[1] = 'u';
+   seq[2] = '0';
+   seq[3] = '0';
+   seq[4] = hex[(ch >> 4) & 0xf];
+   seq[5] = hex[ch & 0xf];
+
+   return 6;
 }
 
 /* -------------------------------------------------------------------------- */
 
 std::string StrUtils::escapeJson(const std::string& str) 
 {
-    std::ostringstream ss;
-
-    for (const auto & ch : str) 
-    {
-        switch (ch) {
-           case '\\': ss << "\\\\"; break;
-           case '"': ss << "\\\""; break;
-           case '\t': ss << "\\t"; break;
-           case '\r': ss << "\\r"; break;
-           case '\b': ss << "\\b"; break;
-           case '\n': ss << "\\n"; break;
-           case '\f': ss << "\\f"; break;
-           default:
-               if ('\x00' <= ch && ch <= '\x1f') 
-               {
-                   ss << "\\u"
-                     << std::hex << std::setw(4) 
-                     << std::setfill('0') << int(ch);
-               } 
-               else 
-               {
-                   ss << ch;
-               }
-        }
-    }
-    return ss.str();
-}
\ No newline at end of file
+   std::string escaped;
+   escaped.reserve(str.size());
+
+   escapeJson(str, escaped);
+
+   return escaped;
+}
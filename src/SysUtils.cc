@@ -13,6 +13,7 @@
 #include <sstream>
 #include <iomanip>
 #include <ctime>
+#include <cstring>
 
 
 /* -------------------------------------------------------------------------- */
@@ -46,6 +47,147 @@ void SysUtils::getUtcTime(std::string &retTime)
 
 /* -------------------------------------------------------------------------- */
 
+namespace
+{
+
+//! UTC calendar date and time of day
+struct CivilTime
+{
+   unsigned year;
+   unsigned month;     // 1..12
+   unsigned day;       // 1..31
+   unsigned dayOfWeek; // 0..6, from Thursday
+   unsigned hour;
+   unsigned minute;
+   unsigned second;
+};
+
+// Converts a time since the epoch without calling gmtime(), which is not
+// thread-safe, nor any function depending on the time zone or the locale
+CivilTime toCivilTime(std::time_t t) noexcept
+{
+   // Split the time into days since the epoch and seconds of the day,
+   // flooring for times before the epoch
+   int64_t days = int64_t(t) / 86400;
+   int64_t secs = int64_t(t) % 86400;
+
+   if (secs < 0)
+   {
+      secs += 86400;
+      --days;
+   }
+
+   // Civil date from days since the epoch (proleptic Gregorian calendar),
+   // computed on 400-year eras starting on March 1st
+   const int64_t z = days + 719468;
+   const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+   const unsigned doe = unsigned(z - era * 146097);
+   const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+   const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+   const unsigned mp = (5 * doy + 2) / 153;
+
+   CivilTime civil;
+
+   civil.day = doy - (153 * mp + 2) / 5 + 1;
+   civil.month = mp < 10 ? mp + 3 : mp - 9;
+   civil.year = unsigned(int64_t(yoe) + era * 400 + (civil.month <= 2)) % 10000;
+
+   // 1970-01-01 was a Thursday
+   civil.dayOfWeek = unsigned((days % 7 + 7) % 7);
+
+   civil.hour = unsigned(secs / 3600);
+   civil.minute = unsigned(secs / 60 % 60);
+   civil.second = unsigned(secs % 60);
+
+   return civil;
+}
+
+// Writes a number of two digits
+inline void put2(char *p, unsigned v) noexcept
+{
+   p[0] = char('0' + v / 10);
+   p[1] = char('0' + v % 10);
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+
+void SysUtils::formatHttpDate(std::time_t t, char *buf) noexcept
+{
+   static const char dayNames[] = "ThuFriSatSunMonTueWed";
+   static const char monthNames[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+   const CivilTime civil = toCivilTime(t);
+
+   char *p = buf;
+
+   std::memcpy(p, dayNames + civil.dayOfWeek * 3, 3);
+   p[3] = ',';
+   p[4] = ' ';
+   put2(p + 5, civil.day);
+   p[7] = ' ';
+   std::memcpy(p + 8, monthNames + (civil.month - 1) * 3, 3);
+   p[11] = ' ';
+   put2(p + 12, civil.year / 100);
+   put2(p + 14, civil.year % 100);
+   p[16] = ' ';
+   put2(p + 17, civil.hour);
+   p[19] = ':';
+   put2(p + 20, civil.minute);
+   p[22] = ':';
+   put2(p + 23, civil.second);
+   std::memcpy(p + 25, " GMT", 4);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void SysUtils::formatIsoTimestamp(
+   std::time_t t, unsigned microseconds, char *buf) noexcept
+{
+   const CivilTime civil = toCivilTime(t);
+
+   char *p = buf;
+
+   put2(p, civil.year / 100);
+   put2(p + 2, civil.year % 100);
+   p[4] = '-';
+   put2(p + 5, civil.month);
+   p[7] = '-';
+   put2(p + 8, civil.day);
+   p[10] = 'T';
+   put2(p + 11, civil.hour);
+   p[13] = ':';
+   put2(p + 14, civil.minute);
+   p[16] = ':';
+   put2(p + 17, civil.second);
+   p[19] = '.';
+   put2(p + 20, microseconds / 10000 % 100);
+   put2(p + 22, microseconds / 100 % 100);
+   put2(p + 24, microseconds % 100);
+   p[26] = 'Z';
+}
+
+/* -------------------------------------------------------------------------- */
+
+std::string_view SysUtils::getHttpDate() noexcept
+{
+   thread_local std::time_t cachedTime = -1;
+   thread_local char cachedDate[httpDateLength];
+
+   const std::time_t now = std::time(nullptr);
+
+   if (now != cachedTime)
+   {
+      formatHttpDate(now, cachedDate);
+      cachedTime = now;
+   }
+
+   return std::string_view(cachedDate, httpDateLength);
+}
+
+/* -------------------------------------------------------------------------- */
+
 #ifdef WIN32
 
 /* -------------------------------------------------------------------------- */
@@ -53,6 +195,9 @@ void SysUtils::getUtcTime(std::string &retTime)
 
 /* -------------------------------------------------------------------------- */
 
+#include <io.h>
+#include <fcntl.h>
+
 #pragma comment(lib, "Ws2_32.lib")
 
 /* -------------------------------------------------------------------------- */
@@ -75,9 +220,79 @@ int SysUtils::closeSocketFd(int sd)
 
 /* -------------------------------------------------------------------------- */
 
+bool SysUtils::setNonBlockingSocketFd(int sd, bool on)
+{
+   u_long mode = on ? 1 : 0;
+   return 0 == ::ioctlsocket(sd, FIONBIO, &mode);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool SysUtils::isWouldBlockSocketError()
+{
+   return ::WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool SysUtils::setThreadCpuAffinity(int cpu)
+{
+   if (cpu < 0 || cpu >= int(sizeof(DWORD_PTR) * 8))
+      return false;
+
+   return 0 != ::SetThreadAffinityMask(
+      ::GetCurrentThread(), DWORD_PTR(1) << cpu);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int SysUtils::openFileForReading(const char *path, uint64_t &size)
+{
+   const int fd = ::_open(path, _O_RDONLY | _O_BINARY);
+
+   if (fd < 0)
+      return -1;
+
+   const __int64 end = ::_lseeki64(fd, 0, SEEK_END);
+
+   if (end < 0)
+   {
+      ::_close(fd);
+      return -1;
+   }
+
+   size = uint64_t(end);
+
+   return fd;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int SysUtils::readFileAt(int fd, char *buf, size_t len, uint64_t offset)
+{
+   if (::_lseeki64(fd, __int64(offset), SEEK_SET) < 0)
+      return -1;
+
+   return ::_read(fd, buf, unsigned(len));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void SysUtils::closeFile(int fd)
+{
+   ::_close(fd);
+}
+
+/* -------------------------------------------------------------------------- */
+
 #else
 
 #include <signal.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/stat.h>
 
 /* -------------------------------------------------------------------------- */
 // Other C++ platform
@@ -101,4 +316,78 @@ int SysUtils::closeSocketFd(int sd)
 
 /* -------------------------------------------------------------------------- */
 
+bool SysUtils::setNonBlockingSocketFd(int sd, bool on)
+{
+   const int flags = ::fcntl(sd, F_GETFL, 0);
+
+   if (flags < 0)
+      return false;
+
+   return 0 == ::fcntl(sd, F_SETFL, on ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool SysUtils::isWouldBlockSocketError()
+{
+   return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool SysUtils::setThreadCpuAffinity(int cpu)
+{
+#ifdef __linux__
+   if (cpu < 0 || cpu >= CPU_SETSIZE)
+      return false;
+
+   cpu_set_t cpuSet;
+   CPU_ZERO(&cpuSet);
+   CPU_SET(cpu, &cpuSet);
+
+   return 0 == ::pthread_setaffinity_np(::pthread_self(), sizeof(cpuSet), &cpuSet);
+#else
+   (void)cpu;
+   return false;
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+
+int SysUtils::openFileForReading(const char *path, uint64_t &size)
+{
+   const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+
+   if (fd < 0)
+      return -1;
+
+   struct stat st;
+
+   if (::fstat(fd, &st) < 0)
+   {
+      ::close(fd);
+      return -1;
+   }
+
+   size = uint64_t(st.st_size);
+
+   return fd;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int SysUtils::readFileAt(int fd, char *buf, size_t len, uint64_t offset)
+{
+   return int(::pread(fd, buf, len, off_t(offset)));
+}
+
+/* -------------------------------------------------------------------------- */
+
+void SysUtils::closeFile(int fd)
+{
+   ::close(fd);
+}
+
+/* -------------------------------------------------------------------------- */
+
 #endif
@@ -25,6 +25,21 @@ TcpListener::TcpListener()
 
 /* -------------------------------------------------------------------------- */
 
+bool TcpListener::setReusePort(bool on)
+{
+#ifdef SO_REUSEPORT
+   const int optval = on ? 1 : 0;
+
+   return 0 == ::setsockopt(
+      getSocketFd(), SOL_SOCKET, SO_REUSEPORT, 
+      reinterpret_cast<const char *>(&optval), sizeof(optval));
+#else
+   return !on;
+#endif
+}
+
+/* -------------------------------------------------------------------------- */
+
 TcpSocket::Handle TcpListener::accept()
 {
    if (getStatus() != Status::VALID)
@@ -46,3 +61,29 @@ TcpSocket::Handle TcpListener::accept()
 
    return handle;
 }
+
+/* -------------------------------------------------------------------------- */
+
+TcpSocket::Handle TcpListener::attach(SocketFd sd)
+{
+   sockaddr remote_sockaddr = {0};
+
+   struct sockaddr *local_sockaddr = 
+      reinterpret_cast<struct sockaddr *>(&_local_ip_port_sa_in);
+
+   socklen_t sockaddrlen = sizeof(struct sockaddr);
+
+   if (::getpeername(sd, &remote_sockaddr, &sockaddrlen) < 0)
+   {
+      SysUtils::closeSocketFd(sd);
+      return TcpSocket::Handle();
+   }
+
+   TcpSocket::Handle handle(
+      new (std::nothrow) TcpSocket(sd, local_sockaddr, &remote_sockaddr));
+
+   if (!handle)
+      SysUtils::closeSocketFd(sd);
+
+   return handle;
+}
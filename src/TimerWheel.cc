@@ -0,0 +1,81 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "TimerWheel.h"
+
+#include <cassert>
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::Timer::cancel() noexcept
+{
+   if (!_pprev)
+      return;
+
+   *_pprev = _next;
+
+   if (_next)
+      _next->_pprev = _pprev;
+
+   _pprev = nullptr;
+   _next = nullptr;
+
+   assert(_wheel && _wheel->_pendingCount > 0);
+   --_wheel->_pendingCount;
+}
+
+/* -------------------------------------------------------------------------- */
+
+TimerWheel::TimerWheel(size_t slots, std::chrono::milliseconds tick)
+    :
+    _slots(std::max(slots, size_t(1)), nullptr),
+    _tick(std::max(tick, std::chrono::milliseconds(1))),
+    _origin(Clock::now())
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::start(Timer &timer, int id, std::chrono::milliseconds timeout) noexcept
+{
+   timer.cancel();
+
+   // Round up to the next tick, so that the timer never expires early
+   const uint64_t ticks = uint64_t((timeout.count() + _tick.count() - 1) / _tick.count());
+
+   timer._wheel = this;
+   timer._id = id;
+   timer._expiryTick = std::max(getTick(Clock::now()), _currentTick) + std::max(ticks, uint64_t(1));
+
+   Timer *&head = _slots[timer._expiryTick % _slots.size()];
+
+   timer._next = head;
+   timer._pprev = &head;
+
+   if (head)
+      head->_pprev = &timer._next;
+
+   head = &timer;
+
+   ++_pendingCount;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int TimerWheel::getWaitTimeout() const noexcept
+{
+   if (_pendingCount == 0)
+      return -1;
+
+   const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+       Clock::now() - _origin);
+
+   return int(_tick.count() - elapsed.count() % _tick.count());
+}
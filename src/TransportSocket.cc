@@ -9,15 +9,32 @@
 /* -------------------------------------------------------------------------- */
 
 #include "TransportSocket.h"
+#include "BufferPool.h"
 #include "StrUtils.h"
 #include "SysUtils.h"
 
+#include <algorithm>
 #include <thread>
 
+#ifndef WIN32
+#include <poll.h>
+#include <sys/uio.h>
+#endif
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <fcntl.h>
+#include <errno.h>
+#endif
+
 /* -------------------------------------------------------------------------- */
 
 TransportSocket::~TransportSocket()
 {
+#ifdef __linux__
+    closeSplicePipe();
+#endif
+
     if (isValid())
         SysUtils::closeSocketFd(getSocketFd());
 }
@@ -27,6 +44,7 @@ TransportSocket::~TransportSocket()
 TransportSocket::RecvEvent TransportSocket::waitForRecvEvent(
     const TransportSocket::TimeoutInterval &timeout)
 {
+#ifdef WIN32
     struct timeval tv_timeout = {0, 0};
     SysUtils::convertDurationInTimeval(timeout, tv_timeout);
 
@@ -37,6 +55,17 @@ TransportSocket::RecvEvent TransportSocket::waitForRecvEvent(
     FD_SET(getSocketFd(), &rd_mask);
 
     long nd = select(FD_SETSIZE, &rd_mask, (fd_set *)0, (fd_set *)0, &tv_timeout);
+#else
+    // Unlike select(), poll() is not limited to descriptors lower
+    // than FD_SETSIZE, as it happens with many open connections
+    pollfd pfd = {};
+    pfd.fd = getSocketFd();
+    pfd.events = POLLIN;
+
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(timeout);
+
+    long nd = ::poll(&pfd, 1, int(ms.count()));
+#endif
 
     if (nd == 0)
         return RecvEvent::TIMEOUT;
@@ -48,55 +77,222 @@ TransportSocket::RecvEvent TransportSocket::waitForRecvEvent(
 
 /* -------------------------------------------------------------------------- */
 
-int TransportSocket::sendFile(const std::string &filepath) noexcept
+long TransportSocket::sendv(const IoSlice *slices, size_t count, bool more) noexcept
 {
-    std::ifstream ifs(filepath.c_str(), std::ios::in | std::ios::binary);
+    count = std::min(count, size_t(HTTPSRV_IOV_MAX));
 
-    if (!ifs.is_open())
-        return -1;
+#ifdef WIN32
+    WSABUF buffers[HTTPSRV_IOV_MAX];
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        buffers[i].buf = const_cast<char *>(slices[i].data);
+        buffers[i].len = ULONG(slices[i].size);
+    }
+
+    (void)more;
 
-    std::unique_ptr<char[]> buffer(new char[TX_BUFFER_SIZE]);
+    DWORD sent = 0;
 
-    int sent_bytes = 0;
+    if (::WSASend(getSocketFd(), buffers, DWORD(count), &sent, 0, nullptr, nullptr) != 0)
+        return -1;
 
-    while (ifs.good())
+    return long(sent);
+#else
+    iovec iov[HTTPSRV_IOV_MAX];
+
+    for (size_t i = 0; i < count; ++i)
     {
-        ifs.read(buffer.get(), sizeof(buffer));
+        iov[i].iov_base = const_cast<char *>(slices[i].data);
+        iov[i].iov_len = slices[i].size;
+    }
 
-        int size = static_cast<int>(ifs.gcount());
+    msghdr msg = {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
 
-        if (size == 0)
-            return sent_bytes;
+    int flags = 0;
 
-        if (size > 0)
-        {
-            int bsent = 0;
+#ifdef MSG_MORE
+    // corks the socket for this call only: the data is sent along with
+    // the next send operation, e.g. a response header with the file content
+    if (more)
+        flags |= MSG_MORE;
+#else
+    (void)more;
+#endif
 
-            // sent the whole buffer content
-            while (bsent < size)
-            {
-                int txc = send(buffer.get(), size);
-                if (txc < 0)
-                    return -1;
+    return long(::sendmsg(getSocketFd(), &msg, flags));
+#endif
+}
 
-                if (txc == 0)
-                { // tx queue is congested ?
-                    std::this_thread::sleep_for(std::chrono::seconds(1));
-                    continue;
-                }
+/* -------------------------------------------------------------------------- */
 
-                bsent += txc;
-            }
+int TransportSocket::sendFile(const std::string &filepath) noexcept
+{
+    uint64_t fileSize = 0;
+    const int fd = SysUtils::openFileForReading(filepath.c_str(), fileSize);
 
-            sent_bytes += bsent;
-        }
-        else
+    if (fd < 0)
+        return -1;
+
+    uint64_t offset = 0;
+
+    // sent the whole file content
+    while (offset < fileSize)
+    {
+        const size_t count = size_t(std::min(
+            fileSize - offset, uint64_t(HTTPSRV_TX_BUF_SIZE)));
+
+        const long txc = sendFile(fd, offset, count);
+
+        if (txc < 0)
         {
+            SysUtils::closeFile(fd);
             return -1;
         }
+
+        // file truncated meanwhile
+        if (txc == 0)
+            break;
+    }
+
+    SysUtils::closeFile(fd);
+
+    return int(offset);
+}
+
+/* -------------------------------------------------------------------------- */
+
+long TransportSocket::sendFile(int fd, uint64_t &offset, size_t count) noexcept
+{
+    if (count == 0)
+        return 0;
+
+#ifdef __linux__
+    // sendfile() has already failed on this file, and the pipe may
+    // hold the next bytes of the region
+    if (fd == _splicePipe.fd && _splicePipe.readFd >= 0)
+        return spliceFile(fd, offset, count);
+
+    off_t off = off_t(offset);
+    long ret = long(::sendfile(getSocketFd(), fd, &off, count));
+
+    if (ret >= 0)
+    {
+        offset = uint64_t(off);
+        return ret;
     }
 
-    return sent_bytes;
+    // sendfile() does not support this kind of file
+    if (errno != EINVAL && errno != ENOSYS)
+        return -1;
+
+    ret = spliceFile(fd, offset, count);
+
+    if (ret >= 0 || (errno != EINVAL && errno != ENOSYS))
+        return ret;
+#endif
+
+    return sendFileBuffered(fd, offset, count);
+}
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef __linux__
+
+long TransportSocket::spliceFile(int fd, uint64_t &offset, size_t count) noexcept
+{
+    SplicePipe &pipe = _splicePipe;
+
+    // the bytes left in the pipe are not the ones requested (e.g. the
+    // previous region has been given up), so they are dropped along
+    // with the pipe
+    if (pipe.pending > 0 &&
+        (fd != pipe.fd || offset != pipe.offset || count < pipe.pending))
+    {
+        closeSplicePipe();
+    }
+
+    if (pipe.readFd < 0)
+    {
+        int pipeFds[2];
+
+        if (::pipe2(pipeFds, O_CLOEXEC) < 0)
+            return -1;
+
+        pipe.readFd = pipeFds[0];
+        pipe.writeFd = pipeFds[1];
+    }
+
+    // move a chunk of file into the pipe, once the previous one has
+    // been sent to the socket
+    if (pipe.pending == 0)
+    {
+        loff_t off = loff_t(offset);
+        const long ret = long(::splice(fd, &off, pipe.writeFd, nullptr,
+            std::min(count, size_t(HTTPSRV_FILE_CHUNK_SIZE)), SPLICE_F_MOVE));
+
+        if (ret <= 0)
+            return ret;
+
+        pipe.fd = fd;
+        pipe.offset = offset;
+        pipe.pending = size_t(ret);
+    }
+
+    // any byte left in the pipe is sent next time, without reading
+    // it again from the file
+    const long ret = long(::splice(pipe.readFd, nullptr, getSocketFd(), nullptr,
+        pipe.pending, SPLICE_F_MOVE));
+
+    if (ret > 0)
+    {
+        offset += uint64_t(ret);
+        pipe.offset = offset;
+        pipe.pending -= size_t(ret);
+    }
+
+    return ret;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TransportSocket::closeSplicePipe() noexcept
+{
+    if (_splicePipe.readFd >= 0)
+    {
+        ::close(_splicePipe.readFd);
+        ::close(_splicePipe.writeFd);
+    }
+
+    _splicePipe = SplicePipe();
+}
+
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+long TransportSocket::sendFileBuffered(int fd, uint64_t &offset, size_t count) noexcept
+{
+    BufferPool::Buffer buffer = BufferPool::getFileChunkPool().acquire();
+
+    if (!buffer)
+        return -1;
+
+    const int size = SysUtils::readFileAt(
+        fd, buffer.data(), std::min(count, buffer.size()), offset);
+
+    if (size <= 0)
+        return size;
+
+    // any byte read but not sent is read again from the file next time
+    const int txc = send(buffer.data(), size);
+
+    if (txc > 0)
+        offset += uint64_t(txc);
+
+    return txc;
 }
 
 /* -------------------------------------------------------------------------- */
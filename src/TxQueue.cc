@@ -0,0 +1,175 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "TxQueue.h"
+#include "SysUtils.h"
+
+#include <algorithm>
+
+/* -------------------------------------------------------------------------- */
+
+TxQueue::Segment &TxQueue::newSegment()
+{
+   if (!_segments)
+      _segments.emplace(_memory);
+
+   return _segments->emplace_back();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TxQueue::append(const char *data, size_t size)
+{
+   if (size == 0)
+      return;
+
+   Segment &segment = newSegment();
+   segment.data = data;
+   segment.size = size;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TxQueue::append(std::string &&data)
+{
+   if (data.empty())
+      return;
+
+   // Elements of a deque are never moved when adding or removing
+   // elements at its ends, so data keeps pointing into the buffer
+   Segment &segment = newSegment();
+   segment.buffer = std::move(data);
+   segment.data = segment.buffer.data();
+   segment.size = segment.buffer.size();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TxQueue::appendFile(int fd, uint64_t offset, uint64_t size)
+{
+   if (size == 0)
+   {
+      SysUtils::closeFile(fd);
+      return;
+   }
+
+   Segment &segment = newSegment();
+   segment.fd = fd;
+   segment.fileOffset = offset;
+   segment.fileSize = size;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TxQueue::clear()
+{
+   while (!isEmpty())
+      popFront();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TxQueue::release()
+{
+   clear();
+   _segments.reset();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TxQueue::popFront()
+{
+   if (_segments->front().fd >= 0)
+      SysUtils::closeFile(_segments->front().fd);
+
+   _segments->pop_front();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TxQueue::consume(size_t size)
+{
+   while (size > 0 && !isEmpty())
+   {
+      Segment &segment = _segments->front();
+
+      if (size < segment.size)
+      {
+         segment.data += size;
+         segment.size -= size;
+         return;
+      }
+
+      size -= segment.size;
+      popFront();
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+IoChannel::Status TxQueue::flush(IoChannel &channel)
+{
+   while (!isEmpty())
+   {
+      Segment &front = _segments->front();
+      IoChannel::Status status = IoChannel::Status::done;
+      size_t sent = 0;
+
+      if (front.fd >= 0)
+      {
+         status = channel.sendFile(
+            front.fd,
+            front.fileOffset,
+            size_t(std::min(front.fileSize, uint64_t(HTTPSRV_FILE_CHUNK_SIZE))),
+            sent);
+
+         if (status != IoChannel::Status::done)
+            return status;
+
+         front.fileOffset += sent;
+         front.fileSize -= sent;
+
+         if (front.fileSize == 0)
+            popFront();
+
+         continue;
+      }
+
+      // Gather the memory slices up to next file region
+      IoSlice slices[HTTPSRV_IOV_MAX];
+      size_t count = 0;
+      bool more = false;
+
+      for (const Segment &segment : *_segments)
+      {
+         if (segment.fd >= 0 || count == HTTPSRV_IOV_MAX)
+         {
+            more = true;
+            break;
+         }
+
+         slices[count].data = segment.data;
+         slices[count].size = segment.size;
+         ++count;
+      }
+
+      status = channel.sendv(slices, count, more, sent);
+
+      if (status != IoChannel::Status::done)
+         return status;
+
+      if (sent == 0)
+         return IoChannel::Status::failed;
+
+      consume(sent);
+   }
+
+   return IoChannel::Status::done;
+}
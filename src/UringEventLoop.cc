@@ -0,0 +1,958 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "UringEventLoop.h"
+#include "IoUring.h"
+
+#include <algorithm>
+#include <cassert>
+
+#ifdef HTTPSRV_IO_URING
+#include <errno.h>
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef HTTPSRV_IO_URING
+
+/* -------------------------------------------------------------------------- */
+
+namespace
+{
+
+// The operation kind is stored in the low bits of the user data of each
+// submission, the remaining bits hold the address of the issuing channel
+// (or the timeout kind, for timeout operations)
+enum : uint64_t
+{
+   TAG_RESUME = 0,
+   TAG_ACCEPT = 1,
+   TAG_TIMEOUT = 2,
+   TAG_PROVIDE_BUFFERS = 3,
+   TAG_RECV = 4,
+   TAG_SEND = 5,
+   TAG_FILE_READ = 6,
+   TAG_FILE_WRITE = 7,
+   TAG_MASK = 7,
+   TAG_BITS = 3
+};
+
+enum : uint64_t
+{
+   TIMEOUT_ACCEPT_RETRY = 0,
+   TIMEOUT_TICK = 1
+};
+
+enum : unsigned
+{
+   RECV_BUFFER_GROUP = 0
+};
+
+// Delay before accepting again after an accept failure
+__kernel_timespec acceptRetryDelay = {1, 0};
+
+// Resolution of the idle connection timers
+__kernel_timespec tickDelay = {
+   HTTPSRV_TIMER_WHEEL_TICK_MS / 1000, 
+   (HTTPSRV_TIMER_WHEEL_TICK_MS % 1000) * 1000000};
+
+bool isRingSupported(const IoUring &ring) noexcept
+{
+   return ring.isSupported({
+      IORING_OP_ACCEPT,
+      IORING_OP_RECV,
+      IORING_OP_SENDMSG,
+      IORING_OP_READ_FIXED,
+      IORING_OP_WRITE_FIXED,
+      IORING_OP_PROVIDE_BUFFERS,
+      IORING_OP_TIMEOUT,
+      IORING_OP_READ});
+}
+
+//! Returns a submission entry making sure that at least count
+//! entries are available, flushing the submission queue if needed
+io_uring_sqe *getSqe(IoUring &ring, unsigned count = 1) noexcept
+{
+   if (ring.getSqSpaceLeft() < count)
+      ring.submit();
+
+   return ring.getSqSpaceLeft() < count ? nullptr : ring.getSqe();
+}
+
+} // namespace
+
+/* -------------------------------------------------------------------------- */
+// UringEventLoop::Channel
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ * I/O channel backed by io_uring operations: each operation is submitted
+ * the first time the session asks for it, and its result is handed over
+ * when the session retries the operation after the completion
+ */
+class UringEventLoop::Channel : public IoChannel
+{
+public:
+   Channel(UringEventLoop &loop, int sd) noexcept
+       : _loop(loop), _sd(sd)
+   {
+   }
+
+   ~Channel() override;
+
+   Status recv(const char *&data, size_t &size) override;
+   Status sendv(const IoSlice *slices, size_t count, bool more, size_t &sent) override;
+   Status sendFile(int fd, uint64_t offset, size_t size, size_t &sent) override;
+
+   //! Records the outcome of a completed operation
+   void onCompletion(uint64_t tag, int res, uint32_t flags) noexcept;
+
+   //! Returns true if the kernel still refers to this channel
+   bool hasPendingOperations() const noexcept
+   {
+      return _pendingCount > 0;
+   }
+
+   int getSocketFd() const noexcept
+   {
+      return _sd;
+   }
+
+private:
+   enum class OpState
+   {
+      idle,
+      submitted,
+      completed
+   };
+
+   struct Op
+   {
+      OpState state = OpState::idle;
+      int res = 0;
+      uint32_t flags = 0;
+   };
+
+   UringEventLoop &_loop;
+   int _sd = -1;
+   unsigned _pendingCount = 0;
+
+   Op _recvOp;
+   Op _sendOp;
+   int _heldRecvBuffer = -1;
+
+   // The kernel reads the message descriptor of a send
+   // operation until it completes
+   iovec _sendIov[HTTPSRV_IOV_MAX];
+   msghdr _sendMsg = {};
+
+   // A file chunk is read and sent by two linked operations
+   OpState _fileOpState = OpState::idle;
+   unsigned _fileCompletions = 0;
+   int _fileReadRes = 0;
+   int _fileWriteRes = 0;
+   int _fixedBuffer = -1;
+
+   io_uring_sqe *prepare(uint64_t tag, unsigned count = 1) noexcept;
+   void releaseRecvBuffer();
+};
+
+/* -------------------------------------------------------------------------- */
+
+UringEventLoop::Channel::~Channel()
+{
+   releaseRecvBuffer();
+
+   // Give back a buffer selected by a receive never consumed
+   if (_recvOp.state == OpState::completed && (_recvOp.flags & IORING_CQE_F_BUFFER))
+      _loop.provideRecvBuffers(_recvOp.flags >> IORING_CQE_BUFFER_SHIFT, 1);
+
+   if (_fixedBuffer >= 0)
+      _loop.releaseFixedBuffer(_fixedBuffer);
+}
+
+/* -------------------------------------------------------------------------- */
+
+io_uring_sqe *UringEventLoop::Channel::prepare(uint64_t tag, unsigned count) noexcept
+{
+   io_uring_sqe *sqe = getSqe(*_loop._ring, count);
+
+   if (sqe)
+   {
+      sqe->user_data = uint64_t(uintptr_t(this)) | tag;
+      ++_pendingCount;
+   }
+
+   return sqe;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::Channel::releaseRecvBuffer()
+{
+   if (_heldRecvBuffer < 0)
+      return;
+
+   _loop.provideRecvBuffers(unsigned(_heldRecvBuffer), 1);
+   _heldRecvBuffer = -1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+IoChannel::Status UringEventLoop::Channel::recv(const char *&data, size_t &size)
+{
+   // Data handed out by previous call has been consumed
+   releaseRecvBuffer();
+
+   if (_recvOp.state == OpState::submitted)
+      return Status::wouldBlock;
+
+   if (_recvOp.state == OpState::completed)
+   {
+      _recvOp.state = OpState::idle;
+
+      const int res = _recvOp.res;
+      const bool hasBuffer = (_recvOp.flags & IORING_CQE_F_BUFFER) != 0;
+      const unsigned bufferId = _recvOp.flags >> IORING_CQE_BUFFER_SHIFT;
+
+      if (res > 0 && hasBuffer)
+      {
+         _heldRecvBuffer = int(bufferId);
+         data = _loop.getRecvBuffer(bufferId);
+         size = size_t(res);
+         return Status::done;
+      }
+
+      if (hasBuffer)
+         _loop.provideRecvBuffers(bufferId, 1);
+
+      if (res == 0)
+         return Status::closed;
+
+      if (res != -ENOBUFS)
+         return Status::failed;
+
+      _loop.waitForRecvBuffer(_sd);
+      return Status::wouldBlock;
+   }
+
+   io_uring_sqe *sqe = prepare(TAG_RECV);
+
+   if (!sqe)
+      return Status::failed;
+
+   // The kernel picks a buffer from the group once data is available
+   sqe->opcode = IORING_OP_RECV;
+   sqe->fd = _sd;
+   sqe->len = HTTPSRV_RX_BUF_SIZE;
+   sqe->flags = IOSQE_BUFFER_SELECT;
+   sqe->buf_group = RECV_BUFFER_GROUP;
+
+   _recvOp.state = OpState::submitted;
+
+   return Status::wouldBlock;
+}
+
+/* -------------------------------------------------------------------------- */
+
+IoChannel::Status UringEventLoop::Channel::sendv(
+    const IoSlice *slices, size_t count, bool more, size_t &sent)
+{
+   releaseRecvBuffer();
+
+   if (_sendOp.state == OpState::submitted)
+      return Status::wouldBlock;
+
+   if (_sendOp.state == OpState::completed)
+   {
+      _sendOp.state = OpState::idle;
+
+      if (_sendOp.res < 0)
+         return Status::failed;
+
+      sent = size_t(_sendOp.res);
+      return Status::done;
+   }
+
+   io_uring_sqe *sqe = prepare(TAG_SEND);
+
+   if (!sqe)
+      return Status::failed;
+
+   count = std::min(count, size_t(HTTPSRV_IOV_MAX));
+
+   for (size_t i = 0; i < count; ++i)
+   {
+      _sendIov[i].iov_base = const_cast<char *>(slices[i].data);
+      _sendIov[i].iov_len = slices[i].size;
+   }
+
+   _sendMsg = {};
+   _sendMsg.msg_iov = _sendIov;
+   _sendMsg.msg_iovlen = count;
+
+   // The session keeps the data unchanged until the operation completes
+   sqe->opcode = IORING_OP_SENDMSG;
+   sqe->fd = _sd;
+   sqe->addr = uint64_t(uintptr_t(&_sendMsg));
+   sqe->len = 1;
+   sqe->msg_flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
+
+   _sendOp.state = OpState::submitted;
+
+   return Status::wouldBlock;
+}
+
+/* -------------------------------------------------------------------------- */
+
+IoChannel::Status UringEventLoop::Channel::sendFile(
+    int fd, uint64_t offset, size_t size, size_t &sent)
+{
+   releaseRecvBuffer();
+
+   if (_fileOpState == OpState::submitted)
+      return Status::wouldBlock;
+
+   if (_fileOpState == OpState::completed)
+   {
+      _fileOpState = OpState::idle;
+
+      _loop.releaseFixedBuffer(_fixedBuffer);
+      _fixedBuffer = -1;
+
+      // A short read (e.g. the file has been truncated) cancels the write
+      if (_fileReadRes <= 0 || _fileWriteRes < 0)
+         return Status::failed;
+
+      sent = size_t(_fileWriteRes);
+      return Status::done;
+   }
+
+   _fixedBuffer = _loop.acquireFixedBuffer();
+
+   // All the registered buffers are in use: retry as soon as
+   // one of them is released
+   if (_fixedBuffer < 0)
+   {
+      _loop._fixedBufferWaiters.push_back(_sd);
+      return Status::wouldBlock;
+   }
+
+   const unsigned len = unsigned(std::min(size, size_t(HTTPSRV_FILE_CHUNK_SIZE)));
+   char *buffer = _loop.getFixedBuffer(_fixedBuffer);
+
+   // Both linked entries must be part of the same submission
+   io_uring_sqe *readSqe = prepare(TAG_FILE_READ, 2);
+
+   if (!readSqe)
+   {
+      _loop.releaseFixedBuffer(_fixedBuffer);
+      _fixedBuffer = -1;
+      return Status::failed;
+   }
+
+   readSqe->opcode = IORING_OP_READ_FIXED;
+   readSqe->fd = fd;
+   readSqe->addr = uint64_t(uintptr_t(buffer));
+   readSqe->len = len;
+   readSqe->off = offset;
+   readSqe->buf_index = uint16_t(_fixedBuffer);
+   readSqe->flags = IOSQE_IO_LINK;
+
+   io_uring_sqe *writeSqe = prepare(TAG_FILE_WRITE);
+   assert(writeSqe);
+
+   writeSqe->opcode = IORING_OP_WRITE_FIXED;
+   writeSqe->fd = _sd;
+   writeSqe->addr = uint64_t(uintptr_t(buffer));
+   writeSqe->len = len;
+   writeSqe->buf_index = uint16_t(_fixedBuffer);
+
+   _fileOpState = OpState::submitted;
+   _fileCompletions = 2;
+
+   return Status::wouldBlock;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::Channel::onCompletion(uint64_t tag, int res, uint32_t flags) noexcept
+{
+   assert(_pendingCount > 0);
+   --_pendingCount;
+
+   switch (tag)
+   {
+   case TAG_RECV:
+      _recvOp.state = OpState::completed;
+      _recvOp.res = res;
+      _recvOp.flags = flags;
+      break;
+
+   case TAG_SEND:
+      _sendOp.state = OpState::completed;
+      _sendOp.res = res;
+      _sendOp.flags = flags;
+      break;
+
+   case TAG_FILE_READ:
+   case TAG_FILE_WRITE:
+      (tag == TAG_FILE_READ ? _fileReadRes : _fileWriteRes) = res;
+
+      if (--_fileCompletions == 0)
+         _fileOpState = OpState::completed;
+      break;
+
+   default:
+      break;
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+// UringEventLoop
+
+/* -------------------------------------------------------------------------- */
+
+bool UringEventLoop::isSupported() noexcept
+{
+   IoUring::Handle ring = IoUring::create(8);
+
+   return ring && isRingSupported(*ring);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool UringEventLoop::init()
+{
+   _ring = IoUring::create(HTTPSRV_URING_ENTRIES);
+
+   if (!_ring || !isRingSupported(*_ring))
+      return false;
+
+   _recvBuffers.reset(new (std::nothrow) char[
+      size_t(HTTPSRV_URING_RECV_BUFFERS) * HTTPSRV_RX_BUF_SIZE]);
+
+   _fixedBuffers.reset(new (std::nothrow) char[
+      size_t(HTTPSRV_URING_FIXED_BUFFERS) * HTTPSRV_FILE_CHUNK_SIZE]);
+
+   if (!_recvBuffers || !_fixedBuffers)
+      return false;
+
+   std::vector<iovec> iovecs(HTTPSRV_URING_FIXED_BUFFERS);
+
+   for (int i = 0; i < HTTPSRV_URING_FIXED_BUFFERS; ++i)
+   {
+      iovecs[i].iov_base = getFixedBuffer(i);
+      iovecs[i].iov_len = HTTPSRV_FILE_CHUNK_SIZE;
+      _freeFixedBuffers.push_back(HTTPSRV_URING_FIXED_BUFFERS - 1 - i);
+   }
+
+   if (!_ring->registerBuffers(iovecs.data(), unsigned(iovecs.size())))
+      return false;
+
+   provideRecvBuffers(0, HTTPSRV_URING_RECV_BUFFERS);
+
+   return _resumeQueue.init();
+}
+
+/* -------------------------------------------------------------------------- */
+
+char *UringEventLoop::getRecvBuffer(unsigned bufferId) const noexcept
+{
+   return _recvBuffers.get() + size_t(bufferId) * HTTPSRV_RX_BUF_SIZE;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::provideRecvBuffers(unsigned firstBufferId, unsigned count)
+{
+   io_uring_sqe *sqe = getSqe(*_ring);
+
+   if (!sqe)
+   {
+      if (_verboseModeOn)
+      {
+         _logger << "UringEventLoop: cannot provide receive buffers" << std::endl;
+      }
+
+      return;
+   }
+
+   sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+   sqe->fd = int(count);
+   sqe->addr = uint64_t(uintptr_t(getRecvBuffer(firstBufferId)));
+   sqe->len = HTTPSRV_RX_BUF_SIZE;
+   sqe->off = firstBufferId;
+   sqe->buf_group = RECV_BUFFER_GROUP;
+   sqe->user_data = TAG_PROVIDE_BUFFERS;
+
+   _availableRecvBuffers += count;
+
+   // Buffers are provided before any later receive is submitted
+   for (unsigned i = 0; i < count && !_recvBufferWaiters.empty(); ++i)
+   {
+      _readyConnections.push_back(_recvBufferWaiters.front());
+      _recvBufferWaiters.pop_front();
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::waitForRecvBuffer(int sd)
+{
+   // Some buffers could have been given back since the kernel
+   // failed to select one: in such case retry at once
+   if (_availableRecvBuffers > 0)
+      _readyConnections.push_back(sd);
+   else
+      _recvBufferWaiters.push_back(sd);
+}
+
+/* -------------------------------------------------------------------------- */
+
+char *UringEventLoop::getFixedBuffer(int index) const noexcept
+{
+   return _fixedBuffers.get() + size_t(index) * HTTPSRV_FILE_CHUNK_SIZE;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int UringEventLoop::acquireFixedBuffer() noexcept
+{
+   if (_freeFixedBuffers.empty())
+      return -1;
+
+   const int index = _freeFixedBuffers.back();
+   _freeFixedBuffers.pop_back();
+
+   return index;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::releaseFixedBuffer(int index)
+{
+   _freeFixedBuffers.push_back(index);
+
+   if (!_fixedBufferWaiters.empty())
+   {
+      _readyConnections.push_back(_fixedBufferWaiters.front());
+      _fixedBufferWaiters.pop_front();
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::armAccept()
+{
+   io_uring_sqe *sqe = getSqe(*_ring);
+
+   if (!sqe)
+      return;
+
+   // A multishot accept keeps producing a completion for each new
+   // connection, until it is terminated by an error
+   sqe->opcode = IORING_OP_ACCEPT;
+   sqe->fd = _listener.getSocketFd();
+   sqe->accept_flags = SOCK_CLOEXEC;
+   sqe->user_data = TAG_ACCEPT;
+
+   if (_multishotAccept)
+      sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::armAcceptRetry()
+{
+   io_uring_sqe *sqe = getSqe(*_ring);
+
+   if (!sqe)
+      return;
+
+   sqe->opcode = IORING_OP_TIMEOUT;
+   sqe->addr = uint64_t(uintptr_t(&acceptRetryDelay));
+   sqe->len = 1;
+   sqe->user_data = TAG_TIMEOUT | (TIMEOUT_ACCEPT_RETRY << TAG_BITS);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::armTick()
+{
+   // The timer wheel is advanced on each loop iteration: while any timer
+   // is running the loop must wake up at least once per tick
+   if (_tickArmed || _timerWheel.getPendingCount() == 0)
+      return;
+
+   io_uring_sqe *sqe = getSqe(*_ring);
+
+   if (!sqe)
+      return;
+
+   sqe->opcode = IORING_OP_TIMEOUT;
+   sqe->addr = uint64_t(uintptr_t(&tickDelay));
+   sqe->len = 1;
+   sqe->user_data = TAG_TIMEOUT | (TIMEOUT_TICK << TAG_BITS);
+
+   _tickArmed = true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::armResume()
+{
+   io_uring_sqe *sqe = getSqe(*_ring);
+
+   if (!sqe)
+      return;
+
+   // Reading the eventfd consumes its notification
+   sqe->opcode = IORING_OP_READ;
+   sqe->fd = _resumeQueue.getFd();
+   sqe->addr = uint64_t(uintptr_t(&_resumeCounter));
+   sqe->len = sizeof(_resumeCounter);
+   sqe->user_data = TAG_RESUME;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::onAccept(int res, uint32_t flags)
+{
+   const bool rearm = !(flags & IORING_CQE_F_MORE);
+
+   if (res < 0)
+   {
+      // Kernels older than 5.19 reject multishot accepts
+      if (res == -EINVAL && _multishotAccept)
+      {
+         _multishotAccept = false;
+         armAccept();
+         return;
+      }
+
+      if (_verboseModeOn)
+      {
+         _logger << "UringEventLoop: accept is failing" << std::endl;
+      }
+
+      if (rearm)
+         armAcceptRetry();
+
+      return;
+   }
+
+   if (rearm)
+      armAccept();
+
+   const TcpSocket::Handle handle = _listener.attach(res);
+
+   if (!handle)
+      return;
+
+   LoadShedder::Ticket ticket;
+
+   if (_sessionConfig.loadShedder)
+   {
+      ticket = _sessionConfig.loadShedder->admitConnection();
+
+      // Too many connections: answer at once and close
+      if (!ticket)
+      {
+         if (_verboseModeOn)
+         {
+            _logger << "UringEventLoop: server is overloaded, connection rejected ("
+               << _sessionConfig.loadShedder->getStats().connections
+               << " so far)" << std::endl;
+         }
+
+         _sessionConfig.loadShedder->rejectConnection(handle);
+         return;
+      }
+   }
+
+   HttpSession::Handle sessionHandle = HttpSession::create(
+       _verboseModeOn,
+       _logger,
+       handle,
+       _fileRepository,
+       _sessionConfig,
+       std::move(ticket));
+
+   std::unique_ptr<Channel> channel(new (std::nothrow) Channel(*this, res));
+
+   if (!sessionHandle || !channel)
+      return;
+
+   sessionHandle->start(*channel, [this](const HttpSession::Handle &session) {
+      _resumeQueue.push(session);
+   });
+
+   Connection &connection = _connections[res];
+   connection.session = sessionHandle;
+   connection.channel = std::move(channel);
+
+   resume(res);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::resume(int sd)
+{
+   auto it = _connections.find(sd);
+
+   if (it == _connections.end())
+      return;
+
+   Connection &connection = it->second;
+
+   if (connection.closing)
+   {
+      // The connection can be released once the kernel has
+      // completed all the operations referring to it
+      if (!connection.channel->hasPendingOperations())
+         _connections.erase(it);
+
+      return;
+   }
+
+   if (!connection.session->onIoEvent())
+      closeConnection(it);
+   else if (connection.session->isRunningJob())
+      connection.idleTimer.cancel();
+   else
+      _timerWheel.start(connection.idleTimer, sd, connection.session->getIdleTimeout());
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::resumeSessions()
+{
+   _resumeQueue.take(_resumed);
+
+   for (const auto &session : _resumed)
+   {
+      const int sd = session->getTcpSocketHandle()->getSocketFd();
+      auto it = _connections.find(sd);
+
+      if (it != _connections.end() && it->second.session == session)
+         resume(sd);
+   }
+
+   _resumed.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::closeConnection(std::unordered_map<int, Connection>::iterator it)
+{
+   Connection &connection = it->second;
+
+   // The shutdown also completes any receive still pending
+   connection.session->terminate();
+   connection.closing = true;
+   connection.idleTimer.cancel();
+
+   // Releasing the session handle closes the socket
+   if (!connection.channel->hasPendingOperations())
+      _connections.erase(it);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::onIdleTimeout(int sd)
+{
+   auto it = _connections.find(sd);
+
+   if (it == _connections.end() || it->second.closing)
+      return;
+
+   if (_verboseModeOn)
+   {
+      _logger << "UringEventLoop: connection " << sd << " timed out" << std::endl;
+   }
+
+   closeConnection(it);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void UringEventLoop::onCompletion(uint64_t userData, int res, uint32_t flags)
+{
+   const uint64_t tag = userData & TAG_MASK;
+
+   switch (tag)
+   {
+   case TAG_RESUME:
+      if (res < 0 && res != -EINTR && res != -EAGAIN && _verboseModeOn)
+      {
+         _logger << "UringEventLoop: reading the resume queue is failing"
+                 << std::endl;
+      }
+
+      armResume();
+      resumeSessions();
+      break;
+
+   case TAG_ACCEPT:
+      onAccept(res, flags);
+      break;
+
+   case TAG_TIMEOUT:
+      if ((userData >> TAG_BITS) == TIMEOUT_TICK)
+         _tickArmed = false;
+      else
+         armAccept();
+      break;
+
+   case TAG_PROVIDE_BUFFERS:
+      if (res < 0 && _verboseModeOn)
+      {
+         _logger << "UringEventLoop: providing receive buffers is failing"
+                 << std::endl;
+      }
+      break;
+
+   default:
+   {
+      if (flags & IORING_CQE_F_BUFFER)
+         --_availableRecvBuffers;
+
+      auto channel = reinterpret_cast<Channel *>(uintptr_t(userData & ~TAG_MASK));
+      channel->onCompletion(tag, res, flags);
+      resume(channel->getSocketFd());
+      break;
+   }
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool UringEventLoop::run()
+{
+   armAccept();
+   armResume();
+
+   while (true)
+   {
+      // A single system call submits any operation queued while
+      // processing previous completions and waits for new ones
+      const int ret = _ring->submit(1);
+
+      if (ret < 0 && ret != -EINTR && ret != -EAGAIN && ret != -EBUSY)
+      {
+         if (_verboseModeOn)
+         {
+            _logger << "UringEventLoop::run() io_uring_enter is failing" << std::endl;
+         }
+
+         return false;
+      }
+
+      _ring->forEachCqe([this](const io_uring_cqe &cqe) {
+         onCompletion(cqe.user_data, cqe.res, cqe.flags);
+      });
+
+      // Resume the connections which were waiting for a buffer
+      while (!_readyConnections.empty())
+      {
+         std::vector<int> ready;
+         ready.swap(_readyConnections);
+
+         for (const int sd : ready)
+            resume(sd);
+      }
+
+      _timerWheel.expire([this](int sd) { onIdleTimeout(sd); });
+
+      armTick();
+   }
+
+   // Ok, following instruction won't be ever executed
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+#else
+
+/* -------------------------------------------------------------------------- */
+// Other platforms
+
+/* -------------------------------------------------------------------------- */
+
+class UringEventLoop::Channel
+{
+};
+
+bool UringEventLoop::isSupported() noexcept
+{
+   return false;
+}
+
+bool UringEventLoop::init()
+{
+   return false;
+}
+
+bool UringEventLoop::run()
+{
+   return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+UringEventLoop::UringEventLoop(
+    TcpListener &listener,
+    bool verboseModeOn,
+    std::ostream &loggerOStream,
+    FileRepository::Handle fileRepository,
+    const HttpSession::Config &sessionConfig)
+    :
+    _listener(listener),
+    _verboseModeOn(verboseModeOn),
+    _logger(loggerOStream),
+    _fileRepository(fileRepository),
+    _sessionConfig(sessionConfig),
+    _timerWheel(
+       HTTPSRV_TIMER_WHEEL_SLOTS, 
+       std::chrono::milliseconds(HTTPSRV_TIMER_WHEEL_TICK_MS))
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+UringEventLoop::~UringEventLoop()
+{
+   // Connections give their buffers back to the ring
+   _connections.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+
+UringEventLoop::Handle UringEventLoop::create(
+    TcpListener &listener,
+    bool verboseModeOn,
+    std::ostream &loggerOStream,
+    FileRepository::Handle fileRepository,
+    const HttpSession::Config &sessionConfig)
+{
+   Handle handle(new (std::nothrow) UringEventLoop(
+       listener, verboseModeOn, loggerOStream, fileRepository, sessionConfig));
+
+   assert(handle);
+
+   return handle && handle->init() ? std::move(handle) : nullptr;
+}
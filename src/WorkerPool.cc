@@ -0,0 +1,354 @@
+//
+// This file is part of httpsrv
+// Copyright (c) Antonino Calderone (antonino.calderone@gmail.com)
+// All rights reserved.
+// Licensed under the MIT License.
+// See COPYING file in the project root for full license information.
+//
+
+/* -------------------------------------------------------------------------- */
+
+#include "WorkerPool.h"
+
+#include <cassert>
+#include <thread>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+/* -------------------------------------------------------------------------- */
+
+WorkerPool::Handle WorkerPool::create(
+   int workers, int queueSize, RejectHandler onRejected)
+{
+   if (workers < 1 || queueSize < 1)
+      return nullptr;
+
+   Handle handle(new (std::nothrow) WorkerPool(queueSize, std::move(onRejected)));
+
+   assert(handle);
+
+   return handle && handle->start(workers) ? std::move(handle) : nullptr;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool WorkerPool::submit(HttpSession::Handle session)
+{
+   if (!_queue.push(std::move(session)))
+      return false;
+
+   // Either a worker about to sleep finds the session in the queue,
+   // or it is counted here as asleep (see runWorker())
+   std::atomic_thread_fence(std::memory_order_seq_cst);
+
+   if (_sleepingWorkers.load(std::memory_order_relaxed) > 0)
+      _wakeUp.post();
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+HttpSession::Handle WorkerPool::take()
+{
+   HttpSession::Handle session;
+
+   while (!_queue.pop(session))
+   {
+      _sleepingWorkers.fetch_add(1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      // A session submitted meanwhile is either found now, or its
+      // submitter wakes up a worker (maybe another one, in which case
+      // this one goes back to sleep)
+      const bool found = _queue.pop(session);
+
+      if (!found)
+         _wakeUp.wait();
+
+      _sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+
+      if (found)
+         break;
+   }
+
+   return session;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void WorkerPool::runWorker()
+{
+   // Without an idle poller, a worker waits for the requests of
+   // a session until it is over
+   const bool returnWhenIdle = _epollFd >= 0;
+
+   while (true)
+   {
+      HttpSession::Handle session = take();
+
+      // An event-driven session is submitted to run a blocking job,
+      // and resumed by its event loop afterwards
+      if (session->hasJob())
+      {
+         session->runJob();
+         continue;
+      }
+
+      if (session->serve(returnWhenIdle))
+         park(std::move(session));
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+#ifdef __linux__
+
+/* -------------------------------------------------------------------------- */
+
+WorkerPool::~WorkerPool()
+{
+   if (_epollFd >= 0)
+      ::close(_epollFd);
+
+   if (_wakeFd >= 0)
+      ::close(_wakeFd);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool WorkerPool::start(int workers)
+{
+   // If the idle poller cannot be set up (or it is not required), each
+   // worker serves a session until it is over
+   if (_onRejected)
+   {
+      _epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+      _wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+   }
+
+   epoll_event ev = {};
+   ev.events = EPOLLIN;
+   ev.data.fd = _wakeFd;
+
+   if (_epollFd >= 0 && 
+       (_wakeFd < 0 || 0 != ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, _wakeFd, &ev)))
+   {
+      ::close(_epollFd);
+      _epollFd = -1;
+   }
+
+   try
+   {
+      if (_epollFd >= 0)
+      {
+         std::thread pollerThread(&WorkerPool::runIdlePoller, this);
+         pollerThread.detach();
+      }
+
+      for (int i = 0; i < workers; ++i)
+      {
+         std::thread workerThread(&WorkerPool::runWorker, this);
+         workerThread.detach();
+      }
+   }
+   catch (...)
+   {
+      return false;
+   }
+
+   return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void WorkerPool::park(HttpSession::Handle session)
+{
+   {
+      std::lock_guard<std::mutex> lock(_parkedMtx);
+      _parked.push_back(std::move(session));
+   }
+
+   const uint64_t one = 1;
+   const auto ret = ::write(_wakeFd, &one, sizeof(one));
+   (void)ret; // The counter is already non-zero if it cannot be written
+}
+
+/* -------------------------------------------------------------------------- */
+
+void WorkerPool::watchParkedSessions()
+{
+   uint64_t counter = 0;
+   const auto ret = ::read(_wakeFd, &counter, sizeof(counter));
+   (void)ret;
+
+   {
+      std::lock_guard<std::mutex> lock(_parkedMtx);
+      _watched.swap(_parked);
+   }
+
+   for (auto &session : _watched)
+   {
+      const int sd = session->getTcpSocketHandle()->getSocketFd();
+
+      // One notification only: the session is given back to the workers
+      // as soon as the connection is readable (or hung up)
+      epoll_event ev = {};
+      ev.events = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+      ev.data.fd = sd;
+
+      if (0 != ::epoll_ctl(_epollFd, EPOLL_CTL_ADD, sd, &ev))
+      {
+         session->terminate();
+         continue;
+      }
+
+      IdleConnection &connection = addIdleConnection(sd);
+      connection.session = std::move(session);
+
+      _timerWheel.start(connection.idleTimer, sd, connection.session->getIdleTimeout());
+   }
+
+   _watched.clear();
+}
+
+/* -------------------------------------------------------------------------- */
+
+WorkerPool::IdleConnection &WorkerPool::addIdleConnection(int sd)
+{
+   if (_spareConnections.empty())
+      return _idleConnections[sd];
+
+   auto node = std::move(_spareConnections.back());
+   _spareConnections.pop_back();
+
+   node.key() = sd;
+   return _idleConnections.insert(std::move(node)).position->second;
+}
+
+/* -------------------------------------------------------------------------- */
+
+HttpSession::Handle WorkerPool::unwatch(int sd)
+{
+   auto it = _idleConnections.find(sd);
+
+   if (it == _idleConnections.end())
+      return nullptr;
+
+   ::epoll_ctl(_epollFd, EPOLL_CTL_DEL, sd, nullptr);
+
+   HttpSession::Handle session = std::move(it->second.session);
+   it->second.idleTimer.cancel();
+
+   _spareConnections.push_back(_idleConnections.extract(it));
+
+   return session;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void WorkerPool::runIdlePoller()
+{
+   epoll_event events[HTTPSRV_EPOLL_MAX_EVENTS];
+
+   while (true)
+   {
+      // Wake up in time to close the expired connections, if any
+      const int nfds = ::epoll_wait(
+         _epollFd, events, HTTPSRV_EPOLL_MAX_EVENTS, _timerWheel.getWaitTimeout());
+
+      if (nfds < 0 && errno != EINTR)
+         break;
+
+      for (int i = 0; i < nfds; ++i)
+      {
+         const int sd = events[i].data.fd;
+
+         if (sd == _wakeFd)
+         {
+            watchParkedSessions();
+            continue;
+         }
+
+         HttpSession::Handle session = unwatch(sd);
+
+         if (!session)
+            continue;
+
+         // Any error or hang-up condition is detected by the session
+         // itself while trying to read the socket
+         if (!submit(session))
+         {
+            if (_onRejected)
+               _onRejected(session);
+
+            session->terminate();
+         }
+      }
+
+      _timerWheel.expire([this](int sd) {
+         HttpSession::Handle session = unwatch(sd);
+
+         // Releasing the session handle closes the socket
+         if (session)
+            session->terminate();
+      });
+   }
+}
+
+/* -------------------------------------------------------------------------- */
+
+#else
+
+/* -------------------------------------------------------------------------- */
+// Other platforms
+
+/* -------------------------------------------------------------------------- */
+
+WorkerPool::~WorkerPool()
+{
+}
+
+bool WorkerPool::start(int workers)
+{
+   try
+   {
+      for (int i = 0; i < workers; ++i)
+      {
+         std::thread workerThread(&WorkerPool::runWorker, this);
+         workerThread.detach();
+      }
+   }
+   catch (...)
+   {
+      return false;
+   }
+
+   return true;
+}
+
+void WorkerPool::park(HttpSession::Handle)
+{
+}
+
+void WorkerPool::watchParkedSessions()
+{
+}
+
+HttpSession::Handle WorkerPool::unwatch(int)
+{
+   return nullptr;
+}
+
+void WorkerPool::runIdlePoller()
+{
+}
+
+/* -------------------------------------------------------------------------- */
+
+#endif
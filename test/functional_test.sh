@@ -11,6 +11,9 @@ if [ ! -z $1 ]; then
   host_and_port="$1"
 fi
 
+host=${host_and_port%:*}
+port=${host_and_port##*:}
+
 working_dir="$HOME/.httpsrv"
 
 # ------------------------------------------------------------------------------
@@ -51,6 +54,69 @@ success() {
   echo "[ ${GREEN}OK${NC} $timestamp] $1" >> $resultfile
 }
 
+# Sends data (escape sequences are expanded) on a new connection, saving
+# what the server sends back until it closes the connection. A server
+# rejecting a request may close (or reset) the connection before all the
+# data has been sent, so just getting an answer is checked.
+rawRequest() {
+  outputFile=$1
+  requestData=$2
+
+  # The data is written by a single write operation
+  printf '%b' "$requestData" > $tmp_dir/request.tmp
+
+  (
+    exec 3<>/dev/tcp/$host/$port || exit 1
+    cat $tmp_dir/request.tmp >&3 2>/dev/null
+    timeout 10 cat <&3 > $outputFile 2>/dev/null
+    [ -s $outputFile ]
+  )
+}
+
+# Sends a batch of requests for the same URI written at once on a single
+# connection (the last one closing it), and checks that each response
+# carries the same content as the one got by a request of its own
+checkPipelining() {
+  uriToSend=$1
+  requestCount=$2
+
+  ok=0
+  curl $host_and_port/$uriToSend > $tmp_dir/single.tmp && ok=1
+  eval "$jsonvalidator $tmp_dir/single.tmp" 2>/dev/null || ok=0
+  if [ $ok = "0" ]; then
+    fail "GET /$uriToSend: Can't get a valid JSON answer"
+  fi
+
+  requestData=""
+  rm -f $tmp_dir/expected.tmp
+
+  for i in `seq 1 $requestCount`; do
+    requestData+="GET /$uriToSend HTTP/1.1\r\nHost: $host\r\n"
+    [ $i = $requestCount ] && requestData+="Connection: close\r\n"
+    requestData+="\r\n"
+    cat $tmp_dir/single.tmp >> $tmp_dir/expected.tmp
+  done
+
+  ok=0
+  rawRequest $tmp_dir/pipelined.tmp "$requestData" && ok=1
+  if [ $ok = "0" ]; then
+    fail "GET /$uriToSend: pipelined requests not sent"
+  fi
+
+  responseCount=`grep -ac "^HTTP/1.1 200 OK" $tmp_dir/pipelined.tmp`
+
+  # Lines of status and headers end with CR, the ones of content do not
+  grep -av $'\r$' $tmp_dir/pipelined.tmp > $tmp_dir/content.tmp
+
+  ok=0
+  [ "$responseCount" = "$requestCount" ] && diff $tmp_dir/expected.tmp $tmp_dir/content.tmp && ok=1
+  if [ $ok = "0" ]; then
+    fail "GET /$uriToSend: unexpected responses to $requestCount pipelined requests"
+  fi
+
+  success "GET /$uriToSend: $requestCount pipelined requests answered in order"
+}
+
 
 # ------------------------------------------------------------------------------
 # Checks needed tools are there 
@@ -62,6 +128,7 @@ checkCommand "awk"
 checkCommand "unzip"
 checkCommand "sha256sum"
 checkCommand "diff"
+checkCommand "timeout"
 
 jsonvalidator="jsonlint-php"
 checkCommand $jsonvalidator
@@ -100,11 +167,18 @@ done
 
 rm -f $resultfile
 
+# ------------------------------------------------------------------------------
+# Pipelined requests, whose responses are sent together (on an empty
+# repository the content of each one is very short)
+# ------------------------------------------------------------------------------
+
+checkPipelining mrufiles 20
+
 # ------------------------------------------------------------------------------
 # Upload $NUMOFFILES files via http onto remote repository
 # ------------------------------------------------------------------------------
 
-listcontent=`find $tmp_dir -type f -name *.txt -exec curl -F file=@{} $host_and_port/store \;`
+listcontent=`find $tmp_dir -type f -name "*.txt" -exec curl -F file=@{} $host_and_port/store \;`
 
 echo $listcontent | sed -r "s/\}/\\n/g" > $listfile
 
@@ -256,6 +330,76 @@ function getRequest() {
 
 getRequest files
 getRequest mrufiles
+getRequest stats
+
+ok=0
+grep '"connections": ' $tmp_dir/stats.json && grep '"zipJobs": ' $tmp_dir/stats.json && \
+  grep '"mrufileszip": ' $tmp_dir/stats.json && ok=1
+if [ $ok = "0" ]; then
+  fail "GET /stats: shed counters missing"
+fi
+
+ok=0
+grep '"heapAllocations": ' $tmp_dir/stats.json && grep '"arenaAllocations": ' $tmp_dir/stats.json && ok=1
+if [ $ok = "0" ]; then
+  fail "GET /stats: memory counters missing"
+fi
+
+checkPipelining mrufiles 20
+
+# A request closing the connection ends the batch: any further request
+# pipelined after it is not answered
+ok=0
+rawRequest $tmp_dir/pipelined.tmp \
+  "GET /mrufiles HTTP/1.1\r\nHost: $host\r\n\r\nGET /mrufiles HTTP/1.1\r\nHost: $host\r\nConnection: close\r\n\r\nGET /mrufiles HTTP/1.1\r\nHost: $host\r\n\r\n" && ok=1
+
+responseCount=`grep -ac "^HTTP/1.1 200 OK" $tmp_dir/pipelined.tmp`
+
+if [ $ok = "0" ] || [ "$responseCount" != "2" ]; then
+  fail "GET /mrufiles: pipelined requests answered after Connection: close"
+fi
+
+success "GET /mrufiles: pipelined requests end at Connection: close"
+
+# ------------------------------------------------------------------------------
+# The listing is sent in chunks to an HTTP/1.1 client, while an HTTP/1.0
+# one gets the same content with its length
+# ------------------------------------------------------------------------------
+
+ok=0
+curl -D $tmp_dir/files11.hdr $host_and_port/files > $tmp_dir/files11.json && \
+  curl -0 -D $tmp_dir/files10.hdr $host_and_port/files > $tmp_dir/files10.json && ok=1
+if [ $ok = "0" ]; then
+  fail "GET /files: Can't get an answer"
+fi
+
+ok=0
+grep -i "^Transfer-Encoding: chunked" $tmp_dir/files11.hdr && \
+  grep -i "^Content-Length:" $tmp_dir/files10.hdr && \
+  diff $tmp_dir/files11.json $tmp_dir/files10.json && ok=1
+if [ $ok = "0" ]; then
+  fail "GET /files: the chunked listing differs from the one with Content-Length"
+fi
+
+ok=0
+curl --raw $host_and_port/files > $tmp_dir/files.raw && \
+  [ "`tail -c 5 $tmp_dir/files.raw | od -An -c | tr -d ' '`" = '0\r\n\r\n' ] && ok=1
+if [ $ok = "0" ]; then
+  fail "GET /files: the chunked listing does not end with the last chunk"
+fi
+
+# The connection is kept open after the last chunk
+ok=0
+rawRequest $tmp_dir/pipelined.tmp \
+  "GET /files HTTP/1.1\r\nHost: $host\r\n\r\nGET /mrufiles HTTP/1.1\r\nHost: $host\r\nConnection: close\r\n\r\n" && ok=1
+
+responseCount=`grep -ac "^HTTP/1.1 200 OK" $tmp_dir/pipelined.tmp`
+
+if [ $ok = "0" ] || [ "$responseCount" != "2" ]; then
+  fail "GET /files: no response to a request following the chunked listing"
+fi
+
+success "GET /files: listing sent in chunks"
 
 # ------------------------------------------------------------------------------
 # TIMESTAMP validations
@@ -359,6 +503,50 @@ fi
 success "POST store/$bigFileName: the 'big file' has been uploaded correctly"
 
 
+# ------------------------------------------------------------------------------
+# Chunked Body Test
+# ------------------------------------------------------------------------------
+
+chunkedFileName="chunkedFile.txt"
+
+cp -f $bigFileSrc $tmp_dir/$chunkedFileName
+
+chunkedfileid=`echo -n ${chunkedFileName} | sha256sum  | awk '{print $1}'`
+chunkedfilesize=`stat -c%s $tmp_dir/$chunkedFileName`
+
+ok=0
+cd $tmp_dir && curl -H "Transfer-Encoding: chunked" -F file=@${chunkedFileName} $host_and_port/store > $chunkedFileName.json && cd - && ok=1
+if [ $ok = "0" ]; then
+  fail "POST $chunkedFileName/store: Cannot transfer ${tmp_dir}/${chunkedFileName} in chunks"
+fi
+
+ok=0
+grep $chunkedfileid $tmp_dir/$chunkedFileName.json && grep "\"size\": $chunkedfilesize," $tmp_dir/$chunkedFileName.json && ok=1
+if [ $ok = "0" ]; then
+  fail "POST $chunkedFileName/store: Invalid response for ${tmp_dir}/${chunkedFileName}"
+fi
+
+ok=0
+rm -f $tmp_dir2/*
+curl --output $tmp_dir2/$chunkedfileid.zip $host_and_port/files/$chunkedfileid/zip && ok=1
+if [ $ok = "1" ]; then
+  ok=0
+  cd $tmp_dir2 && unzip $tmp_dir2/$chunkedfileid.zip && cd - && ok=1
+fi
+
+if [ $ok = "0" ]; then
+  fail "GET /files/$chunkedfileid/zip: Cannot download ${chunkedFileName}"
+fi
+
+ok=0
+diff $tmp_dir2/$chunkedFileName $tmp_dir/$chunkedFileName && ok=1
+if [ $ok = "0" ]; then
+  fail "POST $chunkedFileName/store: the content stored differs from the one sent in chunks"
+fi
+
+success "POST store/$chunkedFileName: the body sent in chunks has been stored correctly"
+
+
 # ------------------------------------------------------------------------------
 # Zero File Test
 # ------------------------------------------------------------------------------
@@ -432,6 +620,73 @@ sendWrongRequest files/InvalidID            "404 Not Found"
 sendWrongRequest files/invalidID/zip        "404 Not Found" 
 sendWrongRequest mrufiles/zip/thisIsInvalid "400 Bad Request"
 
+# Sends a raw request, which the server is expected to answer by a given
+# error before closing the connection
+sendRawWrongRequest() {
+  requestDescription=$1
+  requestData=$2
+  errorExpected=$3
+
+  ok=0
+  rawRequest $tmp_dir/err.html "$requestData" && ok=1
+  if [ $ok = "0" ]; then
+    fail "$requestDescription: Error in Server Response"
+  fi
+
+  ok=0
+  head -n 1 $tmp_dir/err.html | grep "$errorExpected" && ok=1
+  if [ $ok = "0" ]; then
+    fail "$requestDescription: Wrong error message detected"
+  fi
+
+  success "$requestDescription: expected HTTP error checked"
+}
+
+postHead="POST /store HTTP/1.1\r\nHost: $host\r\nContent-Type: multipart/form-data; boundary=xyz\r\n"
+
+sendRawWrongRequest "POST /store with a malformed chunked body" \
+  "${postHead}Transfer-Encoding: chunked\r\n\r\nzz\r\n--xyz--\r\n0\r\n\r\n" "400 Bad Request"
+
+sendRawWrongRequest "POST /store with an unsupported transfer coding" \
+  "${postHead}Transfer-Encoding: gzip\r\n\r\n" "400 Bad Request"
+
+# The body size is checked against the default limit (1 GiB) as soon as
+# its length is known, also beyond 32 bits
+sendRawWrongRequest "POST /store with a body of 3000000000 bytes" \
+  "${postHead}Content-Length: 3000000000\r\n\r\n" "413 Payload Too Large"
+
+sendRawWrongRequest "POST /store with a non numeric Content-Length" \
+  "${postHead}Content-Length: 12x\r\n\r\n" "400 Bad Request"
+
+sendRawWrongRequest "POST /store with an overflowing Content-Length" \
+  "${postHead}Content-Length: 99999999999999999999999\r\n\r\n" "400 Bad Request"
+
+# A field given more than once cannot frame the request in a way other
+# than its indexed value does
+sendRawWrongRequest "POST /store with Content-Length values which differ" \
+  "${postHead}Content-Length: 5\r\nContent-Length: 7\r\n\r\n--xyz" "400 Bad Request"
+
+sendRawWrongRequest "POST /store with a Content-Length differing beyond the limit" \
+  "${postHead}Content-Length: 3000000000\r\nContent-Length: 7\r\n\r\n--xyz--" "400 Bad Request"
+
+sendRawWrongRequest "POST /store with Transfer-Encoding split over two lines" \
+  "${postHead}Transfer-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n\r\n0\r\n\r\n" "400 Bad Request"
+
+# More header fields than the default limit (100)
+manyHeaders=""
+for i in `seq 1 120`; do
+  manyHeaders+="X-Field-$i: value\r\n"
+done
+
+sendRawWrongRequest "GET /files with 120 header fields" \
+  "GET /files HTTP/1.1\r\nHost: $host\r\n${manyHeaders}\r\n" "431 Request Header Fields Too Large"
+
+# A request head larger than the default limit (8 KiB)
+longValue=`printf 'x%.0s' $(seq 1 10000)`
+
+sendRawWrongRequest "GET /files with a 10 KiB header field" \
+  "GET /files HTTP/1.1\r\nHost: $host\r\nX-Long: $longValue\r\n\r\n" "431 Request Header Fields Too Large"
+
 
 # ------------------------------------------------------------------------------
 # Check if we are happy with puntuactors chars, and spaces, escapes, etc.